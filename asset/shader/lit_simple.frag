@@ -1,9 +1,11 @@
-#version 460
+#version 450
 
 in vec3 aFragPos;
 in vec3 aNormal;
+in float aTint;
 
-out vec4 oPixelColor;
+layout (location = 0) out vec4 oPixelColor;
+layout (location = 1) out uint oPixelValue;
 
 struct sLight {
   vec4 mPos;
@@ -46,5 +48,7 @@ void main() {
   vec3 specColor = mLight.mColor.xyz * specular * spec;
   
   vec3 result = ambColor + diffColor + specColor;
+  result = mix(result, result * vec3(0.4, 1.0, 0.6), aTint);
   oPixelColor = vec4(result.xyz, 1.0);
+  oPixelValue = 0u;
 }
\ No newline at end of file
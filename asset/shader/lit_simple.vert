@@ -1,10 +1,15 @@
-#version 460
+#version 450
 
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNrm;
+// xyz: position quantized within the tile bounds, w: octahedral normal, 8 bits per component
+layout (location = 0) in uvec4 aPacked;
+
+// Per tile, picked by the draw's base instance; the origin's w is the preview tint
+layout (location = 2) in vec4 aTileOrigin;
+layout (location = 3) in vec3 aTileScale;
 
 out vec3 aFragPos;
 out vec3 aNormal;
+out float aTint;
 
 layout (std140, binding=0) uniform uSharedData {
   mat4 mProj;
@@ -27,8 +32,22 @@ layout (std140, binding=1) uniform uLitSimpleData {
   vec4 mViewPos;
 };
 
+vec3 DecodeNormal(uint encoded) {
+  vec2 e = vec2(encoded & 0xFFu, encoded >> 8u) / 255.0 * 2.0 - 1.0;
+  vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+
+  if (n.z < 0.0) {
+    n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+  }
+
+  return normalize(n);
+}
+
 void main() {
+  vec3 aPos = aTileOrigin.xyz + vec3(aPacked.xyz) * aTileScale;
+
   gl_Position = mProj * mView * mModel * vec4(aPos.xyz, 1.0);
   aFragPos = (mModel * vec4(aPos.xyz, 1.0)).xyz;
-  aNormal = aNrm;
+  aNormal = DecodeNormal(aPacked.w);
+  aTint = aTileOrigin.w;
 }
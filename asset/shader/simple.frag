@@ -1,6 +1,7 @@
-#version 460
+#version 450
 
-out vec4 oPixelColor;
+layout (location = 0) out vec4 oPixelColor;
+layout (location = 1) out uint oPixelValue;
 
 layout (std140, binding=0) uniform uSharedData {
   mat4 mProj;
@@ -9,7 +10,9 @@ layout (std140, binding=0) uniform uSharedData {
 };
 
 uniform vec4 uBaseColor = vec4(0.0, 0.0, 0.0, 1.0);
+uniform uint uObjectId = 0;
 
 void main() {
   oPixelColor = uBaseColor;
+  oPixelValue = uObjectId;
 }
\ No newline at end of file
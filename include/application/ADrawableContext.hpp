@@ -8,9 +8,18 @@ struct CDrawable;
 class ADrawableContext {
 	shared_vector<CDrawable> mDrawables;
 
+	// The one place that knows how to get triangles out of a CDrawable.
+	static bool AppendDrawableTriangles(const CDrawable& drawable, std::vector<float>& vertices, std::vector<int32_t>& indices);
+
 public:
 	ADrawableContext();
 	~ADrawableContext();
 
 	void LoadDrawable(std::filesystem::path filePath);
+
+	uint32_t GetDrawableCount() const { return uint32_t(mDrawables.size()); }
+
+	// Appends the loaded drawables' triangles as xyz vertices and indices into them. Returns how many
+	// drawables contributed geometry.
+	uint32_t CollectTriangles(std::vector<float>& vertices, std::vector<int32_t>& indices) const;
 };
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+
+struct GLFWwindow;
+
+enum EInvalidateReason : uint32_t {
+	INVALIDATE_NONE       = 0x00,
+	INVALIDATE_CAMERA     = 0x01,
+	INVALIDATE_INPUT      = 0x02,
+	INVALIDATE_DATA       = 0x04,
+	INVALIDATE_ASYNC_LOAD = 0x08,
+	INVALIDATE_RESIZE     = 0x10,
+
+	INVALIDATE_ALL        = 0xFF
+};
+
+// Decides when the application actually needs to produce a frame. Anything that changes what the
+// viewport shows calls Invalidate(); when nothing is pending the main loop blocks on the OS event
+// queue and the viewport keeps showing its last rendered image.
+namespace AFrameScheduler {
+	void Init(GLFWwindow* window);
+
+	// Marks the given reasons as dirty. Safe to call from any thread; calls from worker threads wake the main loop.
+	void Invalidate(uint32_t reasons);
+
+	// Replaces glfwPollEvents in the main loop. Blocks until an event arrives if the scheduler is idle.
+	void WaitForEvents();
+
+	// Returns true (and clears the scene-relevant reasons) if the viewport needs to be re-rendered this frame.
+	bool ConsumeSceneInvalidation();
+
+	// Must be called once at the end of every executed frame.
+	void FrameCompleted();
+
+	// Keeps the first frame after an idle wait from being treated as one very long frame.
+	float ClampDeltaTime(float deltaTime);
+
+	bool IsIdle();
+}
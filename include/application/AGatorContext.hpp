@@ -4,12 +4,17 @@
 
 class UViewport;
 class ANavContext;
+class ANavStreamer;
+class ANavGenerator;
 class ATrackContext;
 class ADrawableContext;
 
 class AGatorContext {
     glm::vec2 mAppPosition;
     bool bIsDockingConfigured;
+    bool bShowGPUTimings;
+    bool bShowNavHoverInfo;
+    bool bShowNavGenerator;
 
     uint32_t mMainDockSpaceID;
     uint32_t mDockNodeTopID;
@@ -23,6 +28,8 @@ class AGatorContext {
     std::shared_ptr<UViewport> mMainViewport;
 
     std::shared_ptr<ANavContext> mNavContext;
+    std::shared_ptr<ANavStreamer> mNavStreamer;
+    std::shared_ptr<ANavGenerator> mNavGenerator;
     std::shared_ptr<ATrackContext> mTrackContext;
     std::shared_ptr< ADrawableContext> mDrawableContext;
 
@@ -32,6 +39,9 @@ class AGatorContext {
 
     void SaveTracksAsCB();
 
+    void StreamDirectoryCB();
+    void OpenDirectoryCB();
+
     void OpenFile(std::filesystem::path filePath);
 
 public:
@@ -43,10 +53,19 @@ public:
 
     void SetAppPosition(const int xPos, const int yPos);
 
+    std::shared_ptr<UViewport> GetMainViewport() { return mMainViewport; }
+
     void Update(float deltaTime);
     void Render(float deltaTime);
     void PostRender(float deltaTime);
 
     void OnGLInitialized();
-    void OnFileDropped(std::filesystem::path filePath);
+    void OnFilesDropped(const std::vector<std::filesystem::path>& paths);
+
+    // Opens everything at once. Directories are expanded to the navmeshes in them, and all navmeshes
+    // are queued together so they parse in parallel and share one progress bar.
+    void OpenFiles(const std::vector<std::filesystem::path>& paths);
+
+    // Blocks until files opened so far are fully loaded. Used where there's no frame loop to pump uploads.
+    void FinishPendingLoads();
 };
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "types.h"
+#include "application/AApplication.hpp"
+
+
+class AGatorContext;
+
+struct AHeadlessSettings {
+	std::vector<std::filesystem::path> mScenePaths;
+	// Text file with one "eye.x eye.y eye.z center.x center.y center.z" keyframe per line.
+	// If empty, the camera orbits the origin.
+	std::filesystem::path mCameraPathFile;
+
+	std::filesystem::path mStatsPath;
+	std::filesystem::path mImageDir;
+
+	uint32_t mFrameCount = 300;
+	uint32_t mWarmupFrames = 5;
+	uint32_t mWidth = 1280;
+	uint32_t mHeight = 720;
+
+	// Why the arguments were rejected, if they were.
+	std::string mArgsError;
+
+	static constexpr const char* USAGE = "Usage: navigator --headless [--frames N] [--warmup N] [--size WxH] [--camera FILE]"
+		" [--stats FILE] [--dump-images DIR] <file>...";
+
+	// Returns false if argv doesn't ask for headless mode. Unknown options and bad values only count as
+	// errors once it does, since the other modes share argv.
+	bool ParseArgs(int argc, char* argv[]);
+};
+
+struct AHeadlessCameraKey {
+	glm::vec3 mEye;
+	glm::vec3 mCenter;
+};
+
+// Renders the scene into the main viewport's framebuffer without a window, using an EGL surfaceless
+// (or pbuffer) context. Works on Mesa's llvmpipe, so render performance can be measured on CI machines.
+class AHeadlessApplication : public AApplication {
+	AHeadlessSettings mSettings;
+
+	void* mDisplay;
+	void* mEGLContext;
+	void* mSurface;
+
+	AGatorContext* mContext;
+
+	std::vector<AHeadlessCameraKey> mCameraPath;
+	uint32_t mFrameIndex;
+
+	std::vector<float> mCPUFrameTimes;
+	std::vector<float> mTotalFrameTimes;
+
+	bool CreateGLContext();
+	void DestroyGLContext();
+
+	void LoadCameraPath();
+	AHeadlessCameraKey GetCameraForFrame(uint32_t frame) const;
+
+	void DumpImage(uint32_t frame);
+	void WriteStats();
+
+	virtual bool Execute(float deltaTime) override;
+
+public:
+	AHeadlessApplication(const AHeadlessSettings& settings);
+	virtual ~AHeadlessApplication() {}
+
+	virtual bool Setup() override;
+	virtual bool Teardown() override;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "types.h"
+
+enum class ENavBenchmarkMode {
+    None,
+    // Rasterization paths on .ynv files.
+    Rasterization,
+    // The whole Recast pipeline on the built-in synthetic scenes, checked against golden hashes.
+    Scenes
+};
+
+struct ANavBenchmarkSettings {
+    ENavBenchmarkMode mMode = ENavBenchmarkMode::None;
+
+    // .ynv files whose triangles are rasterized, or the names of the scenes to run (all of them if empty).
+    std::vector<std::filesystem::path> mScenePaths;
+
+    uint32_t mIterations = 5;
+    // Rasterization only; the scenes use a fixed config so their hashes stay comparable.
+    float mCellSize = 0.3f;
+    float mCellHeight = 0.2f;
+    // Job system workers for Recast's parallel steps; 0 picks one less than the hardware threads.
+    uint32_t mThreadCount = 0;
+
+    // Empty uses asset/navbench/golden.txt next to the executable.
+    std::filesystem::path mGoldenPath;
+    // Rewrites the golden file from this run instead of checking against it. Needs an explicit mGoldenPath,
+    // since the copy next to the executable is overwritten by the next build.
+    bool bUpdateGolden = false;
+    // Stage timings and hashes as JSON, if set.
+    std::filesystem::path mReportPath;
+
+    // Why the arguments were rejected, if they were. Run() prints it with the usage and fails.
+    std::string mArgsError;
+
+    // Returns false if argv doesn't ask for a benchmark. Unknown options and bad values only count as
+    // errors once it does, since the other modes share argv.
+    bool ParseArgs(int argc, char* argv[]);
+};
+
+// Command line benchmarks of the nav build pipeline, without opening a window.
+namespace ANavBenchmark {
+    // Runs whichever benchmark the settings ask for. Returns the process exit code.
+    int Run(const ANavBenchmarkSettings& settings);
+
+    // Rasterizes every scene with each Recast rasterization path the CPU supports, checks the spans
+    // against the scalar path and prints the best time of each.
+    int RunRasterization(const ANavBenchmarkSettings& settings);
+
+    // Builds each synthetic scene (terrain, stairs, overhangs, clutter, plains) through the full Recast
+    // pipeline and checks hashes of the compact heightfield, region ids, contours and poly mesh against
+    // the golden file. The first iteration runs Recast's parallel steps serially, so a parallel step that
+    // changes the output shows up as a mismatch too. Its total is printed on its own; the stage averages
+    // cover the remaining, parallel iterations.
+    int RunScenes(const ANavBenchmarkSettings& settings);
+}
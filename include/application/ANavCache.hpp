@@ -0,0 +1,22 @@
+#pragma once
+
+#include "types.h"
+
+struct ANavmeshGeometry;
+class UStagingBuffer;
+
+// On-disk cache of navmeshes that have already been through librdr3, stored render-ready: the arena's
+// packed vertices and indices, bounds and the serialized BVH. Blobs are keyed by a hash of the .ynv's
+// contents, so a hit costs one mapping and a copy into the staging buffer.
+namespace ANavCache {
+    // Bump whenever the packed vertex format or the BVH layout changes.
+    constexpr uint32_t VERSION = 1;
+
+    std::filesystem::path GetBlobPath(uint64_t contentHash);
+
+    // Fills in the geometry's counts, bounds, packed data (in staging if there's room) and BVH. The
+    // geometry is untouched if the blob is missing, stale or damaged.
+    bool Read(const std::filesystem::path& blobPath, uint64_t contentHash, ANavmeshGeometry& geometry, UStagingBuffer& staging);
+    // packed is the geometry's data as produced by ANavmeshArena::PackGeometry.
+    bool Write(const std::filesystem::path& blobPath, uint64_t contentHash, const ANavmeshGeometry& geometry, const uint8_t* packed);
+}
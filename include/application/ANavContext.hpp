@@ -2,34 +2,151 @@
 
 #include "types.h"
 #include "application/ACamera.hpp"
+#include "application/ANavmeshArena.hpp"
+#include "nav/UHeightGrid.hpp"
+#include "nav/UNavBVH.hpp"
+#include "util/stagingbuffer.hpp"
 
 #include <librdr3.hpp>
 
-struct ANavmeshRenderData {
-    uint32_t mNavIndexCount;
-    uint32_t mNavVBO, mNavIBO, mNavVAO;
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
-    void CreateNavResources(std::shared_ptr<CNavmeshData> data);
-    void DeleteNavResources();
+// Navmesh geometry built on a worker thread and uploaded on the main thread.
+struct ANavmeshGeometry {
+    std::filesystem::path mPath;
+    bool bFailed = false;
+    // Cancelled before the job got to it, so nothing was parsed.
+    bool bSkipped = false;
 
-    ANavmeshRenderData();
-    ~ANavmeshRenderData();
+    // Packed vertices followed by the indices (see ANavmeshArena::PackGeometry), written straight
+    // into the staging buffer.
+    UStagingBuffer::UAllocation mStaging;
 
-    void Render();
+    // Fallback for when the staging buffer had no room.
+    std::unique_ptr<uint8_t[]> mPacked;
+
+    uint32_t mVertexCount = 0;
+    uint32_t mIndexCount = 0;
+
+    glm::vec3 mBoundsMin = glm::vec3(0.0f);
+    glm::vec3 mBoundsMax = glm::vec3(0.0f);
+
+    std::shared_ptr<UNav::UNavBVH> mBVH;
+    // Null if height grids are turned off.
+    std::shared_ptr<UNav::UHeightGrid> mHeightGrid;
+};
+
+// A loaded navmesh: its slice of the render arena, plus the BVH and height grid for CPU-side queries.
+struct ANavmesh {
+    ANavmeshTile mTile;
+    std::shared_ptr<UNav::UNavBVH> mBVH;
+    std::shared_ptr<const UNav::UHeightGrid> mHeightGrid;
+};
+
+// State shared between the context and its in-flight load jobs.
+struct ANavLoadQueue {
+    std::mutex mMutex;
+    std::deque<std::unique_ptr<ANavmeshGeometry>> mReady;
+
+    std::shared_ptr<UStagingBuffer> mStaging;
+
+    // Loads that were cancelled while in flight, by generic path. Jobs that haven't started yet skip
+    // the parse; anything that does finish gets dropped on the main thread. Guarded by mMutex.
+    std::unordered_set<std::string> mCancelled;
+
+    std::atomic<uint32_t> mParsed = 0;
+    std::atomic<uint32_t> mFailed = 0;
 };
 
 class ANavContext {
-    std::vector<std::shared_ptr<ANavmeshRenderData>> mLoadedNavmeshes;
+    // Keyed by generic path string.
+    std::unordered_map<std::string, std::shared_ptr<ANavmesh>> mLoadedNavmeshes;
+    ANavmeshArena mArena;
+    UNav::UHeightGridIndex mHeightGrids;
     uint32_t mLitSimpleProgram;
     float f = 0;
 
+    std::shared_ptr<ANavLoadQueue> mLoadQueue;
+
+    // Requested but not uploaded yet, including cancelled loads that are still in flight.
+    std::unordered_set<std::string> mPendingLoads;
+    std::unordered_set<std::string> mFailedLoads;
+
+    // Progress of the current batch of loads; reset once everything in it is handled.
+    uint32_t mBatchTotal;
+    uint32_t mBatchUploaded;
+
+    // Generated mesh shown tinted alongside the loaded navmeshes. It's drawn but not queried.
+    std::unique_ptr<ANavmeshTile> mPreviewTile;
+
+    // What's under the mouse, for the hover tooltip.
+    bool bHasHoverHit;
+    UNav::URayHit mHoverHit;
+    std::string mHoverNavmesh;
+
+    void UploadGeometry(ANavmeshGeometry& geometry);
+
 public:
     ANavContext();
     ~ANavContext();
 
+    // Parses the file and builds its geometry on a worker thread. The navmesh shows up once
+    // ProcessUploads() has moved it to the GPU.
+    // Does nothing if the navmesh is already loaded or on its way.
     void LoadNavmesh(std::filesystem::path filePath);
+    // Frees a loaded navmesh, or cancels it if it's still loading.
+    void UnloadNavmesh(std::filesystem::path filePath);
+    // Cancels every load that hasn't been uploaded yet.
+    void CancelPendingLoads();
+
+    bool IsNavmeshLoaded(const std::filesystem::path& filePath) const;
+    bool IsNavmeshPending(const std::filesystem::path& filePath) const;
+    bool HasNavmeshFailed(const std::filesystem::path& filePath) const;
+
+    uint32_t GetLoadedNavmeshCount() const { return uint32_t(mLoadedNavmeshes.size()); }
+    uint32_t GetPendingLoadCount() const { return uint32_t(mPendingLoads.size()); }
+    // Bytes of arena space used by loaded navmeshes.
+    size_t GetGPUMemoryUsage() const { return mArena.GetUsedMemory(); }
+    // Bytes of BVH and height grid kept for a loaded navmesh's CPU-side queries; 0 if it isn't loaded.
+    size_t GetNavmeshCPUMemoryUsage(const std::filesystem::path& filePath) const;
+
+    // Queries over every loaded navmesh. navmeshPath, if given, receives the path of the one that was hit.
+    bool Raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDistance, UNav::URayHit& hit, std::string* navmeshPath = nullptr) const;
+    bool FindClosestPoint(const glm::vec3& point, float maxDistance, UNav::UClosestHit& hit, std::string* navmeshPath = nullptr) const;
+
+    // Topmost surface at (x, z) from the loaded navmeshes' height grids. Constant time, but only as
+    // precise as the grid resolution, and blind to anything underneath an overhang.
+    bool GetGroundHeight(float x, float z, float& height) const { return mHeightGrids.GetHeight(x, z, height); }
+    uint32_t GetHeightGridCount() const { return mHeightGrids.GetGridCount(); }
+    size_t GetHeightGridMemoryUsage() const { return mHeightGrids.GetMemoryUsage(); }
+
+    // Replaces the preview mesh. Vertices are position + normal, like librdr3's.
+    bool SetPreviewMesh(const float* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+    void ClearPreviewMesh();
+    bool HasPreviewMesh() const { return mPreviewTile != nullptr; }
+
+    // Drops each point onto the first navmesh surface below p + searchHeight, looking at most
+    // searchDepth under p. Runs across the job system. Points with nothing underneath are left alone
+    // and get 0 in snapped, if given. Returns how many were moved.
+    uint32_t SnapToGround(std::vector<glm::vec3>& points, float searchHeight, float searchDepth, std::vector<uint8_t>* snapped = nullptr) const;
+
+    // Uploads finished navmeshes until the time budget runs out. Main thread only.
+    void ProcessUploads(float budgetMs);
+    // Blocks until every queued navmesh is loaded and uploaded.
+    void FinishPendingLoads();
+    bool IsLoading() const { return mBatchTotal != 0; }
 
     void Render(ASceneCamera& camera);
-    
+    void RenderLoadProgress();
+    void RenderHoverInfo();
+
+    // Casts a ray through the given viewport pixel (origin bottom left) to find the hovered triangle.
+    void OnMouseHover(ASceneCamera& camera, glm::vec2 viewportSize, int32_t pX, int32_t pY);
+    void ClearHover() { bHasHoverHit = false; }
+
     void OnGLInitialized();
-};
\ No newline at end of file
+};
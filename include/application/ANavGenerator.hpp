@@ -0,0 +1,60 @@
+#pragma once
+
+#include "types.h"
+#include "nav/UNavGenerator.hpp"
+#include "nav/UNavTileCache.hpp"
+
+#include <atomic>
+
+class ANavContext;
+class ADrawableContext;
+
+// One generation run, shared between the generator and the worker doing the build.
+struct ANavGenJob {
+    UNav::UNavGenInput mInput;
+    UNav::UNavGenSettings mSettings;
+    UNav::UNavGenProgress mProgress;
+    UNav::UNavGenResult mResult;
+    std::shared_ptr<UNav::UNavTileCache> mTileCache;
+
+    // Main thread only. A job waits unsubmitted while a cancelled one is still finishing.
+    bool bSubmitted = false;
+    // Set by the worker once mResult is final.
+    std::atomic<bool> bFinished = false;
+};
+
+// Builds a navmesh with Recast from the loaded drawables, on the job system so editing carries
+// on in the meantime. The result is shown as a tinted preview mesh in the navmesh view. Tiles are
+// cached between builds, so generating again after an edit only rebuilds the tiles it touched.
+class ANavGenerator {
+    UNav::UNavGenSettings mSettings;
+    std::shared_ptr<ANavGenJob> mJob;
+    // Cancelled but still running. The tile cache and Recast's allocator stats are shared, so the next
+    // job isn't submitted until this one is done.
+    std::shared_ptr<ANavGenJob> mCancelledJob;
+    // Shared with jobs so a cancelled one that's still finishing in the background can't outlive it.
+    std::shared_ptr<UNav::UNavTileCache> mTileCache;
+
+    // Outcome of the last build, shown in the window.
+    std::string mStatus;
+    // Stage timings of the last successful build.
+    UNav::UNavBuildProfile mProfile;
+
+    void Submit(const std::shared_ptr<ANavGenJob>& job);
+    void RenderProfile();
+
+public:
+    ANavGenerator();
+    ~ANavGenerator();
+
+    // Gathers the loaded drawables' triangles and queues the build. A build that's already running is
+    // cancelled first.
+    bool Start(const ADrawableContext& drawableContext);
+    void Cancel();
+    bool IsRunning() const { return mJob != nullptr; }
+
+    // Picks up a finished build and hands its mesh to the nav context as the preview. Main thread only.
+    void Update(ANavContext& navContext);
+
+    void RenderUI(bool* open, ANavContext& navContext, const ADrawableContext& drawableContext);
+};
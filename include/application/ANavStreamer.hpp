@@ -0,0 +1,73 @@
+#pragma once
+
+#include "types.h"
+
+#include <atomic>
+#include <mutex>
+
+class ANavContext;
+class ASceneCamera;
+
+// What the streamer needs to know about a navmesh without loading it.
+struct ANavStreamTile {
+    std::filesystem::path mPath;
+
+    uintmax_t mFileSize = 0;
+    int64_t mWriteTime = 0;
+
+    glm::vec3 mBoundsMin = glm::vec3(0.0f);
+    glm::vec3 mBoundsMax = glm::vec3(0.0f);
+
+    uint32_t mVertexCount = 0;
+    uint32_t mIndexCount = 0;
+
+    // Last frame the tile was within the stream radius, for LRU eviction.
+    uint64_t mLastUsedFrame = 0;
+
+    // Loaded by the streamer rather than opened by hand. Only these get evicted or unloaded by Close().
+    bool bStreamed = false;
+
+    // Size of the tile's geometry, used for both memory budgets.
+    size_t GetEstimatedSize() const;
+};
+
+// Shared between the streamer and its indexing jobs.
+struct ANavIndexQueue {
+    std::mutex mMutex;
+    std::vector<ANavStreamTile> mIndexed;
+
+    std::atomic<uint32_t> mDone = 0;
+    std::atomic<bool> bCancelled = false;
+};
+
+// Keeps the navmeshes of a whole directory loaded around the camera. The directory is indexed once
+// (bounds and sizes, cached next to the navmeshes), then tiles are loaded nearest-first as the camera
+// moves and the least recently used ones are evicted when the memory budgets in AOptions run out.
+class ANavStreamer {
+    std::filesystem::path mDirectory;
+    std::vector<ANavStreamTile> mTiles;
+
+    std::shared_ptr<ANavIndexQueue> mIndexQueue;
+    uint32_t mIndexTotal;
+
+    uint64_t mFrame;
+
+    void LoadIndex(std::vector<ANavStreamTile>& tiles);
+    void SaveIndex();
+
+public:
+    ANavStreamer();
+    ~ANavStreamer();
+
+    // Starts indexing the directory on the job system. Any previous directory is closed first.
+    void OpenDirectory(ANavContext& navContext, std::filesystem::path directory);
+    // Stops streaming and unloads every tile the streamer loaded. Navmeshes opened by hand stay loaded.
+    void Close(ANavContext& navContext);
+
+    bool IsActive() const { return !mDirectory.empty(); }
+    bool IsIndexing() const { return mIndexQueue != nullptr; }
+
+    // Call once per frame, before ANavContext::ProcessUploads().
+    void Update(ANavContext& navContext, ASceneCamera& camera);
+    void RenderUI(ANavContext& navContext);
+};
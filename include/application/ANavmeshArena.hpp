@@ -0,0 +1,131 @@
+#pragma once
+
+#include "types.h"
+#include "util/blockallocator.hpp"
+
+// Position quantized to 16 bits per axis within the tile's bounds, plus an octahedral normal at
+// 8 bits per component. Decoded in lit_simple.vert.
+struct ANavPackedVertex {
+    uint16_t mPosition[3];
+    uint16_t mNormal;
+};
+
+constexpr uint32_t NAV_VERTEX_STRIDE = sizeof(ANavPackedVertex);
+
+// Tiles with more vertices than this need 32-bit indices.
+constexpr uint32_t NAV_MAX_NARROW_VERTICES = 65536;
+
+// Matches the layout glMultiDrawElementsIndirect reads.
+struct ANavDrawCommand {
+    uint32_t mCount;
+    uint32_t mInstanceCount;
+    uint32_t mFirstIndex;
+    int32_t mBaseVertex;
+    uint32_t mBaseInstance;
+};
+
+// Per-tile dequantization constants, fetched as instanced attributes through the command's base instance.
+// mOrigin.w is the tile's preview tint.
+struct ANavTileData {
+    glm::vec4 mOrigin;
+    glm::vec4 mScale;
+};
+
+// One navmesh's slice of the shared arenas.
+struct ANavmeshTile {
+    uint32_t mVertexOffset = UBlockAllocator::INVALID_OFFSET;
+    uint32_t mVertexCount = 0;
+    // In 4-byte units, regardless of the index size.
+    uint32_t mIndexOffset = UBlockAllocator::INVALID_OFFSET;
+    uint32_t mIndexCount = 0;
+    bool bWideIndices = false;
+
+    uint32_t mCommandIdx = UINT32_MAX;
+    uint32_t mDataSlot = UINT32_MAX;
+    bool bVisible = true;
+    // Drawn with the preview tint, for generated meshes that haven't been saved anywhere.
+    bool bPreview = false;
+
+    glm::vec3 mBoundsMin = glm::vec3(0.0f);
+    glm::vec3 mBoundsMax = glm::vec3(0.0f);
+};
+
+// Shared vertex and index buffers that every loaded navmesh is suballocated from, so the whole set
+// draws with one VAO bind and a glMultiDrawElementsIndirect per index size. Indices stay relative to
+// their tile; the draw command's base vertex offsets them. Hiding a tile just zeroes its instance count.
+class ANavmeshArena {
+    // Draw commands for all tiles sharing one index type.
+    struct ANavCommandList {
+        std::vector<ANavDrawCommand> mCommands;
+        // Command slot -> owning tile, so swap-removing a command can fix up the tile that moved.
+        std::vector<ANavmeshTile*> mTiles;
+
+        uint32_t mIndirectBuffer = 0;
+        uint32_t mCapacity = 0;
+        uint32_t mDirtyBegin = UINT32_MAX;
+        uint32_t mDirtyEnd = 0;
+    };
+
+    uint32_t mVertexBuffer;
+    uint32_t mIndexBuffer;
+    uint32_t mTileDataBuffer;
+    uint32_t mVAO;
+
+    UBlockAllocator mVertexAllocator;
+    UBlockAllocator mIndexAllocator;
+
+    // 16-bit and 32-bit indices.
+    ANavCommandList mCommandLists[2];
+
+    std::vector<uint32_t> mFreeDataSlots;
+    uint32_t mDataSlotCount;
+    uint32_t mDataSlotCapacity;
+
+    bool GrowBuffer(uint32_t& buffer, UBlockAllocator& allocator, uint32_t elementSize, uint32_t minElements);
+    uint32_t AllocateDataSlot();
+    void BindBuffers();
+
+    void MarkCommandDirty(ANavCommandList& list, uint32_t commandIdx);
+    void FlushCommands(ANavCommandList& list);
+
+public:
+    ANavmeshArena();
+    ~ANavmeshArena();
+
+    void Create(uint32_t initialVertices, uint32_t initialIndices);
+    void Destroy();
+
+    static bool UsesWideIndices(uint32_t vertexCount) { return vertexCount > NAV_MAX_NARROW_VERTICES; }
+    static uint32_t GetIndexSize(uint32_t vertexCount) { return UsesWideIndices(vertexCount) ? sizeof(uint32_t) : sizeof(uint16_t); }
+
+    // Bytes of packed geometry for a tile; indices follow the vertices and start 4-byte aligned.
+    static uint32_t GetPackedVertexSize(uint32_t vertexCount) { return vertexCount * NAV_VERTEX_STRIDE; }
+    static uint32_t GetPackedSize(uint32_t vertexCount, uint32_t indexCount);
+
+    // Converts librdr3's interleaved float position + normal vertices and 32-bit indices into the
+    // arena's format. dst must hold GetPackedSize() bytes.
+    static void PackGeometry(const float* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount,
+        const glm::vec3& boundsMin, const glm::vec3& boundsMax, uint8_t* dst);
+
+    // Reserves arena space and a draw command for the tile, growing the arenas if needed. The tile's
+    // bounds must already be set; they're what the vertices get dequantized against. Empty tiles get
+    // neither and aren't uploaded.
+    bool AllocateTile(ANavmeshTile& tile, uint32_t vertexCount, uint32_t indexCount);
+    void FreeTile(ANavmeshTile& tile);
+
+    // Fill an allocated tile from caller-owned packed geometry...
+    void UploadTile(const ANavmeshTile& tile, const uint8_t* packed);
+    // ...or by copying on the GPU out of another buffer (e.g. a staging buffer), offset in bytes.
+    void CopyTile(const ANavmeshTile& tile, uint32_t srcBuffer, uint32_t srcOffset);
+
+    void SetTileVisible(ANavmeshTile& tile, bool visible);
+
+    // Binds the arena and draws every visible tile. Shader and uniforms must already be set up.
+    void Draw();
+
+    uint32_t GetTileCount() const { return uint32_t(mCommandLists[0].mCommands.size() + mCommandLists[1].mCommands.size()); }
+    // Size of the arena buffers, including free space.
+    size_t GetGPUMemoryUsage() const;
+    // Just the parts that are allocated to tiles.
+    size_t GetUsedMemory() const;
+};
@@ -10,6 +10,24 @@ struct AOptions {
 	std::filesystem::path mLastOpenedRailroadDir;
 	std::filesystem::path mLastSavedRailroadDir;
 
+	bool bRenderOnDemand;
+	bool bSinglePassPicking;
+
+	// Navmesh directory streaming.
+	float mStreamRadius;
+	uint32_t mStreamGPUBudgetMB;
+	uint32_t mStreamCPUBudgetMB;
+
+	// How far above and below a track node snap-to-ground looks for a surface.
+	float mSnapSearchHeight;
+	float mSnapSearchDepth;
+
+	// Keep preprocessed copies of opened navmeshes so reopening them skips the parse.
+	bool bNavmeshCache;
+
+	// Resolution of the cached navmesh height grids, 0 to skip building them.
+	float mHeightGridCellSize;
+
 	static void Load();
 	static void Save();
 };
@@ -3,14 +3,15 @@
 #include <chrono>
 
 
-using Clock = std::chrono::high_resolution_clock;
+// Monotonic, so intervals can't go negative or jump if the wall clock is adjusted mid-measurement.
+using Clock = std::chrono::steady_clock;
 
 namespace AUtil {
-	Clock::time_point GetTime() {
+	inline Clock::time_point GetTime() {
 		return Clock::now();
 	}
 
-	float GetDeltaTime(Clock::time_point a, Clock::time_point b) {
+	inline float GetDeltaTime(Clock::time_point a, Clock::time_point b) {
 		auto seconds = std::chrono::duration<float>{ b - a };
 
 		return seconds.count();
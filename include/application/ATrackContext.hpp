@@ -14,7 +14,22 @@ enum ETrackNodePickType : uint8_t {
     Handle_B
 };
 
+enum ETrackSnapScope : uint8_t {
+    Snap_Selected_Nodes,
+    Snap_Selected_Track,
+    Snap_All_Tracks
+};
+
 class CPathRenderer;
+class ANavContext;
+
+// Where a point and its handles were before a batch edit, for undo.
+struct ATrackPointState {
+    std::weak_ptr<UTracks::UTrackPoint> mPoint;
+    glm::vec3 mPosition;
+    glm::vec3 mHandleA;
+    glm::vec3 mHandleB;
+};
 
 struct APointSelection {
     uint16_t TrackIdx, PointIdx;
@@ -34,10 +49,11 @@ class ATrackContext {
     shared_vector<CPathRenderer> mPathRenderers;
 
     bool bGLInitialized;
-    uint32_t mPntVBO, mPntIBO, mPntVAO, mSimpleProgram, mBaseColorUniform;
+    uint32_t mPntVBO, mPntIBO, mPntVAO, mSimpleProgram, mBaseColorUniform, mObjectIdUniform;
 
     std::weak_ptr<UTracks::UTrack> mSelectedTrack;
     std::vector<APointSelection> mSelectedPoints;
+    std::weak_ptr<UTracks::UTrackPoint> mHoveredPoint;
 
     ETrackNodePickType mSelectedPickType;
 
@@ -47,6 +63,9 @@ class ATrackContext {
 
     bool bSelectingJunctionPartner;
 
+    // State before the last batch edit. One level deep.
+    std::vector<ATrackPointState> mUndoState;
+
     void InitSimpleShader();
     void DestroyGLResources();
 
@@ -62,6 +81,9 @@ class ATrackContext {
 
     void ClearSelectedPoints();
 
+    // Copies node positions into the track's path renderer and rebuilds it.
+    void SyncPathRenderer(uint32_t trackIdx);
+
 public:
     ATrackContext();
     ~ATrackContext();
@@ -80,4 +102,11 @@ public:
     void SaveTracks(std::filesystem::path dirPath);
 
     bool IsLoaded() const { return mTracks.size() != 0; }
+
+    // Projects nodes in the scope onto the navmesh below them. Curve handles are projected on their own;
+    // other nodes' handles follow the node. Undone as a single step. Returns how many nodes moved.
+    uint32_t SnapToGround(const ANavContext& navContext, ETrackSnapScope scope, float searchHeight, float searchDepth);
+
+    bool CanUndo() const { return !mUndoState.empty(); }
+    void Undo();
 };
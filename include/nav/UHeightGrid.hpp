@@ -0,0 +1,100 @@
+#pragma once
+
+#include "types.h"
+#include "util/mappedfile.hpp"
+
+#include <unordered_map>
+
+namespace UNav {
+    // Start of a height grid cache file; the cells follow it directly.
+    struct UHeightGridHeader {
+        uint32_t mMagic;
+        uint32_t mVersion;
+        // Identifies the source navmesh and the settings the grid was built with.
+        uint64_t mSourceHash;
+
+        // XZ of the first cell's corner.
+        float mOriginX;
+        float mOriginZ;
+        float mCellSize;
+        uint32_t mWidth;
+        uint32_t mHeight;
+
+        // Heights are stored as mMinHeight + cell * mHeightScale.
+        float mMinHeight;
+        float mHeightScale;
+        uint32_t mReserved;
+    };
+
+    // Topmost walkable height over a regular XZ grid, rasterized from a navmesh's triangles. Heights
+    // are quantized to 16 bits against the tile's vertical range, which keeps the error to a few
+    // millimetres on a typical tile. Once saved, the grid is memory-mapped straight out of its cache
+    // file rather than held on the heap. Immutable after building, so any thread can sample it.
+    class UHeightGrid {
+        UHeightGridHeader mHeader;
+
+        // The cells live in one or the other, depending on whether the grid came from disk.
+        UMappedFile mFile;
+        std::vector<uint16_t> mOwnedCells;
+        const uint16_t* mCells;
+
+        uint16_t GetCell(uint32_t x, uint32_t z) const { return mCells[size_t(z) * mHeader.mWidth + x]; }
+        float DecodeHeight(uint16_t cell) const { return mHeader.mMinHeight + float(cell) * mHeader.mHeightScale; }
+
+    public:
+        static constexpr uint32_t MAGIC = 0x44474855; // "UHGD"
+        static constexpr uint32_t VERSION = 1;
+
+        static constexpr uint16_t EMPTY_CELL = 0xFFFF;
+        // Coarser cells are used for tiles that would need more than this many on a side.
+        static constexpr uint32_t MAX_DIMENSION = 4096;
+
+        UHeightGrid();
+
+        // vertexStride is in floats; positions are the first three of each vertex. Triangles with an index
+        // past vertexCount are skipped.
+        void Build(const float* vertices, uint32_t vertexStride, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount,
+            const glm::vec3& boundsMin, const glm::vec3& boundsMax, float cellSize, uint64_t sourceHash);
+
+        bool Save(const std::filesystem::path& path) const;
+        // Maps the file if its header matches sourceHash. The grid is left empty if it doesn't.
+        bool Load(const std::filesystem::path& path, uint64_t sourceHash);
+
+        // Bilinear between cell centres where all four neighbours have data, nearest cell otherwise.
+        // False outside the grid or over cells no triangle covered.
+        bool GetHeight(float x, float z, float& height) const;
+
+        bool IsEmpty() const { return mCells == nullptr; }
+        bool IsMapped() const { return mFile.IsOpen(); }
+        const UHeightGridHeader& GetHeader() const { return mHeader; }
+        glm::vec2 GetBoundsMin() const { return glm::vec2(mHeader.mOriginX, mHeader.mOriginZ); }
+        glm::vec2 GetBoundsMax() const;
+
+        // Size of the cell data, whether it's on the heap or mapped.
+        size_t GetMemoryUsage() const { return size_t(mHeader.mWidth) * mHeader.mHeight * sizeof(uint16_t); }
+    };
+
+    // Spatial hash over a set of height grids for constant-time lookups anywhere in the world.
+    class UHeightGridIndex {
+        std::unordered_map<uint64_t, std::vector<std::shared_ptr<const UHeightGrid>>> mBuckets;
+        uint32_t mGridCount = 0;
+        size_t mMemoryUsage = 0;
+
+        static uint64_t GetBucketKey(int32_t x, int32_t z) { return (uint64_t(uint32_t(x)) << 32) | uint32_t(z); }
+        static void GetBucketRange(const UHeightGrid& grid, int32_t& x0, int32_t& z0, int32_t& x1, int32_t& z1);
+
+    public:
+        // World units per bucket side; a bucket usually overlaps a handful of navmesh tiles at most.
+        static constexpr float BUCKET_SIZE = 256.0f;
+
+        void Add(const std::shared_ptr<const UHeightGrid>& grid);
+        void Remove(const std::shared_ptr<const UHeightGrid>& grid);
+        void Clear();
+
+        // Highest surface any grid has at (x, z).
+        bool GetHeight(float x, float z, float& height) const;
+
+        uint32_t GetGridCount() const { return mGridCount; }
+        size_t GetMemoryUsage() const { return mMemoryUsage; }
+    };
+}
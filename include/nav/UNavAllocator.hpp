@@ -0,0 +1,44 @@
+#pragma once
+
+#include "types.h"
+
+// Replacement for Recast's malloc-backed rcAlloc, so tile builds stop going through the global heap
+// for every buffer. Inside a tile scope, RC_ALLOC_TEMP memory comes from a per-thread bump arena that's
+// reset when the scope ends, and freed RC_ALLOC_PERM blocks (span pools, compact heightfield arrays) are
+// kept in per-thread size-class lists for the next tile. Outside a scope everything goes to the heap.
+namespace UNavAllocator {
+    // Installs the allocator with Recast. Must happen before anything else calls rcAlloc; safe to call repeatedly.
+    void Install();
+
+    // Marks the calling thread as building a tile until destroyed. Nests; only the outermost one resets the arena.
+    class UTileScope {
+    public:
+        UTileScope();
+        ~UTileScope();
+
+        UTileScope(const UTileScope&) = delete;
+        UTileScope& operator=(const UTileScope&) = delete;
+    };
+
+    struct UNavAllocStats {
+        // Every rcAlloc call.
+        uint64_t mAllocations = 0;
+        // Calls that actually reached malloc, arena blocks included.
+        uint64_t mHeapAllocations = 0;
+        // Served from a thread's arena or its recycled blocks.
+        uint64_t mArenaAllocations = 0;
+        uint64_t mRecycledAllocations = 0;
+
+        // Most arena memory any one thread had in use at once since the last ResetPeak().
+        size_t mPeakArenaBytes = 0;
+        // Currently held by threads that aren't building anything: arena blocks and recycled blocks.
+        size_t mRetainedBytes = 0;
+    };
+
+    // Totals since startup, across all threads.
+    UNavAllocStats GetStats();
+    void ResetPeak();
+
+    // Hands back the memory held by threads that are between tiles.
+    void Trim();
+}
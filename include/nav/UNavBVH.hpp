@@ -0,0 +1,73 @@
+#pragma once
+
+#include "types.h"
+
+namespace UNav {
+    // 32 bytes. Leaves hold one triangle pack; an interior node's children are adjacent.
+    struct UBVHNode {
+        glm::vec3 mMin;
+        // Leaf: pack index. Interior: index of the left child, the right one follows it.
+        uint32_t mFirst;
+        glm::vec3 mMax;
+        // Triangles in the leaf's pack, 0 for interior nodes.
+        uint32_t mCount;
+
+        bool IsLeaf() const { return mCount != 0; }
+    };
+
+    // Up to four triangles laid out for 4-wide tests: first vertex and both edges, per axis per lane.
+    // Unused lanes are zeroed, which every test treats as a miss.
+    struct alignas(16) UTrianglePack {
+        float mV0[3][4];
+        float mE1[3][4];
+        float mE2[3][4];
+    };
+
+    struct URayHit {
+        float mDistance = 0.0f;
+        // Index of the triangle in the index buffer the BVH was built from.
+        uint32_t mTriangle = UINT32_MAX;
+        glm::vec3 mPosition = glm::vec3(0.0f);
+        glm::vec3 mNormal = glm::vec3(0.0f);
+    };
+
+    struct UClosestHit {
+        float mDistance = 0.0f;
+        uint32_t mTriangle = UINT32_MAX;
+        glm::vec3 mPosition = glm::vec3(0.0f);
+    };
+
+    // Static BVH over a navmesh's triangles for CPU-side queries. Built with binned SAH; triangles are
+    // stored pre-transformed in SoA packs of four so ray and box tests run four triangles at a time.
+    // Immutable once built, so it can be queried from any thread.
+    class UNavBVH {
+        std::vector<UBVHNode> mNodes;
+        std::vector<UTrianglePack> mPacks;
+        // Four per pack, UINT32_MAX for unused lanes.
+        std::vector<uint32_t> mTriangleIds;
+
+    public:
+        // vertexStride is in floats; positions are the first three of each vertex. Triangles with an index
+        // past vertexCount are skipped.
+        void Build(const float* vertices, uint32_t vertexStride, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+
+        // Closest intersection along the ray within maxDistance. dir must be normalized. Triangles are double sided.
+        bool Raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDistance, URayHit& hit) const;
+        // Closest point on any triangle within maxDistance of the point.
+        bool FindClosestPoint(const glm::vec3& point, float maxDistance, UClosestHit& hit) const;
+        // Appends every triangle whose bounds overlap the box.
+        void QueryBox(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<uint32_t>& triangles) const;
+
+        bool IsEmpty() const { return mNodes.empty(); }
+        glm::vec3 GetBoundsMin() const { return mNodes.empty() ? glm::vec3(0.0f) : mNodes[0].mMin; }
+        glm::vec3 GetBoundsMax() const { return mNodes.empty() ? glm::vec3(0.0f) : mNodes[0].mMax; }
+
+        size_t GetMemoryUsage() const;
+
+        // Flat copy of the built tree, for caching it on disk. Deserialize checks the node links so a
+        // corrupt blob is rejected rather than traversed.
+        size_t GetSerializedSize() const;
+        void Serialize(uint8_t* dst) const;
+        bool Deserialize(const uint8_t* src, size_t size);
+    };
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "types.h"
+#include "application/ATime.hpp"
+#include "nav/UNavBuildProfile.hpp"
+
+#include <Recast.h>
+
+#include <mutex>
+
+#ifdef TRACY_ENABLE
+#include <TracyC.h>
+#endif
+
+namespace UNav {
+    // Recast's context for NaviGator builds. Keeps the first error Recast reports so it can be shown to the
+    // user, runs Recast's parallel steps on the job system, and times each Recast stage, reporting it as a
+    // Tracy zone too. Only one thread drives a context at a time, so the timers aren't locked; give each
+    // tile its own and hand it to a UNavBuildProfiler once the tile is done.
+    class UNavBuildContext : public rcContext {
+        Clock::time_point mStartTimes[RC_MAX_TIMERS];
+        int64_t mElapsedNs[RC_MAX_TIMERS];
+        uint32_t mRunCounts[RC_MAX_TIMERS];
+
+        // Running labels, innermost last. Recast skips stopTimer on some error paths, so stopping a label
+        // also closes anything still open inside it.
+        rcTimerLabel mOpenTimers[RC_MAX_TIMERS];
+        int mOpenCount;
+
+#ifdef TRACY_ENABLE
+        TracyCZoneCtx mZones[RC_MAX_TIMERS];
+#endif
+
+    public:
+        std::string mError;
+
+        UNavBuildContext();
+        ~UNavBuildContext();
+
+        // Time spent in a stage since the last reset, and how many times it ran.
+        double GetStageMs(rcTimerLabel label) const { return double(mElapsedNs[label]) / 1e6; }
+        uint32_t GetRunCount(rcTimerLabel label) const { return mRunCounts[label]; }
+
+    protected:
+        void doLog(const rcLogCategory category, const char* msg, const int len) override;
+
+        void doResetTimers() override;
+        void doStartTimer(const rcTimerLabel label) override;
+        void doStopTimer(const rcTimerLabel label) override;
+        // Microseconds, like the Recast demo's context.
+        int doGetAccumulatedTime(const rcTimerLabel label) const override;
+
+        void doParallelFor(const int count, const int grainSize, rcParallelForBody* body, void* userData) override;
+        int doGetThreadCount() const override;
+    };
+
+    // Sums the stage times of every tile in a build, from whichever threads built them.
+    class UNavBuildProfiler {
+        mutable std::mutex mMutex;
+
+        double mTotalMs[RC_MAX_TIMERS] = {};
+        double mMaxMs[RC_MAX_TIMERS] = {};
+        uint32_t mTileCounts[RC_MAX_TIMERS] = {};
+        uint32_t mTilesBuilt = 0;
+
+    public:
+        // bTile counts the context as a built tile; merge contexts and the like aren't.
+        void Add(const UNavBuildContext& context, bool bTile = true);
+
+        // Stage totals so far. The build time and thread count are left for the caller.
+        UNavBuildProfile GetProfile() const;
+    };
+
+    const char* GetTimerName(rcTimerLabel label);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "types.h"
+
+namespace UNav {
+    // One Recast timer label, summed over every tile that ran it.
+    struct UNavStageTime {
+        const char* mName = "";
+        // Nesting under another stage, e.g. the watershed pass inside region building.
+        uint32_t mDepth = 0;
+
+        double mTotalMs = 0.0;
+        // Slowest single tile.
+        double mMaxMs = 0.0;
+        uint32_t mTileCount = 0;
+    };
+
+    // Where a build's time went, stage by stage. Stage times are summed across threads, so with more
+    // than one thread they add up to more than the wall clock time.
+    struct UNavBuildProfile {
+        // Pipeline order; stages no tile ran are left out.
+        std::vector<UNavStageTime> mStages;
+
+        double mBuildTimeMs = 0.0;
+        uint32_t mThreadCount = 0;
+        uint32_t mTilesBuilt = 0;
+
+        bool IsEmpty() const { return mStages.empty(); }
+        // The tiles' own total, which the top-level stages are a share of.
+        const UNavStageTime* FindTotal() const;
+
+        std::string ToJson() const;
+        bool WriteJson(const std::filesystem::path& path) const;
+    };
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "types.h"
+#include "nav/UNavBuildProfile.hpp"
+
+#include <atomic>
+
+struct rcPolyMesh;
+
+namespace UNav {
+    class UNavTileCache;
+
+    // Recast build parameters in world units (and degrees); converted to voxels when a build starts.
+    // Defaults are Recast's sample values for a human-sized agent.
+    struct UNavGenSettings {
+        float mCellSize = 0.3f;
+        float mCellHeight = 0.2f;
+        // Tile edge in cells, not counting the border each tile is built with.
+        uint32_t mTileSize = 128;
+
+        float mAgentHeight = 2.0f;
+        float mAgentRadius = 0.6f;
+        float mAgentMaxClimb = 0.9f;
+        float mAgentMaxSlope = 45.0f;
+
+        // Square root of the area in cells, as in the Recast demo.
+        float mRegionMinSize = 8.0f;
+        float mRegionMergeSize = 20.0f;
+
+        float mEdgeMaxLength = 12.0f;
+        float mEdgeMaxError = 1.3f;
+        uint32_t mVertsPerPoly = 6;
+
+        // In cells; sample distances under 0.9 turn detail sampling off.
+        float mDetailSampleDistance = 6.0f;
+        float mDetailSampleMaxError = 1.0f;
+
+        // Lets Recast split the steps that support it across the job system within each tile, on top of
+        // building tiles in parallel. The results are the same either way.
+        bool bParallelSteps = true;
+    };
+
+    // Indexed triangle soup to build from.
+    struct UNavGenInput {
+        // xyz per vertex.
+        std::vector<float> mVertices;
+        std::vector<int32_t> mIndices;
+
+        bool IsEmpty() const { return mIndices.size() < 3; }
+        uint32_t GetVertexCount() const { return uint32_t(mVertices.size() / 3); }
+        uint32_t GetTriangleCount() const { return uint32_t(mIndices.size() / 3); }
+    };
+
+    enum class ENavGenStage : uint32_t {
+        Partition,
+        BuildTiles,
+        Merge,
+        Done
+    };
+
+    const char* GetStageName(ENavGenStage stage);
+
+    // Shared between a build and whoever is watching it.
+    struct UNavGenProgress {
+        std::atomic<ENavGenStage> mStage = ENavGenStage::Partition;
+        std::atomic<uint32_t> mTilesDone = 0;
+        std::atomic<uint32_t> mTileCount = 0;
+
+        // Checked before each tile and stage; tiles that are already building finish first.
+        std::atomic<bool> bCancelled = false;
+
+        float GetFraction() const;
+    };
+
+    // The detail mesh flattened into a triangle list.
+    struct UNavGenResult {
+        bool bSucceeded = false;
+        bool bCancelled = false;
+        std::string mError;
+
+        // xyz per vertex.
+        std::vector<float> mVertices;
+        std::vector<uint32_t> mIndices;
+
+        // All tiles' polygons merged into one mesh. Null if there were too many vertices for Recast's
+        // 16-bit polygon indices; the triangles above are still complete in that case.
+        std::shared_ptr<rcPolyMesh> mPolyMesh;
+
+        uint32_t mPolyCount = 0;
+        uint32_t mTileCount = 0;
+        // Tiles with geometry: built this time, reused from the last build in memory, or read from disk.
+        uint32_t mTilesBuilt = 0;
+        uint32_t mTilesReused = 0;
+        uint32_t mTilesFromDisk = 0;
+
+        // Recast's allocations during the build, how many of those hit malloc, and the most temporary
+        // memory one tile needed at once.
+        uint64_t mAllocations = 0;
+        uint64_t mHeapAllocations = 0;
+        size_t mPeakArenaBytes = 0;
+        float mBuildTimeMs = 0.0f;
+
+        // Recast's stage timings, summed over the tiles built this time. Cached tiles aren't in it.
+        UNavBuildProfile mProfile;
+    };
+
+    // Splits the input into tiles on a world-aligned grid and runs the full Recast pipeline on each across the job
+    // system: rasterize, filter, compact heightfield, watershed regions, contours, poly mesh and detail
+    // mesh. Tiles are built with a border so their edges line up, then merged in tile order, so the
+    // output is identical however many threads did the work. Blocking; the calling thread helps out.
+    // With a cache, tiles whose inputs hash the same as a cached tile are taken from it instead of
+    // rebuilt, so rebuilding after a local edit only redoes the tiles it touched.
+    bool GenerateNavmesh(const UNavGenInput& input, const UNavGenSettings& settings, UNavGenProgress& progress, UNavGenResult& result,
+        UNavTileCache* cache = nullptr);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "types.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+struct rcPolyMesh;
+struct rcPolyMeshDetail;
+
+namespace UNav {
+    // What one tile of a generation run produced. Both meshes are null for tiles with nothing walkable.
+    struct UNavGenTile {
+        rcPolyMesh* mPolyMesh = nullptr;
+        rcPolyMeshDetail* mDetailMesh = nullptr;
+
+        UNavGenTile() = default;
+        ~UNavGenTile();
+
+        UNavGenTile(const UNavGenTile&) = delete;
+        UNavGenTile& operator=(const UNavGenTile&) = delete;
+
+        bool IsEmpty() const { return mPolyMesh == nullptr; }
+    };
+
+    // Built tiles keyed by a hash of everything that went into them (triangles, area ids and the tile's
+    // rcConfig), so a rebuild after an edit only redoes the tiles that actually changed. Memory holds
+    // the tiles of the latest build; every tile also goes to disk, if a directory is given, so they
+    // survive restarts and switching back and forth between edits. Safe to use from several tiles at once.
+    class UNavTileCache {
+        std::filesystem::path mDirectory;
+
+        std::mutex mMutex;
+        std::unordered_map<uint64_t, std::shared_ptr<UNavGenTile>> mTiles;
+        // The build before the current one; anything it had that isn't used again gets dropped at EndBuild().
+        std::unordered_map<uint64_t, std::shared_ptr<UNavGenTile>> mPreviousTiles;
+
+        std::filesystem::path GetTilePath(uint64_t hash) const;
+        bool Save(uint64_t hash, const UNavGenTile& tile) const;
+        std::shared_ptr<UNavGenTile> Load(uint64_t hash) const;
+        // Deletes the least recently used tile files until the directory fits in MAX_DISK_BYTES.
+        void Prune() const;
+
+    public:
+        // Bump whenever the tile build or the file layout changes.
+        static constexpr uint32_t VERSION = 1;
+        // Cap on the tile files on disk, checked after every build.
+        static constexpr uint64_t MAX_DISK_BYTES = 512ull * 1024 * 1024;
+
+        // An empty directory keeps tiles in memory only.
+        explicit UNavTileCache(std::filesystem::path directory = std::filesystem::path());
+
+        // Bracket one build. Builds sharing a cache must not overlap, since each one's BeginBuild and
+        // EndBuild would drop the other's tiles.
+        void BeginBuild();
+        void EndBuild();
+
+        // bFromDisk says whether it had to be read back in.
+        std::shared_ptr<UNavGenTile> Find(uint64_t hash, bool& bFromDisk);
+        void Store(uint64_t hash, const std::shared_ptr<UNavGenTile>& tile);
+
+        void Clear();
+        uint32_t GetTileCount();
+    };
+}
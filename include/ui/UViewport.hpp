@@ -8,15 +8,19 @@ class UViewport {
     std::string mViewportName;
 
     uint32_t mFBO;
-    uint32_t mTexIds[2];
+    uint32_t mTexIds[3];
 
     glm::vec2 mViewportPos;
     glm::vec2 mViewportSize;
 
     bool bIsOpen;
 
+    glm::mat4 mLastViewMtx;
+    glm::mat4 mLastProjMtx;
+
     void CreateFramebuffer();
     void ResizeViewport();
+    void CheckCameraChanged();
     void Clear();
 
 public:
@@ -30,6 +34,11 @@ public:
     glm::vec2 GetViewportPosition() const { return mViewportPos; }
 
     ASceneCamera& GetCamera() { return mCamera; }
+    uint32_t GetFramebuffer() const { return mFBO; }
+    uint32_t GetColorTexture() const { return mTexIds[0]; }
+
+    // Resizes the framebuffer directly, for when the viewport isn't driven by an ImGui window.
+    void SetViewportSize(glm::vec2 size);
 
     void BindViewport();
     void UnbindViewport();
@@ -7,6 +7,11 @@ namespace UViewportPicker {
     void ResizePicker(uint32_t width, uint32_t height);
     void DestroyPicker();
 
+    // Reads IDs from GL_COLOR_ATTACHMENT1 of the given framebuffer instead of the picker's own,
+    // for when the main pass already writes them. Pass 0 to go back to the separate picking pass.
+    void SetSharedSource(uint32_t fbo);
+    bool UsesSharedSource();
+
     void BindBuffer();
     void UnbindBuffer();
 
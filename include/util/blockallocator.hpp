@@ -0,0 +1,31 @@
+#pragma once
+
+#include "types.h"
+
+#include <map>
+
+// First-fit range allocator for suballocating GPU buffers. Only tracks offsets; the caller owns the
+// actual memory. Not thread safe.
+class UBlockAllocator {
+    // Offset -> size of each free block.
+    std::map<uint32_t, uint32_t> mFreeBlocks;
+
+    uint32_t mSize;
+    uint32_t mUsed;
+
+public:
+    static constexpr uint32_t INVALID_OFFSET = UINT32_MAX;
+
+    UBlockAllocator();
+
+    void Reset(uint32_t size);
+    // Extends the range, e.g. after the backing buffer was reallocated at a larger size.
+    void Grow(uint32_t newSize);
+
+    // Returns INVALID_OFFSET if no free block is large enough.
+    uint32_t Allocate(uint32_t size);
+    void Free(uint32_t offset, uint32_t size);
+
+    uint32_t GetSize() const { return mSize; }
+    uint32_t GetUsed() const { return mUsed; }
+};
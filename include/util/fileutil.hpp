@@ -4,4 +4,16 @@
 
 namespace UFileUtil {
     std::string LoadShaderText(std::string shaderName);
-}
\ No newline at end of file
+
+    // Folder holding the running executable, or the working directory if that can't be found.
+    std::filesystem::path GetExecutableDirectory();
+
+    // Folder under the working directory for derived data that can be rebuilt at any time, created if needed.
+    std::filesystem::path GetCacheDirectory(const std::string& name);
+
+    // 64-bit FNV-1a. Pass the previous result as the seed to hash several pieces together.
+    uint64_t Hash(const void* data, size_t size, uint64_t seed = 0xCBF29CE484222325ull);
+
+    // Hash of everything in the file. False if it couldn't be read.
+    bool HashFileContents(const std::filesystem::path& path, uint64_t& hash);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "types.h"
+
+#include <glad/glad.h>
+#include <TracyOpenGL.hpp>
+
+// GPU timings per render pass, measured with GL_TIME_ELAPSED queries. Each zone owns a small ring of
+// query objects so results are read back a few frames late instead of stalling the pipeline.
+// Elapsed-time queries can't nest, so zones are flat: a zone opened while another one is running
+// is only reported to Tracy, and the outer zone keeps timing until it ends.
+namespace UGPUProfiler {
+    struct UZoneStats {
+        const char* mName;
+        float mLastMs;
+        float mAverageMs;
+        float mMaxMs;
+    };
+
+    void Init();
+    void Shutdown();
+
+    // Call once per executed frame, with the main GL context current.
+    void BeginFrame();
+    void EndFrame();
+
+    // Returns whether a query was started; only then should EndZone be called for this zone.
+    bool BeginZone(const char* name);
+    void EndZone();
+
+    // Rolling averages over the last few dozen frames that actually ran each zone.
+    std::vector<UZoneStats> GetStats();
+
+    void RenderOverlay(bool* open);
+
+    class UScopedZone {
+        bool bStarted;
+
+    public:
+        UScopedZone(const char* name) : bStarted(BeginZone(name)) {}
+        ~UScopedZone() {
+            if (bStarted) {
+                EndZone();
+            }
+        }
+    };
+}
+
+#define GPU_ZONE_CONCAT_INNER(a, b) a##b
+#define GPU_ZONE_CONCAT(a, b) GPU_ZONE_CONCAT_INNER(a, b)
+
+// Times the rest of the enclosing scope on the GPU, both in the in-app overlay and as a Tracy GPU zone.
+#define GPUZone(name) TracyGpuZone(name); UGPUProfiler::UScopedZone GPU_ZONE_CONCAT(gpuZone_, __LINE__)(name)
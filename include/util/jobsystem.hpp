@@ -0,0 +1,25 @@
+#pragma once
+
+#include "types.h"
+
+#include <functional>
+
+// Small fixed-size worker pool for CPU-heavy work (file parsing, mesh building) that shouldn't block
+// the UI thread. Jobs must not touch GL; hand results back to the main thread instead.
+namespace UJobSystem {
+    // threadCount == 0 picks one less than the number of hardware threads.
+    void Init(uint32_t threadCount = 0);
+    // Drops jobs that haven't started yet and waits for the running ones to finish.
+    void Shutdown();
+
+    void Submit(std::function<void()> job);
+
+    // Splits [0, count) into chunks of grainSize and runs body(begin, end) on them across the workers,
+    // blocking until all are done. The calling thread works through chunks too, so this is safe to call
+    // from a job and still finishes if every worker is busy with something long.
+    void ParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t, uint32_t)>& body);
+
+    uint32_t GetThreadCount();
+    // Jobs that are queued or currently running.
+    uint32_t GetPendingJobCount();
+}
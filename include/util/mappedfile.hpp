@@ -0,0 +1,29 @@
+#pragma once
+
+#include "types.h"
+
+// Read-only memory mapping of a whole file. The OS pages it in on demand and can drop the pages
+// again under memory pressure, since they're backed by the file.
+class UMappedFile {
+    const uint8_t* mData;
+    size_t mSize;
+
+#ifdef _WIN32
+    void* mFileHandle;
+    void* mMappingHandle;
+#endif
+
+public:
+    UMappedFile();
+    ~UMappedFile();
+
+    UMappedFile(const UMappedFile&) = delete;
+    UMappedFile& operator=(const UMappedFile&) = delete;
+
+    bool Open(const std::filesystem::path& path);
+    void Close();
+
+    bool IsOpen() const { return mData != nullptr; }
+    const uint8_t* GetData() const { return mData; }
+    size_t GetSize() const { return mSize; }
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "types.h"
+#include "util/blockallocator.hpp"
+
+#include <mutex>
+
+// Persistently mapped upload buffer that worker threads can write into directly. The main thread
+// then copies the data into its final buffer on the GPU (glCopyNamedBufferSubData), so there's no
+// second CPU-side copy held until upload time and no driver copy during glNamedBufferStorage.
+// Blocks are handed out first-fit and only reused once the GPU has finished copying out of them.
+class UStagingBuffer {
+public:
+    struct UAllocation {
+        uint32_t mOffset = 0;
+        uint32_t mSize = 0;
+        uint8_t* mData = nullptr;
+
+        bool IsValid() const { return mData != nullptr; }
+    };
+
+private:
+    uint32_t mBuffer;
+    uint32_t mSize;
+    uint8_t* mMappedData;
+
+    UBlockAllocator mAllocator;
+    std::mutex mAllocatorMutex;
+
+    // Blocks waiting for the GPU to finish reading them, with the fence that tells us when it has.
+    std::vector<std::pair<void*, UAllocation>> mRetiredBlocks;
+
+public:
+    UStagingBuffer();
+    ~UStagingBuffer();
+
+    // Main thread only. Workers must be done writing their allocations before Destroy().
+    bool Create(uint32_t size);
+    void Destroy();
+
+    // Returns blocks whose copies have completed to the free list. Main thread only.
+    void ReclaimCompleted();
+    // Frees the block once every GL command issued so far has executed. Main thread only.
+    void Retire(const UAllocation& allocation);
+
+    // Thread safe. Returns an invalid allocation if no free block is large enough right now;
+    // callers should fall back to uploading from regular memory.
+    UAllocation Allocate(uint32_t size);
+
+    uint32_t GetBuffer() const { return mBuffer; }
+};
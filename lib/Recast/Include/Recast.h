@@ -98,6 +98,12 @@ enum rcTimerLabel
 	RC_MAX_TIMERS
 };
 
+/// A range of work run by rcContext::parallelFor.
+///  @param[in]		userData	The pointer passed to rcContext::parallelFor.
+///  @param[in]		begin		The first item of the range.
+///  @param[in]		end			One past the last item of the range.
+typedef void (rcParallelForBody)(void* userData, int begin, int end);
+
 /// Provides an interface for optional logging and performance tracking of the Recast 
 /// build process.
 /// 
@@ -109,6 +115,10 @@ enum rcTimerLabel
 ///
 /// If no logging or timers are required, just pass an instance of this 
 /// class through the Recast build process.
+///
+/// Some build steps can split their work across threads through #parallelFor.
+/// This class runs that work serially; implementations can hand it to a thread
+/// pool by overriding #doParallelFor and #doGetThreadCount.
 /// 
 /// @ingroup recast
 class rcContext
@@ -116,7 +126,7 @@ class rcContext
 public:
 	/// Constructor.
 	///  @param[in]		state	TRUE if the logging and performance timers should be enabled.  [Default: true]
-	inline rcContext(bool state = true) : m_logEnabled(state), m_timerEnabled(state) {}
+	inline rcContext(bool state = true) : m_logEnabled(state), m_timerEnabled(state), m_parallelEnabled(true) {}
 	virtual ~rcContext() {}
 
 	/// Enables or disables logging.
@@ -158,6 +168,23 @@ public:
 	/// @return The accumulated time of the timer, or -1 if timers are disabled or the timer has never been started.
 	inline int getAccumulatedTime(const rcTimerLabel label) const { return m_timerEnabled ? doGetAccumulatedTime(label) : -1; }
 
+	/// Enables or disables the parallel versions of the build steps that have one.
+	/// The serial versions give the same results; this is mostly useful for checking that.
+	///  @param[in]		state	TRUE if build steps may run in parallel.
+	inline void enableParallel(bool state) { m_parallelEnabled = state; }
+
+	/// Returns the number of threads #parallelFor can spread work across, 1 if parallel building is disabled.
+	inline int getThreadCount() const { return m_parallelEnabled && doGetThreadCount() > 1 ? doGetThreadCount() : 1; }
+
+	/// Runs @p body over the ranges [0, @p grainSize), [@p grainSize, 2 * @p grainSize)... up to @p count,
+	/// possibly on several threads at once, and returns once all of them are done.
+	/// The body must not use the context's logging or timers.
+	///  @param[in]		count		The number of items.
+	///  @param[in]		grainSize	The maximum number of items per range.
+	///  @param[in]		body		The function to run on each range.
+	///  @param[in]		userData	Passed through to @p body.
+	void parallelFor(const int count, const int grainSize, rcParallelForBody* body, void* userData);
+
 protected:
 	/// Clears all log entries.
 	virtual void doResetLog();
@@ -183,12 +210,25 @@ protected:
 	/// @param[in]		label	The category of the timer.
 	/// @return The accumulated time of the timer, or -1 if timers are disabled or the timer has never been started.
 	virtual int doGetAccumulatedTime(const rcTimerLabel label) const { rcIgnoreUnused(label); return -1; }
+
+	/// Runs the ranges of a #parallelFor. The default implementation runs them one after another.
+	///  @param[in]		count		The number of items. Always positive.
+	///  @param[in]		grainSize	The maximum number of items per range. Always positive.
+	///  @param[in]		body		The function to run on each range.
+	///  @param[in]		userData	Passed through to @p body.
+	virtual void doParallelFor(const int count, const int grainSize, rcParallelForBody* body, void* userData);
+
+	/// Returns the number of threads #doParallelFor uses.
+	virtual int doGetThreadCount() const { return 1; }
 	
 	/// True if logging is enabled.
 	bool m_logEnabled;
 
 	/// True if the performance timers are enabled.
 	bool m_timerEnabled;
+
+	/// True if build steps may run in parallel.
+	bool m_parallelEnabled;
 };
 
 /// A helper to first start a timer and then stop it when this helper goes out of scope.
@@ -998,6 +1038,32 @@ bool rcRasterizeTriangles(rcContext* context,
                           const float* verts, const unsigned char* triAreaIDs, int numTris,
                           rcHeightfield& heightfield, int flagMergeThreshold = 1);
 
+/// Code paths the rcRasterizeTriangles functions can take. The SIMD paths handle triangles that fall
+/// inside a single cell several at a time and hand the rest to the scalar clipper, so every path
+/// produces exactly the same spans.
+/// @see rcSetRasterizationPath
+enum rcRasterizationPath
+{
+	RC_RASTER_SCALAR = 0,	///< Clip every triangle one at a time.
+	RC_RASTER_SSE41,		///< Batches of 8 triangles, tested 4 lanes at a time. Requires SSE4.1.
+	RC_RASTER_AVX2,			///< Batches of 8 triangles, tested 8 lanes at a time. Requires AVX2.
+};
+
+/// Selects the rasterization code path. The widest one the CPU supports is used by default.
+/// Not thread safe; don't call it while triangles are being rasterized.
+/// @ingroup recast
+/// @param[in]		path	The path to use.
+/// @returns False, leaving the current path in place, if the CPU or build doesn't support @p path.
+bool rcSetRasterizationPath(rcRasterizationPath path);
+
+/// @ingroup recast
+/// @returns The rasterization code path currently in use.
+rcRasterizationPath rcGetRasterizationPath();
+
+/// @ingroup recast
+/// @returns True if the CPU and build support @p path.
+bool rcIsRasterizationPathSupported(rcRasterizationPath path);
+
 /// Marks non-walkable spans as walkable if their maximum is within @p walkableClimb of a walkable neighbor.
 ///
 /// Allows the formation of walkable regions that will flow over low lying 
@@ -1285,7 +1351,8 @@ bool rcBuildContours(rcContext* ctx, const rcCompactHeightfield& chf,
 /// @returns True if the operation completed successfully.
 bool rcBuildPolyMesh(rcContext* ctx, const rcContourSet& cset, const int nvp, rcPolyMesh& mesh);
 
-/// Merges multiple polygon meshes into a single mesh.
+/// Merges multiple polygon meshes into a single mesh. The meshes' minimum heights may differ, as long as
+/// they're a whole number of cells apart.
 ///  @ingroup recast
 ///  @param[in,out]	ctx		The build context to use during the operation.
 ///  @param[in]		meshes	An array of polygon meshes to merge. [Size: @p nmeshes]
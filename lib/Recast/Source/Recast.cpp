@@ -83,6 +83,29 @@ void rcContext::doResetLog()
 	// Defined out of line to fix the weak v-tables warning
 }
 
+void rcContext::parallelFor(const int count, const int grainSize, rcParallelForBody* body, void* userData)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+	const int grain = rcMax(grainSize, 1);
+	if (getThreadCount() == 1)
+	{
+		rcContext::doParallelFor(count, grain, body, userData);
+		return;
+	}
+	doParallelFor(count, grain, body, userData);
+}
+
+void rcContext::doParallelFor(const int count, const int grainSize, rcParallelForBody* body, void* userData)
+{
+	for (int begin = 0; begin < count; begin += grainSize)
+	{
+		body(userData, begin, rcMin(begin + grainSize, count));
+	}
+}
+
 rcHeightfield* rcAllocHeightfield()
 {
 	return rcNew<rcHeightfield>(RC_ALLOC_PERM);
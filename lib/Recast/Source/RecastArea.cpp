@@ -25,35 +25,13 @@
 #include "RecastAlloc.h"
 #include "RecastAssert.h"
 
-/// @par 
-/// 
-/// Basically, any spans that are closer to a boundary or obstruction than the specified radius 
-/// are marked as unwalkable.
-///
-/// This method is usually called immediately after the heightfield has been built.
-///
-/// @see rcCompactHeightfield, rcBuildCompactHeightfield, rcConfig::walkableRadius
-bool rcErodeWalkableArea(rcContext* ctx, int radius, rcCompactHeightfield& chf)
+/// Seeds the erosion distance of the spans in rows [y0, y1): 0 for unwalkable spans and spans with
+/// a missing or unwalkable neighbour, 0xff for the rest.
+static void markErodeBoundarySpans(const rcCompactHeightfield& chf, unsigned char* dist, const int y0, const int y1)
 {
-	rcAssert(ctx);
-	
 	const int w = chf.width;
-	const int h = chf.height;
 	
-	rcScopedTimer timer(ctx, RC_TIMER_ERODE_AREA);
-	
-	unsigned char* dist = (unsigned char*)rcAlloc(sizeof(unsigned char)*chf.spanCount, RC_ALLOC_TEMP);
-	if (!dist)
-	{
-		ctx->log(RC_LOG_ERROR, "erodeWalkableArea: Out of memory 'dist' (%d).", chf.spanCount);
-		return false;
-	}
-	
-	// Init distance.
-	memset(dist, 0xff, sizeof(unsigned char)*chf.spanCount);
-	
-	// Mark boundary cells.
-	for (int y = 0; y < h; ++y)
+	for (int y = y0; y < y1; ++y)
 	{
 		for (int x = 0; x < w; ++x)
 		{
@@ -82,179 +60,351 @@ bool rcErodeWalkableArea(rcContext* ctx, int radius, rcCompactHeightfield& chf)
 						}
 					}
 					// At least one missing neighbour.
-					if (nc != 4)
-						dist[i] = 0;
+					dist[i] = nc != 4 ? 0 : 0xff;
 				}
 			}
 		}
 	}
-	
+}
+
+/// First erosion pass over cells [x0, x1) of row @p y, left to right, from the (-1,0), (-1,-1), (0,-1)
+/// and (1,-1) neighbours.
+static void erodeSweepForward(const rcCompactHeightfield& chf, unsigned char* dist, const int x0, const int x1, const int y)
+{
+	const int w = chf.width;
 	unsigned char nd;
 	
-	// Pass 1
-	for (int y = 0; y < h; ++y)
+	for (int x = x0; x < x1; ++x)
 	{
-		for (int x = 0; x < w; ++x)
+		const rcCompactCell& c = chf.cells[x+y*w];
+		for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
 		{
-			const rcCompactCell& c = chf.cells[x+y*w];
-			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+			const rcCompactSpan& s = chf.spans[i];
+			
+			if (rcGetCon(s, 0) != RC_NOT_CONNECTED)
 			{
-				const rcCompactSpan& s = chf.spans[i];
+				// (-1,0)
+				const int ax = x + rcGetDirOffsetX(0);
+				const int ay = y + rcGetDirOffsetY(0);
+				const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 0);
+				const rcCompactSpan& as = chf.spans[ai];
+				nd = (unsigned char)rcMin((int)dist[ai]+2, 255);
+				if (nd < dist[i])
+					dist[i] = nd;
 				
-				if (rcGetCon(s, 0) != RC_NOT_CONNECTED)
+				// (-1,-1)
+				if (rcGetCon(as, 3) != RC_NOT_CONNECTED)
 				{
-					// (-1,0)
-					const int ax = x + rcGetDirOffsetX(0);
-					const int ay = y + rcGetDirOffsetY(0);
-					const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 0);
-					const rcCompactSpan& as = chf.spans[ai];
-					nd = (unsigned char)rcMin((int)dist[ai]+2, 255);
+					const int aax = ax + rcGetDirOffsetX(3);
+					const int aay = ay + rcGetDirOffsetY(3);
+					const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 3);
+					nd = (unsigned char)rcMin((int)dist[aai]+3, 255);
 					if (nd < dist[i])
 						dist[i] = nd;
-					
-					// (-1,-1)
-					if (rcGetCon(as, 3) != RC_NOT_CONNECTED)
-					{
-						const int aax = ax + rcGetDirOffsetX(3);
-						const int aay = ay + rcGetDirOffsetY(3);
-						const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 3);
-						nd = (unsigned char)rcMin((int)dist[aai]+3, 255);
-						if (nd < dist[i])
-							dist[i] = nd;
-					}
 				}
-				if (rcGetCon(s, 3) != RC_NOT_CONNECTED)
+			}
+			if (rcGetCon(s, 3) != RC_NOT_CONNECTED)
+			{
+				// (0,-1)
+				const int ax = x + rcGetDirOffsetX(3);
+				const int ay = y + rcGetDirOffsetY(3);
+				const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 3);
+				const rcCompactSpan& as = chf.spans[ai];
+				nd = (unsigned char)rcMin((int)dist[ai]+2, 255);
+				if (nd < dist[i])
+					dist[i] = nd;
+				
+				// (1,-1)
+				if (rcGetCon(as, 2) != RC_NOT_CONNECTED)
 				{
-					// (0,-1)
-					const int ax = x + rcGetDirOffsetX(3);
-					const int ay = y + rcGetDirOffsetY(3);
-					const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 3);
-					const rcCompactSpan& as = chf.spans[ai];
-					nd = (unsigned char)rcMin((int)dist[ai]+2, 255);
+					const int aax = ax + rcGetDirOffsetX(2);
+					const int aay = ay + rcGetDirOffsetY(2);
+					const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 2);
+					nd = (unsigned char)rcMin((int)dist[aai]+3, 255);
 					if (nd < dist[i])
 						dist[i] = nd;
-					
-					// (1,-1)
-					if (rcGetCon(as, 2) != RC_NOT_CONNECTED)
-					{
-						const int aax = ax + rcGetDirOffsetX(2);
-						const int aay = ay + rcGetDirOffsetY(2);
-						const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 2);
-						nd = (unsigned char)rcMin((int)dist[aai]+3, 255);
-						if (nd < dist[i])
-							dist[i] = nd;
-					}
 				}
 			}
 		}
 	}
+}
+
+/// Second erosion pass over cells [x0, x1) of row @p y, right to left, from the (1,0), (1,1), (0,1)
+/// and (-1,1) neighbours.
+static void erodeSweepBackward(const rcCompactHeightfield& chf, unsigned char* dist, const int x0, const int x1, const int y)
+{
+	const int w = chf.width;
+	unsigned char nd;
 	
-	// Pass 2
-	for (int y = h-1; y >= 0; --y)
+	for (int x = x1-1; x >= x0; --x)
 	{
-		for (int x = w-1; x >= 0; --x)
+		const rcCompactCell& c = chf.cells[x+y*w];
+		for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
 		{
-			const rcCompactCell& c = chf.cells[x+y*w];
-			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+			const rcCompactSpan& s = chf.spans[i];
+			
+			if (rcGetCon(s, 2) != RC_NOT_CONNECTED)
 			{
-				const rcCompactSpan& s = chf.spans[i];
+				// (1,0)
+				const int ax = x + rcGetDirOffsetX(2);
+				const int ay = y + rcGetDirOffsetY(2);
+				const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 2);
+				const rcCompactSpan& as = chf.spans[ai];
+				nd = (unsigned char)rcMin((int)dist[ai]+2, 255);
+				if (nd < dist[i])
+					dist[i] = nd;
 				
-				if (rcGetCon(s, 2) != RC_NOT_CONNECTED)
+				// (1,1)
+				if (rcGetCon(as, 1) != RC_NOT_CONNECTED)
 				{
-					// (1,0)
-					const int ax = x + rcGetDirOffsetX(2);
-					const int ay = y + rcGetDirOffsetY(2);
-					const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 2);
-					const rcCompactSpan& as = chf.spans[ai];
-					nd = (unsigned char)rcMin((int)dist[ai]+2, 255);
+					const int aax = ax + rcGetDirOffsetX(1);
+					const int aay = ay + rcGetDirOffsetY(1);
+					const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 1);
+					nd = (unsigned char)rcMin((int)dist[aai]+3, 255);
 					if (nd < dist[i])
 						dist[i] = nd;
-					
-					// (1,1)
-					if (rcGetCon(as, 1) != RC_NOT_CONNECTED)
-					{
-						const int aax = ax + rcGetDirOffsetX(1);
-						const int aay = ay + rcGetDirOffsetY(1);
-						const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 1);
-						nd = (unsigned char)rcMin((int)dist[aai]+3, 255);
-						if (nd < dist[i])
-							dist[i] = nd;
-					}
 				}
-				if (rcGetCon(s, 1) != RC_NOT_CONNECTED)
+			}
+			if (rcGetCon(s, 1) != RC_NOT_CONNECTED)
+			{
+				// (0,1)
+				const int ax = x + rcGetDirOffsetX(1);
+				const int ay = y + rcGetDirOffsetY(1);
+				const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 1);
+				const rcCompactSpan& as = chf.spans[ai];
+				nd = (unsigned char)rcMin((int)dist[ai]+2, 255);
+				if (nd < dist[i])
+					dist[i] = nd;
+				
+				// (-1,1)
+				if (rcGetCon(as, 0) != RC_NOT_CONNECTED)
 				{
-					// (0,1)
-					const int ax = x + rcGetDirOffsetX(1);
-					const int ay = y + rcGetDirOffsetY(1);
-					const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 1);
-					const rcCompactSpan& as = chf.spans[ai];
-					nd = (unsigned char)rcMin((int)dist[ai]+2, 255);
+					const int aax = ax + rcGetDirOffsetX(0);
+					const int aay = ay + rcGetDirOffsetY(0);
+					const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 0);
+					nd = (unsigned char)rcMin((int)dist[aai]+3, 255);
 					if (nd < dist[i])
 						dist[i] = nd;
-					
-					// (-1,1)
-					if (rcGetCon(as, 0) != RC_NOT_CONNECTED)
-					{
-						const int aax = ax + rcGetDirOffsetX(0);
-						const int aay = ay + rcGetDirOffsetY(0);
-						const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 0);
-						nd = (unsigned char)rcMin((int)dist[aai]+3, 255);
-						if (nd < dist[i])
-							dist[i] = nd;
-					}
 				}
 			}
 		}
 	}
+}
+
+/// Clears the area of the spans in rows [y0, y1) that are closer to the boundary than @p thr.
+static void applyErosion(rcCompactHeightfield& chf, const unsigned char* dist, const unsigned char thr, const int y0, const int y1)
+{
+	const int w = chf.width;
 	
-	const unsigned char thr = (unsigned char)(radius*2);
-	for (int i = 0; i < chf.spanCount; ++i)
-		if (dist[i] < thr)
-			chf.areas[i] = RC_NULL_AREA;
-	
-	rcFree(dist);
+	// Walks the cells rather than a span range; empty cells have index 0, so their indices don't bound a row.
+	for (int y = y0; y < y1; ++y)
+	{
+		for (int x = 0; x < w; ++x)
+		{
+			const rcCompactCell& c = chf.cells[x+y*w];
+			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+			{
+				if (dist[i] < thr)
+					chf.areas[i] = RC_NULL_AREA;
+			}
+		}
+	}
+}
+
+/// Rows per band, and columns per block, of the parallel erosion sweeps.
+static const int RC_ERODE_BLOCK_SIZE = 32;
+
+/// Rows handed to each job by the row-parallel area steps.
+static const int RC_AREA_ROW_GRAIN = 8;
+
+namespace
+{
+struct ErodeJob
+{
+	rcCompactHeightfield* chf;
+	unsigned char* dist;
+	unsigned char thr;
+	
+	// Wavefront state.
+	bool backward;
+	int stage;
+	int firstBand;
+	int blockCount;
+};
+}  // namespace
+
+static void markErodeBoundaryJob(void* userData, int begin, int end)
+{
+	const ErodeJob* job = (const ErodeJob*)userData;
+	markErodeBoundarySpans(*job->chf, job->dist, begin, end);
+}
+
+static void applyErosionJob(void* userData, int begin, int end)
+{
+	const ErodeJob* job = (const ErodeJob*)userData;
+	applyErosion(*job->chf, job->dist, job->thr, begin, end);
+}
+
+/// Sweeps the blocks of one wavefront stage, counting bands from job->firstBand.
+///
+/// The erosion sweeps read the same neighbours as the distance field's in RecastRegion.cpp, so they
+/// use the same skewed blocks: (band, block) runs at stage block + band * 2, after every block it
+/// reads from, and each span sees exactly the distances the serial sweep would give it.
+static void erodeSweepJob(void* userData, int begin, int end)
+{
+	const ErodeJob* job = (const ErodeJob*)userData;
+	const rcCompactHeightfield& chf = *job->chf;
+	const int w = chf.width;
+	const int h = chf.height;
 	
-	return true;
+	for (int k = begin; k < end; ++k)
+	{
+		const int band = job->firstBand + k;
+		const int block = job->stage - band*2;
+		
+		for (int r = 0; r < RC_ERODE_BLOCK_SIZE; ++r)
+		{
+			const int y = band*RC_ERODE_BLOCK_SIZE + r;
+			if (y >= h)
+				break;
+			
+			const int x0 = rcMax(block*RC_ERODE_BLOCK_SIZE - r, 0);
+			const int x1 = rcMin((block+1)*RC_ERODE_BLOCK_SIZE - r, w);
+			if (x0 >= x1)
+				continue;
+			
+			// Mirrored columns [x0, x1) are real columns [w-x1, w-x0).
+			if (job->backward)
+				erodeSweepBackward(chf, job->dist, w-x1, w-x0, h-1-y);
+			else
+				erodeSweepForward(chf, job->dist, x0, x1, y);
+		}
+	}
 }
 
-static void insertSort(unsigned char* a, const int n)
+static void erodeSweepParallel(rcContext* ctx, ErodeJob& job)
 {
-	int i, j;
-	for (i = 1; i < n; i++)
+	const int bandCount = (job.chf->height + RC_ERODE_BLOCK_SIZE-1) / RC_ERODE_BLOCK_SIZE;
+	// The last row of a band is skewed by RC_ERODE_BLOCK_SIZE-1 columns.
+	job.blockCount = (job.chf->width + RC_ERODE_BLOCK_SIZE*2 - 2) / RC_ERODE_BLOCK_SIZE;
+	
+	const int stageCount = job.blockCount + (bandCount-1)*2;
+	for (job.stage = 0; job.stage < stageCount; ++job.stage)
 	{
-		const unsigned char value = a[i];
-		for (j = i - 1; j >= 0 && a[j] > value; j--)
-			a[j+1] = a[j];
-		a[j+1] = value;
+		// Bands with block = stage - band*2 in [0, blockCount).
+		job.firstBand = rcMax((job.stage - job.blockCount + 2) / 2, 0);
+		const int lastBand = rcMin(job.stage / 2, bandCount-1);
+		ctx->parallelFor(lastBand - job.firstBand + 1, 1, erodeSweepJob, &job);
 	}
 }
 
-/// @par
-///
-/// This filter is usually applied after applying area id's using functions
-/// such as #rcMarkBoxArea, #rcMarkConvexPolyArea, and #rcMarkCylinderArea.
+/// @par 
 /// 
-/// @see rcCompactHeightfield
-bool rcMedianFilterWalkableArea(rcContext* ctx, rcCompactHeightfield& chf)
+/// Basically, any spans that are closer to a boundary or obstruction than the specified radius 
+/// are marked as unwalkable.
+///
+/// This method is usually called immediately after the heightfield has been built.
+///
+/// @see rcCompactHeightfield, rcBuildCompactHeightfield, rcConfig::walkableRadius
+bool rcErodeWalkableArea(rcContext* ctx, int radius, rcCompactHeightfield& chf)
 {
 	rcAssert(ctx);
 	
 	const int w = chf.width;
 	const int h = chf.height;
 	
-	rcScopedTimer timer(ctx, RC_TIMER_MEDIAN_AREA);
+	rcScopedTimer timer(ctx, RC_TIMER_ERODE_AREA);
 	
-	unsigned char* areas = (unsigned char*)rcAlloc(sizeof(unsigned char)*chf.spanCount, RC_ALLOC_TEMP);
-	if (!areas)
+	unsigned char* dist = (unsigned char*)rcAlloc(sizeof(unsigned char)*chf.spanCount, RC_ALLOC_TEMP);
+	if (!dist)
 	{
-		ctx->log(RC_LOG_ERROR, "medianFilterWalkableArea: Out of memory 'areas' (%d).", chf.spanCount);
+		ctx->log(RC_LOG_ERROR, "erodeWalkableArea: Out of memory 'dist' (%d).", chf.spanCount);
 		return false;
 	}
 	
-	// Init distance.
-	memset(areas, 0xff, sizeof(unsigned char)*chf.spanCount);
+	const unsigned char thr = (unsigned char)(radius*2);
 	
-	for (int y = 0; y < h; ++y)
+	if (ctx->getThreadCount() > 1 && h > RC_ERODE_BLOCK_SIZE)
+	{
+		ErodeJob job;
+		memset(&job, 0, sizeof(job));
+		job.chf = &chf;
+		job.dist = dist;
+		job.thr = thr;
+		
+		ctx->parallelFor(h, RC_AREA_ROW_GRAIN, markErodeBoundaryJob, &job);
+		
+		job.backward = false;
+		erodeSweepParallel(ctx, job);
+		job.backward = true;
+		erodeSweepParallel(ctx, job);
+		
+		ctx->parallelFor(h, RC_AREA_ROW_GRAIN, applyErosionJob, &job);
+	}
+	else
+	{
+		// Init distance and mark boundary cells.
+		markErodeBoundarySpans(chf, dist, 0, h);
+		
+		// Pass 1
+		for (int y = 0; y < h; ++y)
+			erodeSweepForward(chf, dist, 0, w, y);
+		
+		// Pass 2
+		for (int y = h-1; y >= 0; --y)
+			erodeSweepBackward(chf, dist, 0, w, y);
+		
+		applyErosion(chf, dist, thr, 0, h);
+	}
+	
+	rcFree(dist);
+	
+	return true;
+}
+
+/// Spans whose neighbourhoods are sorted together by the median filter.
+static const int RC_MEDIAN_BATCH = 32;
+
+/// Puts the smaller of @p a and @p b in @p a. Branchless, so the loops over a batch vectorize.
+static inline void sortPair(unsigned char& a, unsigned char& b)
+{
+	const unsigned char lo = a < b ? a : b;
+	const unsigned char hi = a < b ? b : a;
+	a = lo;
+	b = hi;
+}
+
+/// Leaves the median of each lane's nine values in nei[4], with the 19-exchange median network
+/// from Paeth's "Median Finding on a 3x3 Grid". That's the same value sorting all nine would put
+/// there, in a fixed sequence of compare-exchanges that runs on every lane at once.
+static void medianOf9(unsigned char nei[9][RC_MEDIAN_BATCH], const int n)
+{
+	static const unsigned char network[19][2] =
+	{
+		{1,2}, {4,5}, {7,8}, {0,1}, {3,4}, {6,7}, {1,2}, {4,5}, {7,8}, {0,3},
+		{5,8}, {4,7}, {3,6}, {1,4}, {2,5}, {4,7}, {4,2}, {6,4}, {4,2},
+	};
+	
+	for (int k = 0; k < 19; ++k)
+	{
+		unsigned char* a = nei[network[k][0]];
+		unsigned char* b = nei[network[k][1]];
+		for (int j = 0; j < n; ++j)
+			sortPair(a[j], b[j]);
+	}
+}
+
+/// Median filters the areas of the spans in rows [y0, y1) of @p chf into @p areas.
+static void medianFilterRows(const rcCompactHeightfield& chf, unsigned char* areas, const int y0, const int y1)
+{
+	const int w = chf.width;
+	
+	// Neighbourhoods are gathered lane by lane, then sorted a batch at a time.
+	unsigned char nei[9][RC_MEDIAN_BATCH];
+	int spanIds[RC_MEDIAN_BATCH];
+	int n = 0;
+	
+	for (int y = y0; y < y1; ++y)
 	{
 		for (int x = 0; x < w; ++x)
 		{
@@ -268,9 +418,8 @@ bool rcMedianFilterWalkableArea(rcContext* ctx, rcCompactHeightfield& chf)
 					continue;
 				}
 				
-				unsigned char nei[9];
 				for (int j = 0; j < 9; ++j)
-					nei[j] = chf.areas[i];
+					nei[j][n] = chf.areas[i];
 				
 				for (int dir = 0; dir < 4; ++dir)
 				{
@@ -280,7 +429,7 @@ bool rcMedianFilterWalkableArea(rcContext* ctx, rcCompactHeightfield& chf)
 						const int ay = y + rcGetDirOffsetY(dir);
 						const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, dir);
 						if (chf.areas[ai] != RC_NULL_AREA)
-							nei[dir*2+0] = chf.areas[ai];
+							nei[dir*2+0][n] = chf.areas[ai];
 						
 						const rcCompactSpan& as = chf.spans[ai];
 						const int dir2 = (dir+1) & 0x3;
@@ -290,16 +439,77 @@ bool rcMedianFilterWalkableArea(rcContext* ctx, rcCompactHeightfield& chf)
 							const int ay2 = ay + rcGetDirOffsetY(dir2);
 							const int ai2 = (int)chf.cells[ax2+ay2*w].index + rcGetCon(as, dir2);
 							if (chf.areas[ai2] != RC_NULL_AREA)
-								nei[dir*2+1] = chf.areas[ai2];
+								nei[dir*2+1][n] = chf.areas[ai2];
 						}
 					}
 				}
-				insertSort(nei, 9);
-				areas[i] = nei[4];
+				
+				spanIds[n++] = i;
+				if (n == RC_MEDIAN_BATCH)
+				{
+					medianOf9(nei, n);
+					for (int j = 0; j < n; ++j)
+						areas[spanIds[j]] = nei[4][j];
+					n = 0;
+				}
 			}
 		}
 	}
 	
+	medianOf9(nei, n);
+	for (int j = 0; j < n; ++j)
+		areas[spanIds[j]] = nei[4][j];
+}
+
+namespace
+{
+struct MedianFilterJob
+{
+	const rcCompactHeightfield* chf;
+	unsigned char* areas;
+};
+}  // namespace
+
+static void medianFilterJob(void* userData, int begin, int end)
+{
+	const MedianFilterJob* job = (const MedianFilterJob*)userData;
+	medianFilterRows(*job->chf, job->areas, begin, end);
+}
+
+/// @par
+///
+/// This filter is usually applied after applying area id's using functions
+/// such as #rcMarkBoxArea, #rcMarkConvexPolyArea, and #rcMarkCylinderArea.
+/// 
+/// @see rcCompactHeightfield
+bool rcMedianFilterWalkableArea(rcContext* ctx, rcCompactHeightfield& chf)
+{
+	rcAssert(ctx);
+	
+	const int h = chf.height;
+	
+	rcScopedTimer timer(ctx, RC_TIMER_MEDIAN_AREA);
+	
+	unsigned char* areas = (unsigned char*)rcAlloc(sizeof(unsigned char)*chf.spanCount, RC_ALLOC_TEMP);
+	if (!areas)
+	{
+		ctx->log(RC_LOG_ERROR, "medianFilterWalkableArea: Out of memory 'areas' (%d).", chf.spanCount);
+		return false;
+	}
+	
+	// Every span is written, and reads only come from chf.areas, so rows can be filtered in any order.
+	if (ctx->getThreadCount() > 1 && h > RC_AREA_ROW_GRAIN)
+	{
+		MedianFilterJob job;
+		job.chf = &chf;
+		job.areas = areas;
+		ctx->parallelFor(h, RC_AREA_ROW_GRAIN, medianFilterJob, &job);
+	}
+	else
+	{
+		medianFilterRows(chf, areas, 0, h);
+	}
+	
 	memcpy(chf.areas, areas, sizeof(unsigned char)*chf.spanCount);
 	
 	rcFree(areas);
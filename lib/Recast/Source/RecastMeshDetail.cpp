@@ -1162,10 +1162,321 @@ static unsigned char getTriFlags(const float* va, const float* vb, const float*
 	return flags;
 }
 
+namespace
+{
+/// Working memory for building the detail meshes of polygons one at a time.
+struct PolyDetailScratch
+{
+	PolyDetailScratch() : edges(64), tris(512), arr(512), samples(512), poly(0) {}
+	~PolyDetailScratch() { rcFree(poly); }
+	
+	rcIntArray edges;
+	rcIntArray tris;
+	rcIntArray arr;
+	rcIntArray samples;
+	float verts[256*3];
+	float* poly;
+	rcHeightPatch hp;
+	
+private:
+	// Explicitly disabled copy constructor and copy assignment operator.
+	PolyDetailScratch(const PolyDetailScratch&);
+	PolyDetailScratch& operator=(const PolyDetailScratch&);
+};
+
+/// Keeps the messages logged from a parallel job, to pass them on to the real context in order afterwards.
+class DeferredLogContext : public rcContext
+{
+public:
+	DeferredLogContext() : rcContext(true) {}
+	
+	void replay(rcContext* ctx) const
+	{
+		for (int i = 0; i < (int)m_categories.size(); ++i)
+			ctx->log(m_categories[i], "%s", &m_text[m_offsets[i]]);
+	}
+	
+protected:
+	virtual void doLog(const rcLogCategory category, const char* msg, const int len)
+	{
+		m_categories.push_back(category);
+		m_offsets.push_back((int)m_text.size());
+		for (int i = 0; i < len; ++i)
+			m_text.push_back(msg[i]);
+		m_text.push_back('\0');
+	}
+	
+private:
+	rcTempVector<rcLogCategory> m_categories;
+	rcTempVector<int> m_offsets;
+	rcTempVector<char> m_text;
+};
+
+/// The detail meshes of a range of consecutive polygons, built by one parallel job.
+struct PolyDetailRange
+{
+	PolyDetailRange() : ok(true) {}
+	
+	DeferredLogContext messages;
+	rcTempVector<float> verts;
+	rcTempVector<unsigned char> tris;
+	bool ok;
+};
+
+struct PolyDetailJob
+{
+	const rcPolyMesh* mesh;
+	const rcCompactHeightfield* chf;
+	const int* bounds;
+	float sampleDist;
+	float sampleMaxError;
+	int heightSearchRadius;
+	int maxhw, maxhh;
+	int polysPerRange;
+	PolyDetailRange* ranges;
+	unsigned int* meshes;
+};
+}  // namespace
+
+static bool allocPolyDetailScratch(rcContext* ctx, const int nvp, const int maxhw, const int maxhh, PolyDetailScratch& scratch)
+{
+	scratch.poly = (float*)rcAlloc(sizeof(float)*nvp*3, RC_ALLOC_TEMP);
+	if (!scratch.poly)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'poly' (%d).", nvp*3);
+		return false;
+	}
+	scratch.hp.data = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxhw*maxhh, RC_ALLOC_TEMP);
+	if (!scratch.hp.data)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'hp.data' (%d).", maxhw*maxhh);
+		return false;
+	}
+	return true;
+}
+
+/// Builds the detail mesh of polygon @p i into scratch.verts, in world space, and scratch.tris,
+/// with the triangle's edge flags in the fourth element of each triangle.
+static bool buildPolyDetailMesh(rcContext* ctx, const rcPolyMesh& mesh, const rcCompactHeightfield& chf,
+								const int* bounds, const int i,
+								const float sampleDist, const float sampleMaxError, const int heightSearchRadius,
+								PolyDetailScratch& scratch, int& nverts)
+{
+	const int nvp = mesh.nvp;
+	const float cs = mesh.cs;
+	const float ch = mesh.ch;
+	const float* orig = mesh.bmin;
+	const unsigned short* p = &mesh.polys[i*nvp*2];
+	float* poly = scratch.poly;
+	float* verts = scratch.verts;
+	rcHeightPatch& hp = scratch.hp;
+	
+	// Store polygon vertices for processing.
+	int npoly = 0;
+	for (int j = 0; j < nvp; ++j)
+	{
+		if(p[j] == RC_MESH_NULL_IDX) break;
+		const unsigned short* v = &mesh.verts[p[j]*3];
+		poly[j*3+0] = v[0]*cs;
+		poly[j*3+1] = v[1]*ch;
+		poly[j*3+2] = v[2]*cs;
+		npoly++;
+	}
+	
+	// Get the height data from the area of the polygon.
+	hp.xmin = bounds[i*4+0];
+	hp.ymin = bounds[i*4+2];
+	hp.width = bounds[i*4+1]-bounds[i*4+0];
+	hp.height = bounds[i*4+3]-bounds[i*4+2];
+	getHeightData(ctx, chf, p, npoly, mesh.verts, mesh.borderSize, hp, scratch.arr, mesh.regs[i]);
+	
+	// Build detail mesh.
+	nverts = 0;
+	if (!buildPolyDetail(ctx, poly, npoly,
+						 sampleDist, sampleMaxError,
+						 heightSearchRadius, chf, hp,
+						 verts, nverts, scratch.tris,
+						 scratch.edges, scratch.samples))
+	{
+		return false;
+	}
+	
+	// Move detail verts to world space.
+	for (int j = 0; j < nverts; ++j)
+	{
+		verts[j*3+0] += orig[0];
+		verts[j*3+1] += orig[1] + chf.ch; // Is this offset necessary?
+		verts[j*3+2] += orig[2];
+	}
+	// Offset poly too, will be used to flag checking.
+	for (int j = 0; j < npoly; ++j)
+	{
+		poly[j*3+0] += orig[0];
+		poly[j*3+1] += orig[1];
+		poly[j*3+2] += orig[2];
+	}
+	
+	rcIntArray& tris = scratch.tris;
+	const int ntris = tris.size()/4;
+	for (int j = 0; j < ntris; ++j)
+	{
+		int* t = &tris[j*4];
+		t[3] = getTriFlags(&verts[t[0]*3], &verts[t[1]*3], &verts[t[2]*3], poly, npoly);
+	}
+	
+	return true;
+}
+
+/// Grows @p v, geometrically, to fit @p count more elements.
+template<typename T>
+static bool reserveMore(rcTempVector<T>& v, const int count)
+{
+	const rcSizeType size = v.size() + count;
+	if (size <= v.capacity())
+		return true;
+	return v.reserve(rcMax(size, v.capacity()*2));
+}
+
+/// Builds the detail meshes of a range of polygons into PolyDetailRange::verts and tris,
+/// and their vertex and triangle counts into the output meshes.
+static void buildPolyDetailRange(void* userData, int begin, int end)
+{
+	const PolyDetailJob* job = (const PolyDetailJob*)userData;
+	const rcPolyMesh& mesh = *job->mesh;
+	
+	for (int r = begin; r < end; ++r)
+	{
+		PolyDetailRange& range = job->ranges[r];
+		
+		PolyDetailScratch scratch;
+		if (!allocPolyDetailScratch(&range.messages, mesh.nvp, job->maxhw, job->maxhh, scratch))
+		{
+			range.ok = false;
+			continue;
+		}
+		
+		const int first = r*job->polysPerRange;
+		const int last = rcMin(first + job->polysPerRange, mesh.npolys);
+		for (int i = first; i < last; ++i)
+		{
+			int nverts = 0;
+			if (!buildPolyDetailMesh(&range.messages, mesh, *job->chf, job->bounds, i,
+									 job->sampleDist, job->sampleMaxError, job->heightSearchRadius,
+									 scratch, nverts))
+			{
+				range.ok = false;
+				break;
+			}
+			
+			const int ntris = scratch.tris.size()/4;
+			if (!reserveMore(range.verts, nverts*3) || !reserveMore(range.tris, ntris*4))
+			{
+				range.messages.log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'range' (%d).", i);
+				range.ok = false;
+				break;
+			}
+			
+			job->meshes[i*4+1] = (unsigned int)nverts;
+			job->meshes[i*4+3] = (unsigned int)ntris;
+			
+			for (int j = 0; j < nverts*3; ++j)
+				range.verts.push_back(scratch.verts[j]);
+			for (int j = 0; j < ntris*4; ++j)
+				range.tris.push_back((unsigned char)scratch.tris[j]);
+		}
+	}
+}
+
+/// Builds the polygons' detail meshes across ctx->parallelFor, in ranges of consecutive polygons,
+/// then packs the ranges into @p dmesh in order. The result is the same as building them one by one.
+static bool buildPolyMeshDetailParallel(rcContext* ctx, const rcPolyMesh& mesh, const rcCompactHeightfield& chf,
+										const int* bounds, const float sampleDist, const float sampleMaxError,
+										const int heightSearchRadius, const int maxhw, const int maxhh,
+										rcPolyMeshDetail& dmesh)
+{
+	// A few ranges per thread, so a range of expensive polygons doesn't hold up the rest.
+	const int polysPerRange = rcMax(1, (mesh.npolys + ctx->getThreadCount()*4 - 1) / (ctx->getThreadCount()*4));
+	const int nranges = (mesh.npolys + polysPerRange - 1) / polysPerRange;
+	
+	rcTempVector<PolyDetailRange> ranges;
+	ranges.resize(nranges);
+	if ((int)ranges.size() != nranges || !ranges.data())
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'ranges' (%d).", nranges);
+		return false;
+	}
+	
+	PolyDetailJob job;
+	job.mesh = &mesh;
+	job.chf = &chf;
+	job.bounds = bounds;
+	job.sampleDist = sampleDist;
+	job.sampleMaxError = sampleMaxError;
+	job.heightSearchRadius = heightSearchRadius;
+	job.maxhw = maxhw;
+	job.maxhh = maxhh;
+	job.polysPerRange = polysPerRange;
+	job.ranges = ranges.data();
+	job.meshes = dmesh.meshes;
+	
+	ctx->parallelFor(nranges, 1, buildPolyDetailRange, &job);
+	
+	// Pass on the messages up to the first failure, as if the polygons had been built in order.
+	int nverts = 0;
+	int ntris = 0;
+	for (int r = 0; r < nranges; ++r)
+	{
+		ranges[r].messages.replay(ctx);
+		if (!ranges[r].ok)
+			return false;
+		nverts += (int)ranges[r].verts.size()/3;
+		ntris += (int)ranges[r].tris.size()/4;
+	}
+	
+	dmesh.verts = (float*)rcAlloc(sizeof(float)*rcMax(nverts, 1)*3, RC_ALLOC_PERM);
+	if (!dmesh.verts)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.verts' (%d).", nverts*3);
+		return false;
+	}
+	dmesh.tris = (unsigned char*)rcAlloc(sizeof(unsigned char)*rcMax(ntris, 1)*4, RC_ALLOC_PERM);
+	if (!dmesh.tris)
+	{
+		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'dmesh.tris' (%d).", ntris*4);
+		return false;
+	}
+	
+	// Prefix sums of the counts give each submesh's offsets.
+	for (int i = 0; i < mesh.npolys; ++i)
+	{
+		dmesh.meshes[i*4+0] = (unsigned int)dmesh.nverts;
+		dmesh.meshes[i*4+2] = (unsigned int)dmesh.ntris;
+		dmesh.nverts += (int)dmesh.meshes[i*4+1];
+		dmesh.ntris += (int)dmesh.meshes[i*4+3];
+	}
+	
+	float* dstVerts = dmesh.verts;
+	unsigned char* dstTris = dmesh.tris;
+	for (int r = 0; r < nranges; ++r)
+	{
+		const PolyDetailRange& range = ranges[r];
+		if (range.verts.size())
+			memcpy(dstVerts, range.verts.data(), sizeof(float)*range.verts.size());
+		if (range.tris.size())
+			memcpy(dstTris, range.tris.data(), sizeof(unsigned char)*range.tris.size());
+		dstVerts += range.verts.size();
+		dstTris += range.tris.size();
+	}
+	
+	return true;
+}
+
 /// @par
 ///
 /// See the #rcConfig documentation for more information on the configuration parameters.
 ///
+/// The polygons are built in parallel through rcContext::parallelFor when the context has more than one thread.
+///
 /// @see rcAllocPolyMeshDetail, rcPolyMesh, rcCompactHeightfield, rcPolyMeshDetail, rcConfig
 bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompactHeightfield& chf,
 						   const float sampleDist, const float sampleMaxError,
@@ -1179,18 +1490,8 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 		return true;
 	
 	const int nvp = mesh.nvp;
-	const float cs = mesh.cs;
-	const float ch = mesh.ch;
-	const float* orig = mesh.bmin;
-	const int borderSize = mesh.borderSize;
 	const int heightSearchRadius = rcMax(1, (int)ceilf(mesh.maxEdgeError));
 	
-	rcIntArray edges(64);
-	rcIntArray tris(512);
-	rcIntArray arr(512);
-	rcIntArray samples(512);
-	float verts[256*3];
-	rcHeightPatch hp;
 	int nPolyVerts = 0;
 	int maxhw = 0, maxhh = 0;
 	
@@ -1200,12 +1501,6 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'bounds' (%d).", mesh.npolys*4);
 		return false;
 	}
-	rcScopedDelete<float> poly((float*)rcAlloc(sizeof(float)*nvp*3, RC_ALLOC_TEMP));
-	if (!poly)
-	{
-		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'poly' (%d).", nvp*3);
-		return false;
-	}
 	
 	// Find max size for a polygon area.
 	for (int i = 0; i < mesh.npolys; ++i)
@@ -1238,13 +1533,6 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 		maxhh = rcMax(maxhh, ymax-ymin);
 	}
 	
-	hp.data = (unsigned short*)rcAlloc(sizeof(unsigned short)*maxhw*maxhh, RC_ALLOC_TEMP);
-	if (!hp.data)
-	{
-		ctx->log(RC_LOG_ERROR, "rcBuildPolyMeshDetail: Out of memory 'hp.data' (%d).", maxhw*maxhh);
-		return false;
-	}
-	
 	dmesh.nmeshes = mesh.npolys;
 	dmesh.nverts = 0;
 	dmesh.ntris = 0;
@@ -1255,6 +1543,16 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 		return false;
 	}
 	
+	if (ctx->getThreadCount() > 1 && mesh.npolys > 1)
+	{
+		return buildPolyMeshDetailParallel(ctx, mesh, chf, bounds, sampleDist, sampleMaxError,
+										   heightSearchRadius, maxhw, maxhh, dmesh);
+	}
+	
+	PolyDetailScratch scratch;
+	if (!allocPolyDetailScratch(ctx, nvp, maxhw, maxhh, scratch))
+		return false;
+	
 	int vcap = nPolyVerts+nPolyVerts/2;
 	int tcap = vcap*2;
 	
@@ -1275,52 +1573,16 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 	
 	for (int i = 0; i < mesh.npolys; ++i)
 	{
-		const unsigned short* p = &mesh.polys[i*nvp*2];
-		
-		// Store polygon vertices for processing.
-		int npoly = 0;
-		for (int j = 0; j < nvp; ++j)
-		{
-			if(p[j] == RC_MESH_NULL_IDX) break;
-			const unsigned short* v = &mesh.verts[p[j]*3];
-			poly[j*3+0] = v[0]*cs;
-			poly[j*3+1] = v[1]*ch;
-			poly[j*3+2] = v[2]*cs;
-			npoly++;
-		}
-		
-		// Get the height data from the area of the polygon.
-		hp.xmin = bounds[i*4+0];
-		hp.ymin = bounds[i*4+2];
-		hp.width = bounds[i*4+1]-bounds[i*4+0];
-		hp.height = bounds[i*4+3]-bounds[i*4+2];
-		getHeightData(ctx, chf, p, npoly, mesh.verts, borderSize, hp, arr, mesh.regs[i]);
-		
-		// Build detail mesh.
 		int nverts = 0;
-		if (!buildPolyDetail(ctx, poly, npoly,
-							 sampleDist, sampleMaxError,
-							 heightSearchRadius, chf, hp,
-							 verts, nverts, tris,
-							 edges, samples))
+		if (!buildPolyDetailMesh(ctx, mesh, chf, bounds, i,
+								 sampleDist, sampleMaxError, heightSearchRadius,
+								 scratch, nverts))
 		{
 			return false;
 		}
 		
-		// Move detail verts to world space.
-		for (int j = 0; j < nverts; ++j)
-		{
-			verts[j*3+0] += orig[0];
-			verts[j*3+1] += orig[1] + chf.ch; // Is this offset necessary?
-			verts[j*3+2] += orig[2];
-		}
-		// Offset poly too, will be used to flag checking.
-		for (int j = 0; j < npoly; ++j)
-		{
-			poly[j*3+0] += orig[0];
-			poly[j*3+1] += orig[1];
-			poly[j*3+2] += orig[2];
-		}
+		const float* verts = scratch.verts;
+		rcIntArray& tris = scratch.tris;
 		
 		// Store detail submesh.
 		const int ntris = tris.size()/4;
@@ -1377,7 +1639,7 @@ bool rcBuildPolyMeshDetail(rcContext* ctx, const rcPolyMesh& mesh, const rcCompa
 			dmesh.tris[dmesh.ntris*4+0] = (unsigned char)t[0];
 			dmesh.tris[dmesh.ntris*4+1] = (unsigned char)t[1];
 			dmesh.tris[dmesh.ntris*4+2] = (unsigned char)t[2];
-			dmesh.tris[dmesh.ntris*4+3] = getTriFlags(&verts[t[0]*3], &verts[t[1]*3], &verts[t[2]*3], poly, npoly);
+			dmesh.tris[dmesh.ntris*4+3] = (unsigned char)t[3];
 			dmesh.ntris++;
 		}
 	}
@@ -21,6 +21,11 @@
 #include "Recast.h"
 #include "RecastAlloc.h"
 #include "RecastAssert.h"
+#include "RecastRasterizationSIMD.h"
+
+#if RC_RASTER_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 /// Check whether two bounding boxes overlap
 ///
@@ -455,6 +460,254 @@ static bool rasterizeTri(const float* v0, const float* v1, const float* v2,
 	return true;
 }
 
+static bool cpuSupportsRasterizationPath(rcRasterizationPath path)
+{
+	if (path == RC_RASTER_SCALAR)
+	{
+		return true;
+	}
+
+#if RC_RASTER_X86
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	const int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	const bool sse41 = (info[2] & (1 << 19)) != 0;
+	if (path == RC_RASTER_SSE41)
+	{
+		return sse41;
+	}
+
+	// AVX2 also needs the OS to save the YMM registers.
+	const bool avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+	if (!sse41 || !avx || maxLeaf < 7 || (_xgetbv(0) & 6) != 6)
+	{
+		return false;
+	}
+
+	__cpuidex(info, 7, 0);
+	return path == RC_RASTER_AVX2 && (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	if (path == RC_RASTER_SSE41)
+	{
+		return __builtin_cpu_supports("sse4.1") != 0;
+	}
+	return path == RC_RASTER_AVX2 && __builtin_cpu_supports("avx2") != 0;
+#endif
+#else
+	return false;
+#endif
+}
+
+struct rcRasterFuncs
+{
+	rcRasterBatchFunc* batch;
+	rcRasterTriFunc* tri;
+};
+
+static rcRasterFuncs getRasterFuncs(rcRasterizationPath path)
+{
+	rcRasterFuncs funcs = { NULL, NULL };
+#if RC_RASTER_X86
+	if (path == RC_RASTER_SSE41)
+	{
+		funcs.batch = rcRasterizeBatchSSE41;
+		funcs.tri = rcRasterizeTriSSE41;
+	}
+	else if (path == RC_RASTER_AVX2)
+	{
+		funcs.batch = rcRasterizeBatchAVX2;
+		funcs.tri = rcRasterizeTriAVX2;
+	}
+#else
+	rcIgnoreUnused(path);
+#endif
+	return funcs;
+}
+
+static rcRasterizationPath getBestRasterizationPath()
+{
+	if (cpuSupportsRasterizationPath(RC_RASTER_AVX2))
+	{
+		return RC_RASTER_AVX2;
+	}
+	if (cpuSupportsRasterizationPath(RC_RASTER_SSE41))
+	{
+		return RC_RASTER_SSE41;
+	}
+	return RC_RASTER_SCALAR;
+}
+
+static rcRasterizationPath s_rasterPath = getBestRasterizationPath();
+static rcRasterFuncs s_rasterFuncs = getRasterFuncs(s_rasterPath);
+
+bool rcIsRasterizationPathSupported(rcRasterizationPath path)
+{
+	return cpuSupportsRasterizationPath(path);
+}
+
+bool rcSetRasterizationPath(rcRasterizationPath path)
+{
+	if (!cpuSupportsRasterizationPath(path))
+	{
+		return false;
+	}
+
+	s_rasterPath = path;
+	s_rasterFuncs = getRasterFuncs(path);
+	return true;
+}
+
+rcRasterizationPath rcGetRasterizationPath()
+{
+	return s_rasterPath;
+}
+
+/// Vertices of triangles given as indices into a vertex array.
+template<typename IndexType>
+struct rcIndexedTris
+{
+	const float* verts;
+	const IndexType* tris;
+
+	rcIndexedTris(const float* verts_, const IndexType* tris_) : verts(verts_), tris(tris_) {}
+
+	void get(const int triIndex, const float*& v0, const float*& v1, const float*& v2) const
+	{
+		v0 = &verts[tris[triIndex * 3 + 0] * 3];
+		v1 = &verts[tris[triIndex * 3 + 1] * 3];
+		v2 = &verts[tris[triIndex * 3 + 2] * 3];
+	}
+};
+
+/// Vertices of triangles given as three sequential vertices each.
+struct rcTriangleList
+{
+	const float* verts;
+
+	explicit rcTriangleList(const float* verts_) : verts(verts_) {}
+
+	void get(const int triIndex, const float*& v0, const float*& v1, const float*& v2) const
+	{
+		v0 = &verts[(triIndex * 3 + 0) * 3];
+		v1 = &verts[(triIndex * 3 + 1) * 3];
+		v2 = &verts[(triIndex * 3 + 2) * 3];
+	}
+};
+
+struct rcRasterSpanTarget
+{
+	rcHeightfield* hf;
+	unsigned char areaID;
+	int flagMergeThreshold;
+};
+
+static bool addRasterSpan(void* user, int x, int z, unsigned short spanMin, unsigned short spanMax)
+{
+	rcRasterSpanTarget* target = (rcRasterSpanTarget*)user;
+	return addSpan(*target->hf, x, z, spanMin, spanMax, target->areaID, target->flagMergeThreshold);
+}
+
+/// Rasterizes a set of triangles, in order, through the selected code path.
+///
+/// The batch kernels resolve triangles that fit in one cell several at a time. The rest are clipped
+/// one at a time in the original order, so the spans come out exactly as from the scalar path.
+template<typename TriSource>
+static bool rasterizeTris(const TriSource& source, const unsigned char* triAreaIDs, const int numTris,
+                          rcHeightfield& hf, const int flagMergeThreshold)
+{
+	const float inverseCellSize = 1.0f / hf.cs;
+	const float inverseCellHeight = 1.0f / hf.ch;
+
+	rcRasterBatchParams params;
+	rcVcopy(params.bmin, hf.bmin);
+	rcVcopy(params.bmax, hf.bmax);
+	params.cellSize = hf.cs;
+	params.inverseCellSize = inverseCellSize;
+	params.inverseCellHeight = inverseCellHeight;
+	params.by = hf.bmax[1] - hf.bmin[1];
+	params.width = hf.width;
+	params.height = hf.height;
+
+	// The kernels' span heights have to stay well inside int range to convert like the scalar casts.
+	rcRasterFuncs funcs = s_rasterFuncs;
+	if (hf.width <= 0 || hf.height <= 0 || !(params.by * inverseCellHeight < 1073741824.0f))
+	{
+		funcs.batch = NULL;
+	}
+
+	if (funcs.batch == NULL)
+	{
+		for (int triIndex = 0; triIndex < numTris; ++triIndex)
+		{
+			const float* v0;
+			const float* v1;
+			const float* v2;
+			source.get(triIndex, v0, v1, v2);
+			if (!rasterizeTri(v0, v1, v2, triAreaIDs[triIndex], hf, hf.bmin, hf.bmax, hf.cs, inverseCellSize, inverseCellHeight, flagMergeThreshold))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	const float* batchVerts[RC_RASTER_BATCH_SIZE * 3];
+	rcRasterBatchResult result;
+
+	rcRasterSpanTarget target;
+	target.hf = &hf;
+	target.flagMergeThreshold = flagMergeThreshold;
+
+	for (int first = 0; first < numTris; first += RC_RASTER_BATCH_SIZE)
+	{
+		const int count = rcMin(numTris - first, RC_RASTER_BATCH_SIZE);
+		for (int i = 0; i < count; ++i)
+		{
+			source.get(first + i, batchVerts[i * 3 + 0], batchVerts[i * 3 + 1], batchVerts[i * 3 + 2]);
+		}
+
+		funcs.batch(params, batchVerts, count, result);
+
+		for (int i = 0; i < count; ++i)
+		{
+			const unsigned bit = 1u << i;
+			const unsigned char areaID = triAreaIDs[first + i];
+
+			if (result.spanMask & bit)
+			{
+				if (!addSpan(hf, result.x[i], result.z[i], (unsigned short)result.smin[i], (unsigned short)result.smax[i], areaID, flagMergeThreshold))
+				{
+					return false;
+				}
+			}
+			else if (!(result.handledMask & bit))
+			{
+				const float* v0 = batchVerts[i * 3 + 0];
+				const float* v1 = batchVerts[i * 3 + 1];
+				const float* v2 = batchVerts[i * 3 + 2];
+
+				target.areaID = areaID;
+				const int triResult = funcs.tri(v0, v1, v2, params, addRasterSpan, &target);
+				if (triResult == RC_RASTER_TRI_FAILED)
+				{
+					return false;
+				}
+				if (triResult == RC_RASTER_TRI_UNHANDLED &&
+				    !rasterizeTri(v0, v1, v2, areaID, hf, hf.bmin, hf.bmax, hf.cs, inverseCellSize, inverseCellHeight, flagMergeThreshold))
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
 bool rcRasterizeTriangle(rcContext* context,
                          const float* v0, const float* v1, const float* v2,
                          const unsigned char areaID, rcHeightfield& heightfield, const int flagMergeThreshold)
@@ -485,18 +738,10 @@ bool rcRasterizeTriangles(rcContext* context,
 	rcScopedTimer timer(context, RC_TIMER_RASTERIZE_TRIANGLES);
 	
 	// Rasterize the triangles.
-	const float inverseCellSize = 1.0f / heightfield.cs;
-	const float inverseCellHeight = 1.0f / heightfield.ch;
-	for (int triIndex = 0; triIndex < numTris; ++triIndex)
+	if (!rasterizeTris(rcIndexedTris<int>(verts, tris), triAreaIDs, numTris, heightfield, flagMergeThreshold))
 	{
-		const float* v0 = &verts[tris[triIndex * 3 + 0] * 3];
-		const float* v1 = &verts[tris[triIndex * 3 + 1] * 3];
-		const float* v2 = &verts[tris[triIndex * 3 + 2] * 3];
-		if (!rasterizeTri(v0, v1, v2, triAreaIDs[triIndex], heightfield, heightfield.bmin, heightfield.bmax, heightfield.cs, inverseCellSize, inverseCellHeight, flagMergeThreshold))
-		{
-			context->log(RC_LOG_ERROR, "rcRasterizeTriangles: Out of memory.");
-			return false;
-		}
+		context->log(RC_LOG_ERROR, "rcRasterizeTriangles: Out of memory.");
+		return false;
 	}
 
 	return true;
@@ -512,18 +757,10 @@ bool rcRasterizeTriangles(rcContext* context,
 	rcScopedTimer timer(context, RC_TIMER_RASTERIZE_TRIANGLES);
 
 	// Rasterize the triangles.
-	const float inverseCellSize = 1.0f / heightfield.cs;
-	const float inverseCellHeight = 1.0f / heightfield.ch;
-	for (int triIndex = 0; triIndex < numTris; ++triIndex)
+	if (!rasterizeTris(rcIndexedTris<unsigned short>(verts, tris), triAreaIDs, numTris, heightfield, flagMergeThreshold))
 	{
-		const float* v0 = &verts[tris[triIndex * 3 + 0] * 3];
-		const float* v1 = &verts[tris[triIndex * 3 + 1] * 3];
-		const float* v2 = &verts[tris[triIndex * 3 + 2] * 3];
-		if (!rasterizeTri(v0, v1, v2, triAreaIDs[triIndex], heightfield, heightfield.bmin, heightfield.bmax, heightfield.cs, inverseCellSize, inverseCellHeight, flagMergeThreshold))
-		{
-			context->log(RC_LOG_ERROR, "rcRasterizeTriangles: Out of memory.");
-			return false;
-		}
+		context->log(RC_LOG_ERROR, "rcRasterizeTriangles: Out of memory.");
+		return false;
 	}
 
 	return true;
@@ -538,18 +775,10 @@ bool rcRasterizeTriangles(rcContext* context,
 	rcScopedTimer timer(context, RC_TIMER_RASTERIZE_TRIANGLES);
 	
 	// Rasterize the triangles.
-	const float inverseCellSize = 1.0f / heightfield.cs;
-	const float inverseCellHeight = 1.0f / heightfield.ch;
-	for (int triIndex = 0; triIndex < numTris; ++triIndex)
+	if (!rasterizeTris(rcTriangleList(verts), triAreaIDs, numTris, heightfield, flagMergeThreshold))
 	{
-		const float* v0 = &verts[(triIndex * 3 + 0) * 3];
-		const float* v1 = &verts[(triIndex * 3 + 1) * 3];
-		const float* v2 = &verts[(triIndex * 3 + 2) * 3];
-		if (!rasterizeTri(v0, v1, v2, triAreaIDs[triIndex], heightfield, heightfield.bmin, heightfield.bmax, heightfield.cs, inverseCellSize, inverseCellHeight, flagMergeThreshold))
-		{
-			context->log(RC_LOG_ERROR, "rcRasterizeTriangles: Out of memory.");
-			return false;
-		}
+		context->log(RC_LOG_ERROR, "rcRasterizeTriangles: Out of memory.");
+		return false;
 	}
 
 	return true;
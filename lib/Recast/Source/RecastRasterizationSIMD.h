@@ -0,0 +1,88 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifndef RECASTRASTERIZATIONSIMD_H
+#define RECASTRASTERIZATIONSIMD_H
+
+// Internal to the rasterizer: the batched kernels live in their own files so only they are
+// compiled with the wider instruction sets, and get picked at runtime.
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define RC_RASTER_X86 1
+#else
+#define RC_RASTER_X86 0
+#endif
+
+/// Triangles handed to a kernel at once.
+static const int RC_RASTER_BATCH_SIZE = 8;
+
+/// Heightfield constants, computed the same way rasterizeTri computes them.
+struct rcRasterBatchParams
+{
+	float bmin[3];
+	float bmax[3];
+	float cellSize;
+	float inverseCellSize;
+	float inverseCellHeight;
+	float by;
+	int width;
+	int height;
+};
+
+/// Kernel output for one batch. Lanes in @p handledMask were fully resolved: the ones also in
+/// @p spanMask produce exactly one span, the others none. Everything else goes through rasterizeTri.
+struct rcRasterBatchResult
+{
+	unsigned handledMask;
+	unsigned spanMask;
+	int x[RC_RASTER_BATCH_SIZE];
+	int z[RC_RASTER_BATCH_SIZE];
+	int smin[RC_RASTER_BATCH_SIZE];
+	int smax[RC_RASTER_BATCH_SIZE];
+};
+
+/// @param[in]	tris	Three vertex pointers per triangle. [(v0, v1, v2) * @p count]
+/// @param[in]	count	Number of triangles. [Limit: <= #RC_RASTER_BATCH_SIZE]
+typedef void (rcRasterBatchFunc)(const rcRasterBatchParams& params, const float* const* tris, int count, rcRasterBatchResult& result);
+
+/// Receives the spans of one triangle, in the order rasterizeTri would add them.
+/// @returns False to stop, if the span couldn't be added.
+typedef bool (rcRasterSpanSink)(void* user, int x, int z, unsigned short spanMin, unsigned short spanMax);
+
+enum rcRasterTriResult
+{
+	RC_RASTER_TRI_DONE,
+	RC_RASTER_TRI_FAILED,		///< The sink returned false.
+	RC_RASTER_TRI_UNHANDLED,	///< Needs rasterizeTri.
+};
+
+/// rasterizeTri for a single triangle, with vector clipping.
+typedef int (rcRasterTriFunc)(const float* v0, const float* v1, const float* v2, const rcRasterBatchParams& params,
+                              rcRasterSpanSink* sink, void* user);
+
+#if RC_RASTER_X86
+void rcRasterizeBatchSSE41(const rcRasterBatchParams& params, const float* const* tris, int count, rcRasterBatchResult& result);
+int rcRasterizeTriSSE41(const float* v0, const float* v1, const float* v2, const rcRasterBatchParams& params,
+                        rcRasterSpanSink* sink, void* user);
+
+void rcRasterizeBatchAVX2(const rcRasterBatchParams& params, const float* const* tris, int count, rcRasterBatchResult& result);
+int rcRasterizeTriAVX2(const float* v0, const float* v1, const float* v2, const rcRasterBatchParams& params,
+                       rcRasterSpanSink* sink, void* user);
+#endif
+
+#endif // RECASTRASTERIZATIONSIMD_H
@@ -0,0 +1,374 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+// Rasterization kernels shared by the SSE4.1 and AVX2 files. Included inside an anonymous namespace
+// by a file that defines RC_LANES, the vfloat/vint types and the v* operations on them.
+//
+// A triangle whose clipped row and column both come out as the whole triangle never gets changed by
+// dividePoly, so its span is just its own height range. Each lane repeats rasterizeTri's arithmetic
+// for that case step by step, with the same operations in the same order, and only claims the
+// triangle when every test rasterizeTri would make agrees. That keeps the spans bit-identical.
+
+// Float to int conversions are only exact (and only match the scalar casts) well inside int range.
+static const float RC_RASTER_INT_LIMIT = 1073741824.0f;
+
+static inline vint vInIntRange(vfloat v)
+{
+	return vAnd(vCmpGT(v, vSet1(-RC_RASTER_INT_LIMIT)), vCmpLT(v, vSet1(RC_RASTER_INT_LIMIT)));
+}
+
+// rcClamp(v, lo, hi) for per-lane lo, including its behaviour when lo > hi.
+static inline vint vClampi(vint v, vint lo, vint hi)
+{
+	return vSelecti(vCmpGti(lo, v), lo, vSelecti(vCmpGti(v, hi), hi, v));
+}
+
+void rasterizeBatch(const rcRasterBatchParams& params, const float* const* tris, int count, rcRasterBatchResult& result)
+{
+	result.handledMask = 0;
+	result.spanMask = 0;
+
+	const vfloat zero = vSet1(0.0f);
+	const vfloat cellSize = vSet1(params.cellSize);
+	const vfloat inverseCellSize = vSet1(params.inverseCellSize);
+	const vfloat inverseCellHeight = vSet1(params.inverseCellHeight);
+	const vfloat by = vSet1(params.by);
+	const vint widthLast = vSet1i(params.width - 1);
+	const vint heightLast = vSet1i(params.height - 1);
+	const vint minusOne = vSet1i(-1);
+	const vint zeroi = vSet1i(0);
+	const vint spanMaxHeight = vSet1i(RC_SPAN_MAX_HEIGHT);
+
+	vfloat bmin[3], bmax[3];
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		bmin[axis] = vSet1(params.bmin[axis]);
+		bmax[axis] = vSet1(params.bmax[axis]);
+	}
+
+	for (int base = 0; base < count; base += RC_LANES)
+	{
+		// No rcMin here: an inline function instantiated in this file could end up shared with code
+		// that runs before the CPU has been checked.
+		const int laneCount = count - base < RC_LANES ? count - base : RC_LANES;
+
+		// v[vertex][axis], one triangle per lane. Missing lanes repeat the first triangle and get masked off.
+		const float* lanes[3][RC_LANES];
+		for (int lane = 0; lane < RC_LANES; ++lane)
+		{
+			const float* const* tri = &tris[(base + (lane < laneCount ? lane : 0)) * 3];
+			lanes[0][lane] = tri[0];
+			lanes[1][lane] = tri[1];
+			lanes[2][lane] = tri[2];
+		}
+
+		vfloat v[3][3];
+		for (int vert = 0; vert < 3; ++vert)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				v[vert][axis] = vGather(lanes[vert], axis);
+			}
+		}
+
+		// NaNs take odd routes through rasterizeTri's comparisons; leave them to it.
+		vint valid = vCmpOrd(v[0][0], v[0][1]);
+		valid = vAnd(valid, vCmpOrd(v[0][2], v[1][0]));
+		valid = vAnd(valid, vCmpOrd(v[1][1], v[1][2]));
+		valid = vAnd(valid, vCmpOrd(v[2][0], v[2][1]));
+		valid = vAnd(valid, vCmpOrd(v[2][2], v[2][2]));
+
+		// Bounding box and overlap test.
+		vfloat triMin[3], triMax[3];
+		vint overlap = valid;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			triMin[axis] = vMin(vMin(v[0][axis], v[1][axis]), v[2][axis]);
+			triMax[axis] = vMax(vMax(v[0][axis], v[1][axis]), v[2][axis]);
+			overlap = vAnd(overlap, vAnd(vCmpLE(triMin[axis], bmax[axis]), vCmpGE(triMax[axis], bmin[axis])));
+		}
+
+		// Triangles that miss the heightfield add nothing.
+		vint noSpan = vAndNot(valid, overlap);
+
+		// Row footprint; the triangle has to sit in a single row that the row cut leaves untouched.
+		const vfloat z0f = vMul(vSub(triMin[2], bmin[2]), inverseCellSize);
+		const vfloat z1f = vMul(vSub(triMax[2], bmin[2]), inverseCellSize);
+		vint inRow = vAnd(overlap, vAnd(vInIntRange(z0f), vInIntRange(z1f)));
+
+		const vint z0 = vMini(vMaxi(vToInt(z0f), minusOne), heightLast);
+		const vint z1 = vMini(vMaxi(vToInt(z1f), zeroi), heightLast);
+		inRow = vAnd(inRow, vCmpEqi(z0, z1));
+
+		const vfloat rowCut = vAdd(vAdd(bmin[2], vMul(vToFloat(z0), cellSize)), cellSize);
+		for (int vert = 0; vert < 3; ++vert)
+		{
+			inRow = vAnd(inRow, vCmpGE(vSub(rowCut, v[vert][2]), zero));
+		}
+
+		// Column footprint, from the row polygon's extents, which is the triangle in vertex order.
+		const vfloat minX = vMin(vMin(v[0][0], v[1][0]), v[2][0]);
+		const vfloat maxX = vMax(vMax(v[0][0], v[1][0]), v[2][0]);
+		const vfloat x0f = vMul(vSub(minX, bmin[0]), inverseCellSize);
+		const vfloat x1f = vMul(vSub(maxX, bmin[0]), inverseCellSize);
+		inRow = vAnd(inRow, vAnd(vInIntRange(x0f), vInIntRange(x1f)));
+
+		const vint x0Raw = vToInt(x0f);
+		const vint x1Raw = vToInt(x1f);
+		const vint rowOutside = vAnd(inRow, vOr(vCmpGti(zeroi, x1Raw), vCmpGti(x0Raw, widthLast)));
+		noSpan = vOr(noSpan, rowOutside);
+
+		const vint x0 = vMini(vMaxi(x0Raw, minusOne), widthLast);
+		const vint x1 = vMini(vMaxi(x1Raw, zeroi), widthLast);
+		vint inCell = vAndNot(rowOutside, vAnd(inRow, vCmpEqi(x0, x1)));
+
+		const vfloat columnCut = vAdd(vAdd(bmin[0], vMul(vToFloat(x0), cellSize)), cellSize);
+		for (int vert = 0; vert < 3; ++vert)
+		{
+			inCell = vAnd(inCell, vCmpGE(vSub(columnCut, v[vert][0]), zero));
+		}
+
+		// Span extents, folded in vertex order like rcMin/rcMax in rasterizeTri.
+		vfloat spanMin = vMin(vMin(v[0][1], v[1][1]), v[2][1]);
+		vfloat spanMax = vMax(vMax(v[0][1], v[1][1]), v[2][1]);
+		spanMin = vSub(spanMin, bmin[1]);
+		spanMax = vSub(spanMax, bmin[1]);
+
+		const vint outsideHeight = vAnd(inCell, vOr(vCmpLT(spanMax, zero), vCmpGT(spanMin, by)));
+		noSpan = vOr(noSpan, outsideHeight);
+		const vint hasSpan = vAndNot(outsideHeight, inCell);
+
+		// "if (spanMin < 0) spanMin = 0" keeps -0, which floors to the same cell as +0.
+		spanMin = vSelectf(vCmpLT(spanMin, zero), zero, spanMin);
+		spanMax = vSelectf(vCmpGT(spanMax, by), by, spanMax);
+
+		const vint spanMinCell = vClampi(vToInt(vFloor(vMul(spanMin, inverseCellHeight))), zeroi, spanMaxHeight);
+		const vint spanMaxCell = vClampi(vToInt(vCeil(vMul(spanMax, inverseCellHeight))), vAdd1i(spanMinCell), spanMaxHeight);
+
+		const unsigned laneMask = (1u << laneCount) - 1;
+		result.handledMask |= (vMask(vOr(noSpan, hasSpan)) & laneMask) << base;
+		result.spanMask |= (vMask(hasSpan) & laneMask) << base;
+
+		vStorei(&result.x[base], x0);
+		vStorei(&result.z[base], z0);
+		vStorei(&result.smin[base], spanMinCell);
+		vStorei(&result.smax[base], spanMaxCell);
+	}
+}
+
+// rasterizeTri with each vertex held in one register, so dividePoly's copies and interpolations are a
+// single operation per vertex. The arithmetic is the same per component, in the same order.
+static inline __m128 loadVert(const float* v)
+{
+	return _mm_set_ps(0.0f, v[2], v[1], v[0]);
+}
+
+template<int Axis>
+static inline float getAxis(__m128 v)
+{
+	return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(Axis, Axis, Axis, Axis)));
+}
+
+template<int Axis>
+static void dividePolySIMD(const __m128* inVerts, int inVertsCount,
+                           __m128* outVerts1, int* outVerts1Count,
+                           __m128* outVerts2, int* outVerts2Count,
+                           float axisOffset)
+{
+	float inVertAxisDelta[12];
+	for (int inVert = 0; inVert < inVertsCount; ++inVert)
+	{
+		inVertAxisDelta[inVert] = axisOffset - getAxis<Axis>(inVerts[inVert]);
+	}
+
+	int poly1Vert = 0;
+	int poly2Vert = 0;
+	for (int inVertA = 0, inVertB = inVertsCount - 1; inVertA < inVertsCount; inVertB = inVertA, ++inVertA)
+	{
+		const bool sameSide = (inVertAxisDelta[inVertA] >= 0) == (inVertAxisDelta[inVertB] >= 0);
+
+		if (!sameSide)
+		{
+			const float s = inVertAxisDelta[inVertB] / (inVertAxisDelta[inVertB] - inVertAxisDelta[inVertA]);
+			const __m128 a = inVerts[inVertA];
+			const __m128 b = inVerts[inVertB];
+			const __m128 cut = _mm_add_ps(b, _mm_mul_ps(_mm_sub_ps(a, b), _mm_set1_ps(s)));
+			outVerts1[poly1Vert++] = cut;
+			outVerts2[poly2Vert++] = cut;
+
+			if (inVertAxisDelta[inVertA] > 0)
+			{
+				outVerts1[poly1Vert++] = a;
+			}
+			else if (inVertAxisDelta[inVertA] < 0)
+			{
+				outVerts2[poly2Vert++] = a;
+			}
+		}
+		else
+		{
+			if (inVertAxisDelta[inVertA] >= 0)
+			{
+				outVerts1[poly1Vert++] = inVerts[inVertA];
+				if (inVertAxisDelta[inVertA] != 0)
+				{
+					continue;
+				}
+			}
+			outVerts2[poly2Vert++] = inVerts[inVertA];
+		}
+	}
+
+	*outVerts1Count = poly1Vert;
+	*outVerts2Count = poly2Vert;
+}
+
+// Triangles with NaNs come back unhandled; they take odd routes through the scalar comparisons.
+int rasterizeTriSIMD(const float* v0, const float* v1, const float* v2, const rcRasterBatchParams& params,
+                     rcRasterSpanSink* sink, void* user)
+{
+	const __m128 a = loadVert(v0);
+	const __m128 b = loadVert(v1);
+	const __m128 c = loadVert(v2);
+
+	if ((_mm_movemask_ps(_mm_or_ps(_mm_cmpunord_ps(a, b), _mm_cmpunord_ps(c, c))) & 7) != 0)
+	{
+		return RC_RASTER_TRI_UNHANDLED;
+	}
+
+	const __m128 triBBMin = _mm_min_ps(_mm_min_ps(a, b), c);
+	const __m128 triBBMax = _mm_max_ps(_mm_max_ps(a, b), c);
+	const __m128 hfBBMin = loadVert(params.bmin);
+	const __m128 hfBBMax = loadVert(params.bmax);
+
+	const int overlap = _mm_movemask_ps(_mm_and_ps(_mm_cmple_ps(triBBMin, hfBBMax), _mm_cmpge_ps(triBBMax, hfBBMin)));
+	if ((overlap & 7) != 7)
+	{
+		return RC_RASTER_TRI_DONE;
+	}
+
+	const int w = params.width;
+	const int h = params.height;
+	const float by = params.by;
+	const float cellSize = params.cellSize;
+	const float inverseCellSize = params.inverseCellSize;
+	const float inverseCellHeight = params.inverseCellHeight;
+
+	int z0 = (int)((getAxis<2>(triBBMin) - params.bmin[2]) * inverseCellSize);
+	int z1 = (int)((getAxis<2>(triBBMax) - params.bmin[2]) * inverseCellSize);
+	z0 = z0 < -1 ? -1 : (z0 > h - 1 ? h - 1 : z0);
+	z1 = z1 < 0 ? 0 : (z1 > h - 1 ? h - 1 : z1);
+
+	__m128 buf[7 * 4];
+	__m128* in = buf;
+	__m128* inRow = buf + 7;
+	__m128* p1 = inRow + 7;
+	__m128* p2 = p1 + 7;
+
+	in[0] = a;
+	in[1] = b;
+	in[2] = c;
+	int nvRow;
+	int nvIn = 3;
+
+	for (int z = z0; z <= z1; ++z)
+	{
+		const float cellZ = params.bmin[2] + (float)z * cellSize;
+		dividePolySIMD<2>(in, nvIn, inRow, &nvRow, p1, &nvIn, cellZ + cellSize);
+		__m128* swap = in;
+		in = p1;
+		p1 = swap;
+
+		if (nvRow < 3 || z < 0)
+		{
+			continue;
+		}
+
+		// Same fold as the scalar loop; only signed zeros could differ, and they truncate alike.
+		__m128 rowMin = inRow[0];
+		__m128 rowMax = inRow[0];
+		for (int vert = 1; vert < nvRow; ++vert)
+		{
+			rowMin = _mm_min_ps(rowMin, inRow[vert]);
+			rowMax = _mm_max_ps(rowMax, inRow[vert]);
+		}
+
+		int x0 = (int)((getAxis<0>(rowMin) - params.bmin[0]) * inverseCellSize);
+		int x1 = (int)((getAxis<0>(rowMax) - params.bmin[0]) * inverseCellSize);
+		if (x1 < 0 || x0 >= w)
+		{
+			continue;
+		}
+		x0 = x0 < -1 ? -1 : (x0 > w - 1 ? w - 1 : x0);
+		x1 = x1 < 0 ? 0 : (x1 > w - 1 ? w - 1 : x1);
+
+		int nv;
+		int nv2 = nvRow;
+
+		for (int x = x0; x <= x1; ++x)
+		{
+			const float cx = params.bmin[0] + (float)x * cellSize;
+			dividePolySIMD<0>(inRow, nv2, p1, &nv, p2, &nv2, cx + cellSize);
+			swap = inRow;
+			inRow = p2;
+			p2 = swap;
+
+			if (nv < 3 || x < 0)
+			{
+				continue;
+			}
+
+			__m128 cellMin = p1[0];
+			__m128 cellMax = p1[0];
+			for (int vert = 1; vert < nv; ++vert)
+			{
+				cellMin = _mm_min_ps(cellMin, p1[vert]);
+				cellMax = _mm_max_ps(cellMax, p1[vert]);
+			}
+
+			float spanMin = getAxis<1>(cellMin) - params.bmin[1];
+			float spanMax = getAxis<1>(cellMax) - params.bmin[1];
+
+			if (spanMax < 0.0f || spanMin > by)
+			{
+				continue;
+			}
+
+			if (spanMin < 0.0f)
+			{
+				spanMin = 0;
+			}
+			if (spanMax > by)
+			{
+				spanMax = by;
+			}
+
+			int spanMinCell = (int)floorf(spanMin * inverseCellHeight);
+			spanMinCell = spanMinCell < 0 ? 0 : (spanMinCell > RC_SPAN_MAX_HEIGHT ? RC_SPAN_MAX_HEIGHT : spanMinCell);
+			int spanMaxCell = (int)ceilf(spanMax * inverseCellHeight);
+			spanMaxCell = spanMaxCell < spanMinCell + 1 ? spanMinCell + 1 : (spanMaxCell > RC_SPAN_MAX_HEIGHT ? RC_SPAN_MAX_HEIGHT : spanMaxCell);
+
+			if (!sink(user, x, z, (unsigned short)spanMinCell, (unsigned short)spanMaxCell))
+			{
+				return RC_RASTER_TRI_FAILED;
+			}
+		}
+	}
+
+	return RC_RASTER_TRI_DONE;
+}
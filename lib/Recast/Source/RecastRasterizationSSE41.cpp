@@ -0,0 +1,86 @@
+//
+// Copyright (c) 2009-2010 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+#include "Recast.h"
+#include "RecastRasterizationSIMD.h"
+
+#if RC_RASTER_X86
+
+// Built with SSE4.1 enabled (see CMakeLists.txt) and only called once the CPU has been checked for it.
+#include <smmintrin.h>
+#include <math.h>
+
+namespace
+{
+static const int RC_LANES = 4;
+
+typedef __m128 vfloat;
+typedef __m128i vint;
+
+inline vfloat vSet1(float f) { return _mm_set1_ps(f); }
+inline vint vSet1i(int i) { return _mm_set1_epi32(i); }
+// The axis-th coordinate of each lane's vertex.
+inline vfloat vGather(const float* const* lanes, int axis) { return _mm_set_ps(lanes[3][axis], lanes[2][axis], lanes[1][axis], lanes[0][axis]); }
+inline void vStorei(int* dst, vint v) { _mm_storeu_si128((__m128i*)dst, v); }
+
+inline vfloat vAdd(vfloat a, vfloat b) { return _mm_add_ps(a, b); }
+inline vfloat vSub(vfloat a, vfloat b) { return _mm_sub_ps(a, b); }
+inline vfloat vMul(vfloat a, vfloat b) { return _mm_mul_ps(a, b); }
+// a < b ? a : b and a > b ? a : b, the same as rcMin and rcMax.
+inline vfloat vMin(vfloat a, vfloat b) { return _mm_min_ps(a, b); }
+inline vfloat vMax(vfloat a, vfloat b) { return _mm_max_ps(a, b); }
+inline vfloat vFloor(vfloat v) { return _mm_floor_ps(v); }
+inline vfloat vCeil(vfloat v) { return _mm_ceil_ps(v); }
+inline vint vToInt(vfloat v) { return _mm_cvttps_epi32(v); }
+inline vfloat vToFloat(vint v) { return _mm_cvtepi32_ps(v); }
+
+inline vint vCmpGE(vfloat a, vfloat b) { return _mm_castps_si128(_mm_cmpge_ps(a, b)); }
+inline vint vCmpLE(vfloat a, vfloat b) { return _mm_castps_si128(_mm_cmple_ps(a, b)); }
+inline vint vCmpGT(vfloat a, vfloat b) { return _mm_castps_si128(_mm_cmpgt_ps(a, b)); }
+inline vint vCmpLT(vfloat a, vfloat b) { return _mm_castps_si128(_mm_cmplt_ps(a, b)); }
+inline vint vCmpOrd(vfloat a, vfloat b) { return _mm_castps_si128(_mm_cmpord_ps(a, b)); }
+inline vint vCmpEqi(vint a, vint b) { return _mm_cmpeq_epi32(a, b); }
+inline vint vCmpGti(vint a, vint b) { return _mm_cmpgt_epi32(a, b); }
+
+inline vint vAnd(vint a, vint b) { return _mm_and_si128(a, b); }
+inline vint vOr(vint a, vint b) { return _mm_or_si128(a, b); }
+// b & ~a
+inline vint vAndNot(vint a, vint b) { return _mm_andnot_si128(a, b); }
+
+inline vint vMini(vint a, vint b) { return _mm_min_epi32(a, b); }
+inline vint vMaxi(vint a, vint b) { return _mm_max_epi32(a, b); }
+inline vint vAdd1i(vint v) { return _mm_add_epi32(v, _mm_set1_epi32(1)); }
+inline vint vSelecti(vint mask, vint a, vint b) { return _mm_blendv_epi8(b, a, mask); }
+inline vfloat vSelectf(vint mask, vfloat a, vfloat b) { return _mm_blendv_ps(b, a, _mm_castsi128_ps(mask)); }
+inline unsigned vMask(vint mask) { return (unsigned)_mm_movemask_ps(_mm_castsi128_ps(mask)); }
+
+#include "RecastRasterizationSIMD.inl"
+}
+
+void rcRasterizeBatchSSE41(const rcRasterBatchParams& params, const float* const* tris, int count, rcRasterBatchResult& result)
+{
+	rasterizeBatch(params, tris, count, result);
+}
+
+int rcRasterizeTriSSE41(const float* v0, const float* v1, const float* v2, const rcRasterBatchParams& params,
+                        rcRasterSpanSink* sink, void* user)
+{
+	return rasterizeTriSIMD(v0, v1, v2, params, sink, user);
+}
+
+#endif // RC_RASTER_X86
@@ -36,17 +36,12 @@ struct LevelStackEntry
 };
 }  // namespace
 
-static void calculateDistanceField(rcCompactHeightfield& chf, unsigned short* src, unsigned short& maxDist)
+/// Resets the distances of the spans in rows [y0, y1), to 0 for spans on a boundary and 0xffff for the rest.
+static void markBoundarySpans(const rcCompactHeightfield& chf, unsigned short* src, const int y0, const int y1)
 {
 	const int w = chf.width;
-	const int h = chf.height;
 	
-	// Init distance and points.
-	for (int i = 0; i < chf.spanCount; ++i)
-		src[i] = 0xffff;
-	
-	// Mark boundary cells.
-	for (int y = 0; y < h; ++y)
+	for (int y = y0; y < y1; ++y)
 	{
 		for (int x = 0; x < w; ++x)
 		{
@@ -68,136 +63,162 @@ static void calculateDistanceField(rcCompactHeightfield& chf, unsigned short* sr
 							nc++;
 					}
 				}
-				if (nc != 4)
-					src[i] = 0;
+				src[i] = nc != 4 ? 0 : 0xffff;
 			}
 		}
 	}
+}
+
+/// First chamfer pass for the spans of one cell, from the (-1,0), (-1,-1), (0,-1) and (1,-1) neighbours.
+static void sweepDistanceForward(const rcCompactHeightfield& chf, unsigned short* src, const int x, const int y)
+{
+	const int w = chf.width;
 	
-			
-	// Pass 1
-	for (int y = 0; y < h; ++y)
+	const rcCompactCell& c = chf.cells[x+y*w];
+	for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
 	{
-		for (int x = 0; x < w; ++x)
+		const rcCompactSpan& s = chf.spans[i];
+		
+		if (rcGetCon(s, 0) != RC_NOT_CONNECTED)
 		{
-			const rcCompactCell& c = chf.cells[x+y*w];
-			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+			// (-1,0)
+			const int ax = x + rcGetDirOffsetX(0);
+			const int ay = y + rcGetDirOffsetY(0);
+			const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 0);
+			const rcCompactSpan& as = chf.spans[ai];
+			if (src[ai]+2 < src[i])
+				src[i] = src[ai]+2;
+			
+			// (-1,-1)
+			if (rcGetCon(as, 3) != RC_NOT_CONNECTED)
 			{
-				const rcCompactSpan& s = chf.spans[i];
-				
-				if (rcGetCon(s, 0) != RC_NOT_CONNECTED)
-				{
-					// (-1,0)
-					const int ax = x + rcGetDirOffsetX(0);
-					const int ay = y + rcGetDirOffsetY(0);
-					const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 0);
-					const rcCompactSpan& as = chf.spans[ai];
-					if (src[ai]+2 < src[i])
-						src[i] = src[ai]+2;
-					
-					// (-1,-1)
-					if (rcGetCon(as, 3) != RC_NOT_CONNECTED)
-					{
-						const int aax = ax + rcGetDirOffsetX(3);
-						const int aay = ay + rcGetDirOffsetY(3);
-						const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 3);
-						if (src[aai]+3 < src[i])
-							src[i] = src[aai]+3;
-					}
-				}
-				if (rcGetCon(s, 3) != RC_NOT_CONNECTED)
-				{
-					// (0,-1)
-					const int ax = x + rcGetDirOffsetX(3);
-					const int ay = y + rcGetDirOffsetY(3);
-					const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 3);
-					const rcCompactSpan& as = chf.spans[ai];
-					if (src[ai]+2 < src[i])
-						src[i] = src[ai]+2;
-					
-					// (1,-1)
-					if (rcGetCon(as, 2) != RC_NOT_CONNECTED)
-					{
-						const int aax = ax + rcGetDirOffsetX(2);
-						const int aay = ay + rcGetDirOffsetY(2);
-						const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 2);
-						if (src[aai]+3 < src[i])
-							src[i] = src[aai]+3;
-					}
-				}
+				const int aax = ax + rcGetDirOffsetX(3);
+				const int aay = ay + rcGetDirOffsetY(3);
+				const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 3);
+				if (src[aai]+3 < src[i])
+					src[i] = src[aai]+3;
+			}
+		}
+		if (rcGetCon(s, 3) != RC_NOT_CONNECTED)
+		{
+			// (0,-1)
+			const int ax = x + rcGetDirOffsetX(3);
+			const int ay = y + rcGetDirOffsetY(3);
+			const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 3);
+			const rcCompactSpan& as = chf.spans[ai];
+			if (src[ai]+2 < src[i])
+				src[i] = src[ai]+2;
+			
+			// (1,-1)
+			if (rcGetCon(as, 2) != RC_NOT_CONNECTED)
+			{
+				const int aax = ax + rcGetDirOffsetX(2);
+				const int aay = ay + rcGetDirOffsetY(2);
+				const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 2);
+				if (src[aai]+3 < src[i])
+					src[i] = src[aai]+3;
 			}
 		}
 	}
+}
+
+/// Second chamfer pass for the spans of one cell, from the (1,0), (1,1), (0,1) and (-1,1) neighbours.
+static void sweepDistanceBackward(const rcCompactHeightfield& chf, unsigned short* src, const int x, const int y)
+{
+	const int w = chf.width;
 	
-	// Pass 2
-	for (int y = h-1; y >= 0; --y)
+	const rcCompactCell& c = chf.cells[x+y*w];
+	for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
 	{
-		for (int x = w-1; x >= 0; --x)
+		const rcCompactSpan& s = chf.spans[i];
+		
+		if (rcGetCon(s, 2) != RC_NOT_CONNECTED)
 		{
-			const rcCompactCell& c = chf.cells[x+y*w];
-			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+			// (1,0)
+			const int ax = x + rcGetDirOffsetX(2);
+			const int ay = y + rcGetDirOffsetY(2);
+			const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 2);
+			const rcCompactSpan& as = chf.spans[ai];
+			if (src[ai]+2 < src[i])
+				src[i] = src[ai]+2;
+			
+			// (1,1)
+			if (rcGetCon(as, 1) != RC_NOT_CONNECTED)
 			{
-				const rcCompactSpan& s = chf.spans[i];
-				
-				if (rcGetCon(s, 2) != RC_NOT_CONNECTED)
-				{
-					// (1,0)
-					const int ax = x + rcGetDirOffsetX(2);
-					const int ay = y + rcGetDirOffsetY(2);
-					const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 2);
-					const rcCompactSpan& as = chf.spans[ai];
-					if (src[ai]+2 < src[i])
-						src[i] = src[ai]+2;
-					
-					// (1,1)
-					if (rcGetCon(as, 1) != RC_NOT_CONNECTED)
-					{
-						const int aax = ax + rcGetDirOffsetX(1);
-						const int aay = ay + rcGetDirOffsetY(1);
-						const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 1);
-						if (src[aai]+3 < src[i])
-							src[i] = src[aai]+3;
-					}
-				}
-				if (rcGetCon(s, 1) != RC_NOT_CONNECTED)
-				{
-					// (0,1)
-					const int ax = x + rcGetDirOffsetX(1);
-					const int ay = y + rcGetDirOffsetY(1);
-					const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 1);
-					const rcCompactSpan& as = chf.spans[ai];
-					if (src[ai]+2 < src[i])
-						src[i] = src[ai]+2;
-					
-					// (-1,1)
-					if (rcGetCon(as, 0) != RC_NOT_CONNECTED)
-					{
-						const int aax = ax + rcGetDirOffsetX(0);
-						const int aay = ay + rcGetDirOffsetY(0);
-						const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 0);
-						if (src[aai]+3 < src[i])
-							src[i] = src[aai]+3;
-					}
-				}
+				const int aax = ax + rcGetDirOffsetX(1);
+				const int aay = ay + rcGetDirOffsetY(1);
+				const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 1);
+				if (src[aai]+3 < src[i])
+					src[i] = src[aai]+3;
 			}
 		}
-	}	
-	
-	maxDist = 0;
+		if (rcGetCon(s, 1) != RC_NOT_CONNECTED)
+		{
+			// (0,1)
+			const int ax = x + rcGetDirOffsetX(1);
+			const int ay = y + rcGetDirOffsetY(1);
+			const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 1);
+			const rcCompactSpan& as = chf.spans[ai];
+			if (src[ai]+2 < src[i])
+				src[i] = src[ai]+2;
+			
+			// (-1,1)
+			if (rcGetCon(as, 0) != RC_NOT_CONNECTED)
+			{
+				const int aax = ax + rcGetDirOffsetX(0);
+				const int aay = ay + rcGetDirOffsetY(0);
+				const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 0);
+				if (src[aai]+3 < src[i])
+					src[i] = src[aai]+3;
+			}
+		}
+	}
+}
+
+static unsigned short findMaxDistance(const rcCompactHeightfield& chf, const unsigned short* src)
+{
+	unsigned short maxDist = 0;
 	for (int i = 0; i < chf.spanCount; ++i)
 		maxDist = rcMax(src[i], maxDist);
-	
+	return maxDist;
 }
 
-static unsigned short* boxBlur(rcCompactHeightfield& chf, int thr,
-							   unsigned short* src, unsigned short* dst)
+static void calculateDistanceField(rcCompactHeightfield& chf, unsigned short* src, unsigned short& maxDist)
 {
 	const int w = chf.width;
 	const int h = chf.height;
 	
-	thr *= 2;
+	// Init distance and mark boundary cells.
+	markBoundarySpans(chf, src, 0, h);
 	
+	// Pass 1
 	for (int y = 0; y < h; ++y)
+	{
+		for (int x = 0; x < w; ++x)
+		{
+			sweepDistanceForward(chf, src, x, y);
+		}
+	}
+	
+	// Pass 2
+	for (int y = h-1; y >= 0; --y)
+	{
+		for (int x = w-1; x >= 0; --x)
+		{
+			sweepDistanceBackward(chf, src, x, y);
+		}
+	}	
+	
+	maxDist = findMaxDistance(chf, src);
+}
+
+/// Blurs the distances of the spans in rows [y0, y1). @p thr is already doubled.
+static void boxBlurRows(const rcCompactHeightfield& chf, const int thr,
+						const unsigned short* src, unsigned short* dst, const int y0, const int y1)
+{
+	const int w = chf.width;
+	
+	for (int y = y0; y < y1; ++y)
 	{
 		for (int x = 0; x < w; ++x)
 		{
@@ -245,9 +266,136 @@ static unsigned short* boxBlur(rcCompactHeightfield& chf, int thr,
 			}
 		}
 	}
+}
+
+static unsigned short* boxBlur(rcCompactHeightfield& chf, int thr,
+							   unsigned short* src, unsigned short* dst)
+{
+	boxBlurRows(chf, thr*2, src, dst, 0, chf.height);
 	return dst;
 }
 
+/// Rows per band, and columns per block, of the parallel distance field sweeps.
+static const int RC_DISTANCE_BLOCK_SIZE = 32;
+
+/// Rows handed to each job by the row-parallel distance field steps.
+static const int RC_DISTANCE_ROW_GRAIN = 8;
+
+namespace
+{
+struct DistanceFieldJob
+{
+	const rcCompactHeightfield* chf;
+	unsigned short* src;
+	unsigned short* dst;
+	int thr;
+
+	// Wavefront state.
+	bool backward;
+	int stage;
+	int firstBand;
+	int blockCount;
+};
+}  // namespace
+
+static void markBoundaryJob(void* userData, int begin, int end)
+{
+	const DistanceFieldJob* job = (const DistanceFieldJob*)userData;
+	markBoundarySpans(*job->chf, job->src, begin, end);
+}
+
+static void boxBlurJob(void* userData, int begin, int end)
+{
+	const DistanceFieldJob* job = (const DistanceFieldJob*)userData;
+	boxBlurRows(*job->chf, job->thr, job->src, job->dst, begin, end);
+}
+
+/// Sweeps the blocks of one wavefront stage, counting bands from job->firstBand.
+///
+/// The sweeps run in bands of rows, split into blocks of columns. Each row of a block starts one
+/// column left of the row above it, so every neighbour a cell reads that isn't in its own block is
+/// in a block of an earlier stage: (band, block) depends on (band, block - 1) and (band - 1, block + 1),
+/// and runs at stage block + band * 2. The backward sweep does the same on the mirrored grid.
+/// Each cell sees exactly the values it would in the serial sweep, so the distances come out the same.
+static void sweepDistanceJob(void* userData, int begin, int end)
+{
+	const DistanceFieldJob* job = (const DistanceFieldJob*)userData;
+	const rcCompactHeightfield& chf = *job->chf;
+	const int w = chf.width;
+	const int h = chf.height;
+	
+	for (int k = begin; k < end; ++k)
+	{
+		const int band = job->firstBand + k;
+		const int block = job->stage - band*2;
+		
+		for (int r = 0; r < RC_DISTANCE_BLOCK_SIZE; ++r)
+		{
+			const int y = band*RC_DISTANCE_BLOCK_SIZE + r;
+			if (y >= h)
+				break;
+			
+			const int x0 = rcMax(block*RC_DISTANCE_BLOCK_SIZE - r, 0);
+			const int x1 = rcMin((block+1)*RC_DISTANCE_BLOCK_SIZE - r, w);
+			for (int x = x0; x < x1; ++x)
+			{
+				if (job->backward)
+					sweepDistanceBackward(chf, job->src, w-1-x, h-1-y);
+				else
+					sweepDistanceForward(chf, job->src, x, y);
+			}
+		}
+	}
+}
+
+static void sweepDistanceParallel(rcContext* ctx, DistanceFieldJob& job)
+{
+	const int bandCount = (job.chf->height + RC_DISTANCE_BLOCK_SIZE-1) / RC_DISTANCE_BLOCK_SIZE;
+	// The last row of a band is skewed by RC_DISTANCE_BLOCK_SIZE-1 columns.
+	job.blockCount = (job.chf->width + RC_DISTANCE_BLOCK_SIZE*2 - 2) / RC_DISTANCE_BLOCK_SIZE;
+	
+	const int stageCount = job.blockCount + (bandCount-1)*2;
+	for (job.stage = 0; job.stage < stageCount; ++job.stage)
+	{
+		// Bands with block = stage - band*2 in [0, blockCount).
+		job.firstBand = rcMax((job.stage - job.blockCount + 2) / 2, 0);
+		const int lastBand = rcMin(job.stage / 2, bandCount-1);
+		ctx->parallelFor(lastBand - job.firstBand + 1, 1, sweepDistanceJob, &job);
+	}
+}
+
+/// Same as calculateDistanceField, with the work spread over ctx->parallelFor.
+static void calculateDistanceFieldParallel(rcContext* ctx, rcCompactHeightfield& chf, unsigned short* src, unsigned short& maxDist)
+{
+	DistanceFieldJob job;
+	memset(&job, 0, sizeof(job));
+	job.chf = &chf;
+	job.src = src;
+	
+	ctx->parallelFor(chf.height, RC_DISTANCE_ROW_GRAIN, markBoundaryJob, &job);
+	
+	job.backward = false;
+	sweepDistanceParallel(ctx, job);
+	job.backward = true;
+	sweepDistanceParallel(ctx, job);
+	
+	maxDist = findMaxDistance(chf, src);
+}
+
+/// Same as boxBlur, with the rows spread over ctx->parallelFor.
+static unsigned short* boxBlurParallel(rcContext* ctx, rcCompactHeightfield& chf, int thr,
+									   unsigned short* src, unsigned short* dst)
+{
+	DistanceFieldJob job;
+	memset(&job, 0, sizeof(job));
+	job.chf = &chf;
+	job.src = src;
+	job.dst = dst;
+	job.thr = thr*2;
+	
+	ctx->parallelFor(chf.height, RC_DISTANCE_ROW_GRAIN, boxBlurJob, &job);
+	return dst;
+}
 
 static bool floodRegion(int x, int y, int i,
 						unsigned short level, unsigned short r,
@@ -1277,11 +1425,17 @@ bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf)
 	}
 	
 	unsigned short maxDist = 0;
+	
+	// The sweeps only pay for the extra synchronization with more than one band.
+	const bool parallel = ctx->getThreadCount() > 1 && chf.height > RC_DISTANCE_BLOCK_SIZE;
 
 	{
 		rcScopedTimer timerDist(ctx, RC_TIMER_BUILD_DISTANCEFIELD_DIST);
 
-		calculateDistanceField(chf, src, maxDist);
+		if (parallel)
+			calculateDistanceFieldParallel(ctx, chf, src, maxDist);
+		else
+			calculateDistanceField(chf, src, maxDist);
 		chf.maxDistance = maxDist;
 	}
 
@@ -1289,7 +1443,8 @@ bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf)
 		rcScopedTimer timerBlur(ctx, RC_TIMER_BUILD_DISTANCEFIELD_BLUR);
 
 		// Blur
-		if (boxBlur(chf, 1, src, dst) != src)
+		unsigned short* blurred = parallel ? boxBlurParallel(ctx, chf, 1, src, dst) : boxBlur(chf, 1, src, dst);
+		if (blurred != src)
 			rcSwap(src, dst);
 
 		// Store distance.
@@ -18,3 +18,25 @@ void ADrawableContext::LoadDrawable(std::filesystem::path filePath) {
 
 
 }
+
+uint32_t ADrawableContext::CollectTriangles(std::vector<float>& vertices, std::vector<int32_t>& indices) const {
+	ZoneScoped;
+
+	uint32_t count = 0;
+
+	for (const std::shared_ptr<CDrawable>& drawable : mDrawables) {
+		if (drawable != nullptr && AppendDrawableTriangles(*drawable, vertices, indices)) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+bool ADrawableContext::AppendDrawableTriangles([[maybe_unused]] const CDrawable& drawable, [[maybe_unused]] std::vector<float>& vertices,
+	[[maybe_unused]] std::vector<int32_t>& indices)
+{
+	// Blocked: the librdr3 this tree builds against doesn't expose a drawable's vertex and index
+	// buffers, so drawables can't contribute geometry yet. Only this function needs to change once it does.
+	return false;
+}
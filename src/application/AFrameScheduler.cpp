@@ -0,0 +1,86 @@
+#include "application/AFrameScheduler.hpp"
+#include "application/AOptions.hpp"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+
+namespace AFrameScheduler {
+	namespace {
+		// ImGui needs a couple of frames after an event to settle hover/active states.
+		constexpr int32_t SETTLE_FRAMES = 3;
+		// Safety net so things like the text cursor still update while idle.
+		constexpr double IDLE_WAIT_TIMEOUT = 0.5;
+		constexpr float IDLE_RESUME_DELTA = 1.0f / 60.0f;
+
+		// Reasons that require the viewport to be re-rendered. Plain input only needs the UI to run.
+		constexpr uint32_t SCENE_REASONS = INVALIDATE_ALL & ~INVALIDATE_INPUT;
+
+		GLFWwindow* mWindow = nullptr;
+		std::thread::id mMainThreadId;
+
+		std::atomic<uint32_t> mInvalidReasons = INVALIDATE_ALL;
+		std::atomic<int32_t> mPendingFrames = SETTLE_FRAMES;
+
+		bool bWaitedLastFrame = false;
+	}
+}
+
+void AFrameScheduler::Init(GLFWwindow* window) {
+	mWindow = window;
+	mMainThreadId = std::this_thread::get_id();
+
+	mInvalidReasons = INVALIDATE_ALL;
+	mPendingFrames = SETTLE_FRAMES;
+}
+
+void AFrameScheduler::Invalidate(uint32_t reasons) {
+	mInvalidReasons |= reasons;
+	mPendingFrames = SETTLE_FRAMES;
+
+	if (mWindow != nullptr && std::this_thread::get_id() != mMainThreadId) {
+		glfwPostEmptyEvent();
+	}
+}
+
+void AFrameScheduler::WaitForEvents() {
+	bWaitedLastFrame = false;
+
+	if (!IsIdle()) {
+		glfwPollEvents();
+		return;
+	}
+
+	double waitStart = glfwGetTime();
+	glfwWaitEventsTimeout(IDLE_WAIT_TIMEOUT);
+	bWaitedLastFrame = true;
+
+	// Woken up by an actual event rather than the timeout - give the UI a few frames to react to it.
+	if (glfwGetTime() - waitStart < IDLE_WAIT_TIMEOUT) {
+		mPendingFrames = SETTLE_FRAMES;
+	}
+}
+
+bool AFrameScheduler::ConsumeSceneInvalidation() {
+	uint32_t reasons = mInvalidReasons.fetch_and(~SCENE_REASONS);
+	return !OPTIONS.bRenderOnDemand || (reasons & SCENE_REASONS) != 0;
+}
+
+void AFrameScheduler::FrameCompleted() {
+	mInvalidReasons &= ~INVALIDATE_INPUT;
+
+	if (mPendingFrames > 0) {
+		mPendingFrames--;
+	}
+}
+
+float AFrameScheduler::ClampDeltaTime(float deltaTime) {
+	return bWaitedLastFrame ? std::min(deltaTime, IDLE_RESUME_DELTA) : deltaTime;
+}
+
+bool AFrameScheduler::IsIdle() {
+	return OPTIONS.bRenderOnDemand && mPendingFrames <= 0 && mInvalidReasons == INVALIDATE_NONE;
+}
@@ -1,5 +1,6 @@
 #include "application/AGatorApplication.hpp"
 #include "application/AInput.hpp"
+#include "application/AFrameScheduler.hpp"
 #include "application/AGatorContext.hpp"
 
 #include <glad/glad.h>
@@ -10,6 +11,8 @@
 #include <imgui_impl_glfw.h>
 
 #include "util/ImGuizmo.hpp"
+#include "util/gpuprofiler.hpp"
+#include "util/jobsystem.hpp"
 
 #include <string>
 #include <iostream>
@@ -53,6 +56,8 @@ bool AGatorApplication::Setup() {
 	glfwSetScrollCallback(mWindow, AInput::GLFWMouseScrollCallback);
 	glfwSetDropCallback(mWindow, GLFWDropCallback);
 
+	AFrameScheduler::Init(mWindow);
+
 	glfwMakeContextCurrent(mWindow);
 	gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
 	glClearColor(0.5f, 1.0f, 0.5f, 1.0f);
@@ -61,6 +66,8 @@ bool AGatorApplication::Setup() {
 	//glEnable(GL_DEBUG_OUTPUT);
 	glDebugMessageCallback(DealWithGLErrors, nullptr);
 
+	UGPUProfiler::Init();
+
 	// Initialize imgui
 	ImGui::CreateContext();
 	ImGuiIO& io = ImGui::GetIO();
@@ -79,6 +86,8 @@ bool AGatorApplication::Setup() {
 	ImGui_ImplGlfw_InitForOpenGL(mWindow, true);
 	ImGui_ImplOpenGL3_Init("#version 150");
 
+	UJobSystem::Init();
+
 	// Create viewer context
 	mContext = new AGatorContext();
 	mContext->OnGLInitialized();
@@ -88,6 +97,10 @@ bool AGatorApplication::Setup() {
 }
 
 bool AGatorApplication::Teardown() {
+	// Stop workers before the contexts they load into go away.
+	UJobSystem::Shutdown();
+	UGPUProfiler::Shutdown();
+
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
 	ImGui::DestroyContext();
@@ -105,12 +118,22 @@ bool AGatorApplication::Execute(float deltaTime) {
 	if (mContext == nullptr || mWindow == nullptr || glfwWindowShouldClose(mWindow))
 		return false;
 
+	ZoneScoped;
+
+	deltaTime = AFrameScheduler::ClampDeltaTime(deltaTime);
+
+	// Started before Update() so the picking pass is measured too.
+	UGPUProfiler::BeginFrame();
+
 	// Update viewer context
 	mContext->Update(deltaTime);
 
-	// Begin actual rendering
+	// Begin actual rendering. If nothing is invalid this blocks until the OS has an event for us.
 	glfwMakeContextCurrent(mWindow);
-	glfwPollEvents();
+	{
+		ZoneScopedN("Wait for events");
+		AFrameScheduler::WaitForEvents();
+	}
 
 	AInput::UpdateInputState();
 
@@ -137,22 +160,38 @@ bool AGatorApplication::Execute(float deltaTime) {
 	mContext->Render(deltaTime);
 
 	// Render imgui
-	ImGui::Render();
+	{
+		ZoneScopedN("ImGui::Render");
+		ImGui::Render();
+	}
 
 	mContext->PostRender(deltaTime);
 
-	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+	{
+		ZoneScopedN("ImGui draw");
+		GPUZone("ImGui");
+		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+	}
 
 	if (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
 	{
+		ZoneScopedN("Platform windows");
 		GLFWwindow* backup_current_context = glfwGetCurrentContext();
 		ImGui::UpdatePlatformWindows();
 		ImGui::RenderPlatformWindowsDefault();
 		glfwMakeContextCurrent(backup_current_context);
 	}
 
+	UGPUProfiler::EndFrame();
+
 	// Swap buffers
-	glfwSwapBuffers(mWindow);
+	{
+		ZoneScopedN("Swap buffers");
+		glfwSwapBuffers(mWindow);
+	}
+
+	AFrameScheduler::FrameCompleted();
+	FrameMark;
 
 	return true;
 }
@@ -162,7 +201,6 @@ void GLFWDropCallback(GLFWwindow* window, int count, const char* paths[]) {
 		return;
 	}
 
-	for (int i = 0; i < count; i++) {
-		GatorContext->OnFileDropped(paths[i]);
-	}
+	std::vector<std::filesystem::path> droppedPaths(paths, paths + count);
+	GatorContext->OnFilesDropped(droppedPaths);
 }
@@ -1,7 +1,10 @@
 #include "application/AGatorContext.hpp"
 #include "application/AInput.hpp"
+#include "application/AFrameScheduler.hpp"
 
 #include "application/ANavContext.hpp"
+#include "application/ANavStreamer.hpp"
+#include "application/ANavGenerator.hpp"
 #include "application/ATrackContext.hpp"
 #include "application/ADrawableContext.hpp"
 
@@ -9,6 +12,7 @@
 #include "ui/UViewportPicker.hpp"
 
 #include "util/rdr1util.hpp"
+#include "util/gpuprofiler.hpp"
 
 #include "application/AOptions.hpp"
 
@@ -16,12 +20,16 @@
 
 #include <imgui.h>
 #include <imgui_internal.h>
+#include <algorithm>
 #include <ImGuiFileDialog.h>
 #include "util/ImGuizmo.hpp"
 
-AGatorContext::AGatorContext() : bIsDockingConfigured(false), mMainDockSpaceID(UINT32_MAX), mDockNodeTopID(UINT32_MAX),
+// Max time per frame spent moving finished navmeshes to the GPU.
+constexpr float NAV_UPLOAD_BUDGET_MS = 4.0f;
+
+AGatorContext::AGatorContext() : bIsDockingConfigured(false), bShowGPUTimings(false), bShowNavHoverInfo(false), bShowNavGenerator(false), mMainDockSpaceID(UINT32_MAX), mDockNodeTopID(UINT32_MAX),
 	mDockNodeRightID(UINT32_MAX), mDockNodeDownID(UINT32_MAX), mPropertiesDockNodeID(UINT32_MAX), mAppPosition({ 0, 0 }),
-	mNavContext(std::make_shared<ANavContext>()), mTrackContext(std::make_shared<ATrackContext>()), mDrawableContext(std::make_shared<ADrawableContext>()),
+	mNavContext(std::make_shared<ANavContext>()), mNavStreamer(std::make_shared<ANavStreamer>()), mNavGenerator(std::make_shared<ANavGenerator>()), mTrackContext(std::make_shared<ATrackContext>()), mDrawableContext(std::make_shared<ADrawableContext>()),
 	mPropertiesPanelTopID(UINT32_MAX), mPropertiesPanelBottomID(UINT32_MAX)
 {
 	OPTIONS.Load();
@@ -66,6 +74,12 @@ void AGatorContext::RenderMenuBar() {
 			if (ImGui::MenuItem("Open...")) {
 				LoadFileCB();
 			}
+			if (ImGui::MenuItem("Open navmesh directory...")) {
+				OpenDirectoryCB();
+			}
+			if (ImGui::MenuItem("Stream navmesh directory...")) {
+				StreamDirectoryCB();
+			}
 			if (ImGui::BeginMenu("Railroad Data")) {
 				if (!mTrackContext->IsLoaded()) {
 					ImGui::BeginDisabled();
@@ -95,6 +109,61 @@ void AGatorContext::RenderMenuBar() {
 
 			ImGui::EndMenu();
 		}
+		if (ImGui::BeginMenu("Edit")) {
+			if (ImGui::MenuItem("Undo", nullptr, false, mTrackContext->CanUndo())) {
+				mTrackContext->Undo();
+			}
+
+			ImGui::Separator();
+
+			if (ImGui::MenuItem("Generate navmesh...")) {
+				bShowNavGenerator = true;
+			}
+
+			if (ImGui::BeginMenu("Snap to ground", mTrackContext->IsLoaded())) {
+				if (ImGui::MenuItem("Selected nodes")) {
+					mTrackContext->SnapToGround(*mNavContext, ETrackSnapScope::Snap_Selected_Nodes, OPTIONS.mSnapSearchHeight, OPTIONS.mSnapSearchDepth);
+				}
+				if (ImGui::MenuItem("Selected track")) {
+					mTrackContext->SnapToGround(*mNavContext, ETrackSnapScope::Snap_Selected_Track, OPTIONS.mSnapSearchHeight, OPTIONS.mSnapSearchDepth);
+				}
+				if (ImGui::MenuItem("All tracks")) {
+					mTrackContext->SnapToGround(*mNavContext, ETrackSnapScope::Snap_All_Tracks, OPTIONS.mSnapSearchHeight, OPTIONS.mSnapSearchDepth);
+				}
+
+				ImGui::Separator();
+				ImGui::DragFloat("Search above", &OPTIONS.mSnapSearchHeight, 1.0f, 0.0f, 10000.0f, "%.0f");
+				ImGui::DragFloat("Search below", &OPTIONS.mSnapSearchDepth, 1.0f, 0.0f, 10000.0f, "%.0f");
+
+				ImGui::EndMenu();
+			}
+
+			ImGui::EndMenu();
+		}
+
+		if (ImGui::BeginMenu("Options")) {
+			if (ImGui::MenuItem("Render on demand", nullptr, &OPTIONS.bRenderOnDemand)) {
+				AFrameScheduler::Invalidate(INVALIDATE_ALL);
+			}
+			if (ImGui::MenuItem("Single-pass picking", nullptr, &OPTIONS.bSinglePassPicking)) {
+				AFrameScheduler::Invalidate(INVALIDATE_ALL);
+			}
+
+			ImGui::Separator();
+			ImGui::MenuItem("Cache opened navmeshes", nullptr, &OPTIONS.bNavmeshCache);
+			ImGui::DragFloat("Height grid cell size", &OPTIONS.mHeightGridCellSize, 0.05f, 0.0f, 16.0f, "%.2f");
+			if (ImGui::IsItemHovered()) {
+				ImGui::SetTooltip("Applies to navmeshes loaded from now on. 0 turns height grids off.");
+			}
+
+			ImGui::EndMenu();
+		}
+		if (ImGui::BeginMenu("View")) {
+			ImGui::MenuItem("GPU timings", nullptr, &bShowGPUTimings);
+			ImGui::MenuItem("Navmesh hover info", nullptr, &bShowNavHoverInfo);
+
+			ImGui::EndMenu();
+		}
 		if (ImGui::BeginMenu("About")) {
 			ImGui::EndMenu();
 		}
@@ -104,13 +173,34 @@ void AGatorContext::RenderMenuBar() {
 }
 
 void AGatorContext::Update(float deltaTime) {
+	ZoneScoped;
+
+	mNavStreamer->Update(*mNavContext, mMainViewport->GetCamera());
+	mNavContext->ProcessUploads(NAV_UPLOAD_BUDGET_MS);
+	mNavGenerator->Update(*mNavContext);
+
 	glm::vec2 viewportSize = mMainViewport->GetViewportSize();
-	UViewportPicker::ResizePicker(uint32_t(viewportSize.x), uint32_t(viewportSize.y));
+
+	if (OPTIONS.bSinglePassPicking) {
+		UViewportPicker::SetSharedSource(mMainViewport->GetFramebuffer());
+	}
+	else {
+		UViewportPicker::SetSharedSource(0);
+		UViewportPicker::ResizePicker(uint32_t(viewportSize.x), uint32_t(viewportSize.y));
+	}
 
 	glm::vec2 screenMousePos = mAppPosition + AInput::GetMousePosition();
 	glm::vec2 bufferMousePos = screenMousePos - mMainViewport->GetViewportPosition();
 	bufferMousePos.y = mMainViewport->GetViewportSize().y - bufferMousePos.y;
 
+	bool bMouseInViewport = bufferMousePos.x >= 0 && bufferMousePos.y >= 0 && bufferMousePos.x < viewportSize.x && bufferMousePos.y < viewportSize.y;
+	if (bShowNavHoverInfo && bMouseInViewport) {
+		mNavContext->OnMouseHover(mMainViewport->GetCamera(), viewportSize, int32_t(bufferMousePos.x), int32_t(bufferMousePos.y));
+	}
+	else {
+		mNavContext->ClearHover();
+	}
+
 	if (bufferMousePos.x >= 0 && bufferMousePos.y >= 0) {
 		mTrackContext->OnMouseHover(mMainViewport->GetCamera(), int32_t(bufferMousePos.x), int32_t(bufferMousePos.y));
 
@@ -155,11 +245,22 @@ void AGatorContext::Render(float deltaTime) {
 
 	mMainViewport->RenderUI(deltaTime);
 	mTrackContext->RenderUI(mMainViewport->GetCamera());
+	mNavStreamer->RenderUI(*mNavContext);
+	mNavGenerator->RenderUI(&bShowNavGenerator, *mNavContext, *mDrawableContext);
+
+	UGPUProfiler::RenderOverlay(&bShowGPUTimings);
+	mNavContext->RenderLoadProgress();
+	mNavContext->RenderHoverInfo();
 
 	// Render open file dialog
 	if (ImGuiFileDialog::Instance()->Display("loadFileDialog", 32, { 800, 600 })) {
 		if (ImGuiFileDialog::Instance()->IsOk()) {
-			OpenFile(ImGuiFileDialog::Instance()->GetFilePathName());
+			std::vector<std::filesystem::path> selectedPaths;
+			for (const auto& [fileName, filePath] : ImGuiFileDialog::Instance()->GetSelection()) {
+				selectedPaths.push_back(filePath);
+			}
+
+			OpenFiles(selectedPaths);
 		}
 
 		ImGuiFileDialog::Instance()->Close();
@@ -173,9 +274,34 @@ void AGatorContext::Render(float deltaTime) {
 
 		ImGuiFileDialog::Instance()->Close();
 	}
+
+	if (ImGuiFileDialog::Instance()->Display("openDirectoryDialog", 32, { 800, 600 })) {
+		if (ImGuiFileDialog::Instance()->IsOk()) {
+			OpenFiles({ ImGuiFileDialog::Instance()->GetCurrentPath() });
+		}
+
+		ImGuiFileDialog::Instance()->Close();
+	}
+
+	if (ImGuiFileDialog::Instance()->Display("streamDirectoryDialog", 32, { 800, 600 })) {
+		if (ImGuiFileDialog::Instance()->IsOk()) {
+			std::filesystem::path directory = ImGuiFileDialog::Instance()->GetCurrentPath();
+			mNavStreamer->OpenDirectory(*mNavContext, directory);
+			OPTIONS.mLastOpenedDir = directory;
+		}
+
+		ImGuiFileDialog::Instance()->Close();
+	}
 }
 
 void AGatorContext::PostRender(float deltaTime) {
+	ZoneScoped;
+
+	// Nothing in the scene changed, so the viewport can keep showing last frame's image.
+	if (!AFrameScheduler::ConsumeSceneInvalidation()) {
+		return;
+	}
+
 	mMainViewport->BindViewport();
 
 	mNavContext->Render(mMainViewport->GetCamera());
@@ -189,6 +315,11 @@ void AGatorContext::SetAppPosition(const int xPos, const int yPos) {
 }
 
 void AGatorContext::OpenFile(std::filesystem::path filePath) {
+	ZoneScoped;
+
+	std::string pathStr = filePath.generic_string();
+	ZoneText(pathStr.c_str(), pathStr.size());
+
 	if (!std::filesystem::exists(filePath) || !filePath.has_extension()) {
 		return;
 	}
@@ -216,7 +347,7 @@ void AGatorContext::OpenFile(std::filesystem::path filePath) {
 
 void AGatorContext::LoadFileCB() {
 	std::string startingDir = OPTIONS.mLastOpenedDir.empty() ? "." : OPTIONS.mLastOpenedDir.u8string();
-	ImGuiFileDialog::Instance()->OpenDialog("loadFileDialog", "Open File", "traintracks.xml{.xml},Navmeshes (*.ynv){.ynv}", startingDir, 1, nullptr, ImGuiFileDialogFlags_Modal);
+	ImGuiFileDialog::Instance()->OpenDialog("loadFileDialog", "Open File", "traintracks.xml{.xml},Navmeshes (*.ynv){.ynv}", startingDir, 0, nullptr, ImGuiFileDialogFlags_Modal);
 }
 
 void AGatorContext::SaveTracksAsCB() {
@@ -224,8 +355,66 @@ void AGatorContext::SaveTracksAsCB() {
 	ImGuiFileDialog::Instance()->OpenDialog("saveTracksAsDialog", "Choose Directory", nullptr, startingDir, 1, nullptr, ImGuiFileDialogFlags_Modal);
 }
 
-void AGatorContext::OnFileDropped(std::filesystem::path filePath) {
-	OpenFile(filePath);
+void AGatorContext::StreamDirectoryCB() {
+	std::string startingDir = OPTIONS.mLastOpenedDir.empty() ? "." : OPTIONS.mLastOpenedDir.u8string();
+	ImGuiFileDialog::Instance()->OpenDialog("streamDirectoryDialog", "Choose Navmesh Directory", nullptr, startingDir, 1, nullptr, ImGuiFileDialogFlags_Modal);
+}
+
+void AGatorContext::OpenDirectoryCB() {
+	std::string startingDir = OPTIONS.mLastOpenedDir.empty() ? "." : OPTIONS.mLastOpenedDir.u8string();
+	ImGuiFileDialog::Instance()->OpenDialog("openDirectoryDialog", "Choose Navmesh Directory", nullptr, startingDir, 1, nullptr, ImGuiFileDialogFlags_Modal);
+}
+
+void AGatorContext::OnFilesDropped(const std::vector<std::filesystem::path>& paths) {
+	OpenFiles(paths);
+}
+
+void AGatorContext::OpenFiles(const std::vector<std::filesystem::path>& paths) {
+	ZoneScoped;
+
+	std::vector<std::filesystem::path> navmeshPaths;
+
+	for (const std::filesystem::path& path : paths) {
+		if (std::filesystem::is_directory(path)) {
+			for (const auto& entry : std::filesystem::directory_iterator(path)) {
+				if (entry.is_regular_file() && entry.path().extension() == ".ynv") {
+					navmeshPaths.push_back(entry.path());
+				}
+			}
+
+			OPTIONS.mLastOpenedDir = path;
+		}
+		else if (path.extension() == ".ynv") {
+			navmeshPaths.push_back(path);
+			OPTIONS.mLastOpenedDir = path;
+		}
+		else {
+			OpenFile(path);
+		}
+	}
+
+	if (navmeshPaths.empty()) {
+		return;
+	}
+
+	// Biggest first, so a large tile picked up last doesn't leave every other worker idle at the end.
+	std::vector<std::pair<uintmax_t, std::filesystem::path>> sizedPaths;
+	for (const std::filesystem::path& path : navmeshPaths) {
+		std::error_code error;
+		sizedPaths.emplace_back(std::filesystem::file_size(path, error), path);
+	}
+
+	std::sort(sizedPaths.begin(), sizedPaths.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+	for (const auto& [size, path] : sizedPaths) {
+		if (size != static_cast<uintmax_t>(-1)) {
+			mNavContext->LoadNavmesh(path);
+		}
+	}
+}
+
+void AGatorContext::FinishPendingLoads() {
+	mNavContext->FinishPendingLoads();
 }
 
 void AGatorContext::OnGLInitialized() {
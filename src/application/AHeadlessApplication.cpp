@@ -0,0 +1,394 @@
+#ifdef NAVIGATOR_HEADLESS
+
+#include "application/AHeadlessApplication.hpp"
+#include "application/AGatorContext.hpp"
+#include "application/AFrameScheduler.hpp"
+#include "application/ATime.hpp"
+
+#include "ui/UViewport.hpp"
+#include "util/gpuprofiler.hpp"
+#include "util/jobsystem.hpp"
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <string>
+
+
+constexpr float ORBIT_RADIUS = 1000.0f;
+constexpr float ORBIT_HEIGHT = 500.0f;
+
+namespace {
+	bool ParseUint(const char* begin, const char* end, uint32_t& value) {
+		auto [ptr, error] = std::from_chars(begin, end, value);
+		return error == std::errc() && ptr == end;
+	}
+}
+
+bool AHeadlessSettings::ParseArgs(int argc, char* argv[]) {
+	bool headless = false;
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+		bool bValid = true;
+		bool bTakesValue = arg == "--frames" || arg == "--warmup" || arg == "--size" || arg == "--camera" || arg == "--stats" ||
+			arg == "--dump-images";
+
+		if (bTakesValue && value == nullptr) {
+			mArgsError = arg + " needs a value";
+			continue;
+		}
+
+		if (arg == "--headless") {
+			headless = true;
+		}
+		else if (arg == "--frames") {
+			bValid = ParseUint(value, value + std::strlen(value), mFrameCount);
+		}
+		else if (arg == "--warmup") {
+			bValid = ParseUint(value, value + std::strlen(value), mWarmupFrames);
+		}
+		else if (arg == "--size") {
+			const char* end = value + std::strlen(value);
+			const char* sep = std::find(value, end, 'x');
+
+			bValid = sep != end && ParseUint(value, sep, mWidth) && ParseUint(sep + 1, end, mHeight) && mWidth != 0 && mHeight != 0;
+		}
+		else if (arg == "--camera") {
+			mCameraPathFile = value;
+		}
+		else if (arg == "--stats") {
+			mStatsPath = value;
+		}
+		else if (arg == "--dump-images") {
+			mImageDir = value;
+		}
+		else if (arg.rfind("--", 0) == 0) {
+			mArgsError = "Unknown option " + arg;
+		}
+		else {
+			mScenePaths.push_back(arg);
+		}
+
+		if (bTakesValue) {
+			if (!bValid) {
+				mArgsError = "Invalid value for " + arg + ": " + value;
+			}
+
+			i++;
+		}
+	}
+
+	return headless;
+}
+
+AHeadlessApplication::AHeadlessApplication(const AHeadlessSettings& settings) : mSettings(settings), mDisplay(EGL_NO_DISPLAY),
+	mEGLContext(EGL_NO_CONTEXT), mSurface(EGL_NO_SURFACE), mContext(nullptr), mFrameIndex(0)
+{
+
+}
+
+bool AHeadlessApplication::CreateGLContext() {
+	EGLDisplay display = EGL_NO_DISPLAY;
+
+	// Prefer Mesa's surfaceless platform so we don't need a window system (or a GPU) at all.
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay != nullptr) {
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (display == EGL_NO_DISPLAY) {
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr) || !eglBindAPI(EGL_OPENGL_API)) {
+		std::cout << "Failed to initialize EGL" << std::endl;
+		return false;
+	}
+
+	mDisplay = display;
+
+	const EGLint configAttribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+		EGL_NONE
+	};
+
+	EGLConfig config = nullptr;
+	EGLint configCount = 0;
+	eglChooseConfig(display, configAttribs, &config, 1, &configCount);
+
+	// Everything renders into the viewport's FBO, so 4.5 is enough. Ask for 4.6 first to match the windowed app.
+	const EGLint contextVersions[][2] = { { 4, 6 }, { 4, 5 } };
+	for (const EGLint* version : contextVersions) {
+		const EGLint contextAttribs[] = {
+			EGL_CONTEXT_MAJOR_VERSION, version[0],
+			EGL_CONTEXT_MINOR_VERSION, version[1],
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+
+		mEGLContext = eglCreateContext(display, configCount > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttribs);
+		if (mEGLContext != EGL_NO_CONTEXT) {
+			break;
+		}
+	}
+
+	if (mEGLContext == EGL_NO_CONTEXT) {
+		std::cout << "Failed to create an OpenGL 4.5+ core context" << std::endl;
+		return false;
+	}
+
+	// Without EGL_KHR_surfaceless_context we need some drawable to make the context current; a 1x1 pbuffer will do.
+	const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+	if ((extensions == nullptr || std::strstr(extensions, "EGL_KHR_surfaceless_context") == nullptr) && configCount > 0) {
+		const EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		mSurface = eglCreatePbufferSurface(display, config, pbufferAttribs);
+	}
+
+	if (!eglMakeCurrent(display, mSurface, mSurface, mEGLContext)) {
+		std::cout << "Failed to make the EGL context current" << std::endl;
+		return false;
+	}
+
+	if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+		std::cout << "Failed to load OpenGL functions" << std::endl;
+		return false;
+	}
+
+	std::cout << "Headless renderer: " << glGetString(GL_RENDERER) << " (" << glGetString(GL_VERSION) << ")" << std::endl;
+	return true;
+}
+
+void AHeadlessApplication::DestroyGLContext() {
+	if (mDisplay == EGL_NO_DISPLAY) {
+		return;
+	}
+
+	eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+	if (mSurface != EGL_NO_SURFACE) {
+		eglDestroySurface(mDisplay, mSurface);
+	}
+	if (mEGLContext != EGL_NO_CONTEXT) {
+		eglDestroyContext(mDisplay, mEGLContext);
+	}
+
+	eglTerminate(mDisplay);
+
+	mSurface = EGL_NO_SURFACE;
+	mEGLContext = EGL_NO_CONTEXT;
+	mDisplay = EGL_NO_DISPLAY;
+}
+
+bool AHeadlessApplication::Setup() {
+	if (!CreateGLContext()) {
+		DestroyGLContext();
+		return false;
+	}
+
+	UGPUProfiler::Init();
+	UJobSystem::Init();
+
+	mContext = new AGatorContext();
+	mContext->OnGLInitialized();
+	mContext->GetMainViewport()->SetViewportSize(glm::vec2(mSettings.mWidth, mSettings.mHeight));
+
+	mContext->OpenFiles(mSettings.mScenePaths);
+
+	// Loads run on the job system; the measured frames need the whole scene on the GPU.
+	mContext->FinishPendingLoads();
+
+	LoadCameraPath();
+
+	if (!mSettings.mImageDir.empty()) {
+		std::filesystem::create_directories(mSettings.mImageDir);
+	}
+
+	mCPUFrameTimes.reserve(mSettings.mFrameCount);
+	mTotalFrameTimes.reserve(mSettings.mFrameCount);
+
+	return true;
+}
+
+bool AHeadlessApplication::Teardown() {
+	WriteStats();
+	UJobSystem::Shutdown();
+	UGPUProfiler::Shutdown();
+
+	delete mContext;
+	mContext = nullptr;
+
+	DestroyGLContext();
+
+	return true;
+}
+
+void AHeadlessApplication::LoadCameraPath() {
+	if (mSettings.mCameraPathFile.empty()) {
+		return;
+	}
+
+	std::ifstream pathFile(mSettings.mCameraPathFile);
+	std::string line;
+
+	while (std::getline(pathFile, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+
+		AHeadlessCameraKey key;
+		std::stringstream lineStream(line);
+		lineStream >> key.mEye.x >> key.mEye.y >> key.mEye.z >> key.mCenter.x >> key.mCenter.y >> key.mCenter.z;
+
+		if (!lineStream.fail()) {
+			mCameraPath.push_back(key);
+		}
+	}
+}
+
+AHeadlessCameraKey AHeadlessApplication::GetCameraForFrame(uint32_t frame) const {
+	float t = mSettings.mFrameCount > 1 ? float(frame) / float(mSettings.mFrameCount - 1) : 0.0f;
+
+	if (mCameraPath.empty()) {
+		float angle = t * glm::two_pi<float>();
+		return { glm::vec3(std::cos(angle) * ORBIT_RADIUS, ORBIT_HEIGHT, std::sin(angle) * ORBIT_RADIUS), ZERO };
+	}
+
+	if (mCameraPath.size() == 1) {
+		return mCameraPath[0];
+	}
+
+	// Spread the frames evenly over the keyframes and lerp between neighbours.
+	float keyPos = t * float(mCameraPath.size() - 1);
+	size_t keyIdx = std::min(size_t(keyPos), mCameraPath.size() - 2);
+	float keyT = keyPos - float(keyIdx);
+
+	const AHeadlessCameraKey& a = mCameraPath[keyIdx];
+	const AHeadlessCameraKey& b = mCameraPath[keyIdx + 1];
+
+	return { glm::mix(a.mEye, b.mEye, keyT), glm::mix(a.mCenter, b.mCenter, keyT) };
+}
+
+bool AHeadlessApplication::Execute(float deltaTime) {
+	if (mContext == nullptr || mFrameIndex >= mSettings.mWarmupFrames + mSettings.mFrameCount) {
+		return false;
+	}
+
+	// Warmup frames all use the first camera so shader compilation and first uploads don't skew the stats.
+	uint32_t pathFrame = mFrameIndex < mSettings.mWarmupFrames ? 0 : mFrameIndex - mSettings.mWarmupFrames;
+	AHeadlessCameraKey cameraKey = GetCameraForFrame(pathFrame);
+	mContext->GetMainViewport()->GetCamera().SetView(cameraKey.mEye, cameraKey.mCenter, UNIT_Y);
+
+	Clock::time_point frameStart = AUtil::GetTime();
+
+	UGPUProfiler::BeginFrame();
+
+	AFrameScheduler::Invalidate(INVALIDATE_CAMERA);
+	mContext->PostRender(deltaTime);
+
+	UGPUProfiler::EndFrame();
+
+	Clock::time_point submitEnd = AUtil::GetTime();
+	glFinish();
+	Clock::time_point frameEnd = AUtil::GetTime();
+
+	if (mFrameIndex >= mSettings.mWarmupFrames) {
+		mCPUFrameTimes.push_back(AUtil::GetDeltaTime(frameStart, submitEnd) * 1000.0f);
+		mTotalFrameTimes.push_back(AUtil::GetDeltaTime(frameStart, frameEnd) * 1000.0f);
+
+		if (!mSettings.mImageDir.empty()) {
+			DumpImage(pathFrame);
+		}
+	}
+
+	mFrameIndex++;
+	FrameMark;
+
+	return true;
+}
+
+void AHeadlessApplication::DumpImage(uint32_t frame) {
+	uint32_t width = mSettings.mWidth;
+	uint32_t height = mSettings.mHeight;
+	uint32_t rowSize = width * 3;
+
+	std::vector<uint8_t> pixels(rowSize * height);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTextureImage(mContext->GetMainViewport()->GetColorTexture(), 0, GL_RGB, GL_UNSIGNED_BYTE, GLsizei(pixels.size()), pixels.data());
+
+	char fileName[32];
+	std::snprintf(fileName, sizeof(fileName), "frame_%05u.ppm", frame);
+
+	std::ofstream image(mSettings.mImageDir / fileName, std::ios::binary);
+	image << "P6\n" << width << " " << height << "\n255\n";
+
+	// GL images start at the bottom row.
+	for (uint32_t y = 0; y < height; y++) {
+		image.write(reinterpret_cast<const char*>(pixels.data() + (height - 1 - y) * rowSize), rowSize);
+	}
+}
+
+void AHeadlessApplication::WriteStats() {
+	if (mTotalFrameTimes.empty()) {
+		return;
+	}
+
+	auto percentile = [](std::vector<float> times, float p) {
+		std::sort(times.begin(), times.end());
+		return times[std::min(size_t(p * times.size()), times.size() - 1)];
+	};
+
+	auto mean = [](const std::vector<float>& times) {
+		return std::accumulate(times.begin(), times.end(), 0.0f) / times.size();
+	};
+
+	float totalMean = mean(mTotalFrameTimes);
+
+	std::stringstream stats;
+	stats << "{\n";
+	stats << "  \"renderer\": \"" << glGetString(GL_RENDERER) << "\",\n";
+	stats << "  \"width\": " << mSettings.mWidth << ",\n";
+	stats << "  \"height\": " << mSettings.mHeight << ",\n";
+	stats << "  \"frames\": " << mTotalFrameTimes.size() << ",\n";
+	stats << "  \"fps\": " << 1000.0f / totalMean << ",\n";
+	stats << "  \"cpu_ms\": { \"mean\": " << mean(mCPUFrameTimes) << ", \"p50\": " << percentile(mCPUFrameTimes, 0.5f)
+		<< ", \"p95\": " << percentile(mCPUFrameTimes, 0.95f) << ", \"max\": " << percentile(mCPUFrameTimes, 1.0f) << " },\n";
+	stats << "  \"frame_ms\": { \"mean\": " << totalMean << ", \"min\": " << percentile(mTotalFrameTimes, 0.0f)
+		<< ", \"p50\": " << percentile(mTotalFrameTimes, 0.5f) << ", \"p95\": " << percentile(mTotalFrameTimes, 0.95f)
+		<< ", \"p99\": " << percentile(mTotalFrameTimes, 0.99f) << ", \"max\": " << percentile(mTotalFrameTimes, 1.0f) << " },\n";
+
+	// Rolling averages, so these only cover the tail end of the run.
+	stats << "  \"gpu_passes_ms\": {";
+	std::vector<UGPUProfiler::UZoneStats> gpuStats = UGPUProfiler::GetStats();
+	for (size_t i = 0; i < gpuStats.size(); i++) {
+		stats << (i == 0 ? " " : ", ") << "\"" << gpuStats[i].mName << "\": " << gpuStats[i].mAverageMs;
+	}
+	stats << " },\n";
+
+	stats << "  \"frame_times_ms\": [";
+	for (size_t i = 0; i < mTotalFrameTimes.size(); i++) {
+		stats << (i == 0 ? "" : ", ") << mTotalFrameTimes[i];
+	}
+	stats << "]\n}\n";
+
+	std::cout << "Rendered " << mTotalFrameTimes.size() << " frames, mean " << totalMean << " ms, p95 "
+		<< percentile(mTotalFrameTimes, 0.95f) << " ms, max " << percentile(mTotalFrameTimes, 1.0f) << " ms" << std::endl;
+
+	if (!mSettings.mStatsPath.empty()) {
+		std::ofstream statsFile(mSettings.mStatsPath);
+		statsFile << stats.str();
+	}
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "application/AInput.hpp"
+#include "application/AFrameScheduler.hpp"
 
 #include <GLFW/glfw3.h>
 
@@ -87,6 +88,8 @@ void AInput::UpdateInputState() {
 }
 
 void AInput::GLFWKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+	AFrameScheduler::Invalidate(INVALIDATE_INPUT);
+
 	if (key >= KEY_MAX)
 		return;
 
@@ -97,10 +100,14 @@ void AInput::GLFWKeyCallback(GLFWwindow* window, int key, int scancode, int acti
 }
 
 void AInput::GLFWMousePositionCallback(GLFWwindow* window, double xpos, double ypos) {
+	AFrameScheduler::Invalidate(INVALIDATE_INPUT);
+
 	SetMousePosition(uint32_t(xpos), uint32_t(ypos));
 }
 
 void AInput::GLFWMouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+	AFrameScheduler::Invalidate(INVALIDATE_INPUT);
+
 	if (button >= MOUSE_BUTTON_MAX)
 		return;
 
@@ -111,5 +118,7 @@ void AInput::GLFWMouseButtonCallback(GLFWwindow* window, int button, int action,
 }
 
 void AInput::GLFWMouseScrollCallback(GLFWwindow* window, double xoffset, double yoffset) {
+	AFrameScheduler::Invalidate(INVALIDATE_INPUT);
+
 	SetMouseScrollDelta(uint32_t(yoffset));
 }
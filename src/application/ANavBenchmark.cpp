@@ -0,0 +1,804 @@
+#include "application/ANavBenchmark.hpp"
+#include "application/ATime.hpp"
+#include "nav/UNavAllocator.hpp"
+#include "nav/UNavBuildContext.hpp"
+#include "util/fileutil.hpp"
+#include "util/jobsystem.hpp"
+
+#include <librdr3.hpp>
+#include <Recast.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+
+constexpr const char* RASTER_USAGE = "Usage: navigator --bench-raster [--iterations N] [--cell-size S] [--cell-height H] <file.ynv>...";
+constexpr const char* SCENES_USAGE = "Usage: navigator --bench-recast [--iterations N] [--threads N] [--golden FILE [--update-golden]] [--report FILE]"
+    " [terrain|stairs|overhangs|clutter|plains]...";
+
+namespace {
+    bool ParseUint(const char* str, uint32_t& value) {
+        const char* end = str + std::strlen(str);
+        auto [ptr, error] = std::from_chars(str, end, value);
+        return error == std::errc() && ptr == end;
+    }
+
+    bool ParseFloat(const char* str, float& value) {
+        char* end = nullptr;
+        errno = 0;
+        value = std::strtof(str, &end);
+        return end != str && *end == '\0' && errno == 0 && std::isfinite(value);
+    }
+}
+
+bool ANavBenchmarkSettings::ParseArgs(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        bool bValid = true;
+        bool bTakesValue = arg == "--iterations" || arg == "--cell-size" || arg == "--cell-height" || arg == "--threads" ||
+            arg == "--golden" || arg == "--report";
+
+        if (bTakesValue && value == nullptr) {
+            mArgsError = arg + " needs a value";
+            continue;
+        }
+
+        if (arg == "--bench-raster") {
+            mMode = ENavBenchmarkMode::Rasterization;
+        }
+        else if (arg == "--bench-recast") {
+            mMode = ENavBenchmarkMode::Scenes;
+        }
+        else if (arg == "--iterations") {
+            bValid = ParseUint(value, mIterations) && mIterations != 0;
+        }
+        else if (arg == "--cell-size") {
+            bValid = ParseFloat(value, mCellSize) && mCellSize > 0.0f;
+        }
+        else if (arg == "--cell-height") {
+            bValid = ParseFloat(value, mCellHeight) && mCellHeight > 0.0f;
+        }
+        else if (arg == "--threads") {
+            bValid = ParseUint(value, mThreadCount);
+        }
+        else if (arg == "--golden") {
+            mGoldenPath = value;
+        }
+        else if (arg == "--update-golden") {
+            bUpdateGolden = true;
+        }
+        else if (arg == "--report") {
+            mReportPath = value;
+        }
+        else if (arg.rfind("--", 0) == 0) {
+            mArgsError = "Unknown option " + arg;
+        }
+        else {
+            mScenePaths.push_back(arg);
+        }
+
+        if (bTakesValue) {
+            if (!bValid) {
+                mArgsError = "Invalid value for " + arg + ": " + value;
+            }
+
+            i++;
+        }
+    }
+
+    if (bUpdateGolden && mGoldenPath.empty()) {
+        mArgsError = "--update-golden needs --golden, the copy next to the executable is replaced by every build";
+    }
+
+    return mMode != ENavBenchmarkMode::None;
+}
+
+namespace ANavBenchmark {
+    namespace {
+        struct UBenchScene {
+            std::string mName;
+            std::vector<float> mVertices;
+            std::vector<int32_t> mIndices;
+            std::vector<uint8_t> mAreas;
+            glm::vec3 mBoundsMin = glm::vec3(std::numeric_limits<float>::max());
+            glm::vec3 mBoundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+        };
+
+        struct UHeightfieldDeleter {
+            void operator()(rcHeightfield* hf) const { rcFreeHeightField(hf); }
+        };
+
+        using UHeightfieldPtr = std::unique_ptr<rcHeightfield, UHeightfieldDeleter>;
+
+        const char* PATH_NAMES[] = { "scalar", "sse4.1", "avx2" };
+
+        bool LoadScene(const std::filesystem::path& path, UBenchScene& scene) {
+            std::shared_ptr<CNavmeshData> navmesh = librdr3::ImportYnv(path.string());
+            if (navmesh == nullptr) {
+                return false;
+            }
+
+            float* vertexData = nullptr;
+            uint32_t* indexData = nullptr;
+            uint32_t vertexCount = 0, indexCount = 0;
+            navmesh->GetVertices(vertexData, indexData, vertexCount, indexCount);
+
+            std::unique_ptr<float[]> vertices(vertexData);
+            std::unique_ptr<uint32_t[]> indices(indexData);
+
+            scene.mName = path.filename().string();
+            scene.mVertices.resize(vertexCount * 3);
+            for (uint32_t i = 0; i < vertexCount; i++) {
+                glm::vec3 pos(vertexData[i * 6 + 0], vertexData[i * 6 + 1], vertexData[i * 6 + 2]);
+                scene.mVertices[i * 3 + 0] = pos.x;
+                scene.mVertices[i * 3 + 1] = pos.y;
+                scene.mVertices[i * 3 + 2] = pos.z;
+
+                scene.mBoundsMin = glm::min(scene.mBoundsMin, pos);
+                scene.mBoundsMax = glm::max(scene.mBoundsMax, pos);
+            }
+
+            scene.mIndices.assign(indexData, indexData + indexCount);
+            // Everything walkable, so span merging gets exercised the way a real build does.
+            scene.mAreas.assign(indexCount / 3, RC_WALKABLE_AREA);
+
+            return !scene.mIndices.empty();
+        }
+
+        UHeightfieldPtr Rasterize(rcContext& context, const UBenchScene& scene, const ANavBenchmarkSettings& settings, float& ms) {
+            int width = 0, height = 0;
+            rcCalcGridSize(&scene.mBoundsMin.x, &scene.mBoundsMax.x, settings.mCellSize, &width, &height);
+
+            UHeightfieldPtr hf(rcAllocHeightfield());
+            if (hf == nullptr || !rcCreateHeightfield(&context, *hf, width, height, &scene.mBoundsMin.x, &scene.mBoundsMax.x,
+                settings.mCellSize, settings.mCellHeight))
+            {
+                return nullptr;
+            }
+
+            Clock::time_point start = AUtil::GetTime();
+            bool bOk = rcRasterizeTriangles(&context, scene.mVertices.data(), int(scene.mVertices.size() / 3), scene.mIndices.data(),
+                scene.mAreas.data(), int(scene.mAreas.size()), *hf, 1);
+            ms = AUtil::GetDeltaTime(start, AUtil::GetTime()) * 1000.0f;
+
+            return bOk ? std::move(hf) : nullptr;
+        }
+
+        bool SameSpans(const rcHeightfield& a, const rcHeightfield& b) {
+            if (a.width != b.width || a.height != b.height) {
+                return false;
+            }
+
+            for (int i = 0; i < a.width * a.height; i++) {
+                const rcSpan* spanA = a.spans[i];
+                const rcSpan* spanB = b.spans[i];
+
+                for (; spanA != nullptr && spanB != nullptr; spanA = spanA->next, spanB = spanB->next) {
+                    if (spanA->smin != spanB->smin || spanA->smax != spanB->smax || spanA->area != spanB->area) {
+                        return false;
+                    }
+                }
+
+                if (spanA != spanB) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // Deterministic generators for the synthetic scenes. They stick to integer hashing and basic float
+        // arithmetic (no libm beyond sqrt), so the geometry, and with it the golden hashes, come out the
+        // same with any compiler and standard library.
+        struct URandom {
+            uint32_t mState;
+
+            uint32_t Next() {
+                mState = mState * 1664525u + 1013904223u;
+                return mState;
+            }
+
+            float Range(float min, float max) { return min + (max - min) * float(Next() >> 8) / 16777216.0f; }
+        };
+
+        float LatticeValue(int32_t x, int32_t z) {
+            uint32_t h = uint32_t(x) * 374761393u + uint32_t(z) * 668265263u;
+            h = (h ^ (h >> 13)) * 1274126177u;
+            return float((h ^ (h >> 16)) & 0xffff) / 65535.0f;
+        }
+
+        // Smoothed value noise; x and z must not be negative.
+        float ValueNoise(float x, float z) {
+            int32_t ix = int32_t(x), iz = int32_t(z);
+            float fx = x - float(ix), fz = z - float(iz);
+            fx = fx * fx * (3.0f - 2.0f * fx);
+            fz = fz * fz * (3.0f - 2.0f * fz);
+
+            float top = LatticeValue(ix, iz) + (LatticeValue(ix + 1, iz) - LatticeValue(ix, iz)) * fx;
+            float bottom = LatticeValue(ix, iz + 1) + (LatticeValue(ix + 1, iz + 1) - LatticeValue(ix, iz + 1)) * fx;
+            return top + (bottom - top) * fz;
+        }
+
+        class USceneBuilder {
+            UBenchScene& mScene;
+
+            int32_t AddVertex(const glm::vec3& pos) {
+                mScene.mVertices.insert(mScene.mVertices.end(), { pos.x, pos.y, pos.z });
+                mScene.mBoundsMin = glm::min(mScene.mBoundsMin, pos);
+                mScene.mBoundsMax = glm::max(mScene.mBoundsMax, pos);
+                return int32_t(mScene.mVertices.size() / 3 - 1);
+            }
+
+        public:
+            USceneBuilder(UBenchScene& scene, const char* name) : mScene(scene) { mScene.mName = name; }
+
+            // Faces up when the corners run from -x-z to -x+z to +x+z, as seen from above.
+            void AddQuad(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d) {
+                int32_t base = AddVertex(a);
+                AddVertex(b);
+                AddVertex(c);
+                AddVertex(d);
+
+                mScene.mIndices.insert(mScene.mIndices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+            }
+
+            // A solid with a flat top and bottom; the corners go around the footprint in AddQuad's order.
+            void AddPrism(const glm::vec2 corners[4], float bottom, float top) {
+                glm::vec3 low[4], high[4];
+                for (int i = 0; i < 4; i++) {
+                    low[i] = glm::vec3(corners[i].x, bottom, corners[i].y);
+                    high[i] = glm::vec3(corners[i].x, top, corners[i].y);
+                }
+
+                AddQuad(high[0], high[1], high[2], high[3]);
+                AddQuad(low[3], low[2], low[1], low[0]);
+
+                for (int i = 0; i < 4; i++) {
+                    AddQuad(low[i], high[i], high[(i + 1) % 4], low[(i + 1) % 4]);
+                }
+            }
+
+            void AddBox(const glm::vec3& min, const glm::vec3& max) {
+                const glm::vec2 corners[4] = { { min.x, min.z }, { min.x, max.z }, { max.x, max.z }, { max.x, min.z } };
+                AddPrism(corners, min.y, max.y);
+            }
+
+            // cells x cells quads of the given size, starting at the origin, with height(x, z) at each grid point.
+            template<typename F>
+            void AddGrid(uint32_t cells, float cellSize, F height) {
+                for (uint32_t z = 0; z < cells; z++) {
+                    for (uint32_t x = 0; x < cells; x++) {
+                        auto point = [&](uint32_t px, uint32_t pz) { return glm::vec3(float(px) * cellSize, height(px, pz), float(pz) * cellSize); };
+                        AddQuad(point(x, z), point(x, z + 1), point(x + 1, z + 1), point(x + 1, z));
+                    }
+                }
+            }
+        };
+
+        // Rolling hills with some rough patches, too steep to walk in places.
+        void BuildTerrain(UBenchScene& scene) {
+            USceneBuilder builder(scene, "terrain");
+            builder.AddGrid(128, 1.0f, [](uint32_t x, uint32_t z) {
+                return 8.0f * ValueNoise(float(x) / 24.0f, float(z) / 24.0f) + 2.0f * ValueNoise(float(x) / 6.0f, float(z) / 6.0f)
+                    + 0.6f * ValueNoise(float(x) / 1.5f, float(z) / 1.5f);
+            });
+        }
+
+        // Flights of steps from easily climbable to too tall, plus a gentle and a steep ramp.
+        void BuildStairs(UBenchScene& scene) {
+            USceneBuilder builder(scene, "stairs");
+            builder.AddBox(glm::vec3(0.0f, -0.5f, 0.0f), glm::vec3(56.0f, 0.0f, 40.0f));
+
+            const float stepHeights[] = { 0.2f, 0.3f, 0.5f, 1.0f };
+            const float stepDepths[] = { 0.35f, 0.35f, 0.5f, 0.5f };
+            const uint32_t stepCount = 12;
+
+            for (uint32_t k = 0; k < 4; k++) {
+                float x0 = 4.0f + float(k) * 9.0f;
+                float z = 6.0f;
+
+                for (uint32_t s = 0; s < stepCount; s++) {
+                    builder.AddBox(glm::vec3(x0, 0.0f, z), glm::vec3(x0 + 3.0f, float(s + 1) * stepHeights[k], z + stepDepths[k]));
+                    z += stepDepths[k];
+                }
+
+                builder.AddBox(glm::vec3(x0, 0.0f, z), glm::vec3(x0 + 3.0f, float(stepCount) * stepHeights[k], z + 3.0f));
+            }
+
+            // Rising 1 in 2, then 3 in 2.
+            builder.AddQuad(glm::vec3(42.0f, 0.0f, 6.0f), glm::vec3(42.0f, 0.0f, 9.0f), glm::vec3(50.0f, 4.0f, 9.0f), glm::vec3(50.0f, 4.0f, 6.0f));
+            builder.AddQuad(glm::vec3(42.0f, 0.0f, 20.0f), glm::vec3(42.0f, 0.0f, 23.0f), glm::vec3(46.0f, 6.0f, 23.0f), glm::vec3(46.0f, 6.0f, 20.0f));
+        }
+
+        // Stacked floors with stairwell holes, pillars and bridges at and below head height.
+        void BuildOverhangs(UBenchScene& scene) {
+            USceneBuilder builder(scene, "overhangs");
+            builder.AddBox(glm::vec3(0.0f, -0.5f, 0.0f), glm::vec3(48.0f, 0.0f, 48.0f));
+
+            for (uint32_t floor = 1; floor <= 3; floor++) {
+                float y = float(floor) * 3.0f;
+                float hole = 14.0f + float(floor) * 3.0f;
+
+                builder.AddBox(glm::vec3(10.0f, y, 10.0f), glm::vec3(30.0f, y + 0.3f, hole));
+                builder.AddBox(glm::vec3(10.0f, y, hole + 4.0f), glm::vec3(30.0f, y + 0.3f, 30.0f));
+                builder.AddBox(glm::vec3(10.0f, y, hole), glm::vec3(hole, y + 0.3f, hole + 4.0f));
+                builder.AddBox(glm::vec3(hole + 4.0f, y, hole), glm::vec3(30.0f, y + 0.3f, hole + 4.0f));
+            }
+
+            for (float x : { 10.0f, 29.4f }) {
+                for (float z : { 10.0f, 29.4f }) {
+                    builder.AddBox(glm::vec3(x, 0.0f, z), glm::vec3(x + 0.6f, 9.3f, z + 0.6f));
+                }
+            }
+
+            // Up to the first floor.
+            builder.AddQuad(glm::vec3(4.0f, 0.0f, 12.0f), glm::vec3(4.0f, 0.0f, 15.0f), glm::vec3(10.0f, 3.0f, 15.0f), glm::vec3(10.0f, 3.0f, 12.0f));
+
+            // Too low to walk under, just high enough, and a table top on a single leg.
+            builder.AddBox(glm::vec3(34.0f, 1.5f, 5.0f), glm::vec3(44.0f, 1.7f, 8.0f));
+            builder.AddBox(glm::vec3(34.0f, 2.5f, 12.0f), glm::vec3(44.0f, 2.8f, 15.0f));
+            builder.AddBox(glm::vec3(35.0f, 1.0f, 20.0f), glm::vec3(41.0f, 1.2f, 26.0f));
+            builder.AddBox(glm::vec3(37.7f, 0.0f, 22.7f), glm::vec3(38.3f, 1.0f, 23.3f));
+        }
+
+        // Lots of small rotated boxes, the sort of debris that breaks regions up.
+        void BuildClutter(UBenchScene& scene) {
+            USceneBuilder builder(scene, "clutter");
+            builder.AddBox(glm::vec3(0.0f, -0.5f, 0.0f), glm::vec3(64.0f, 0.0f, 64.0f));
+
+            URandom random = { 12345 };
+            for (uint32_t i = 0; i < 1500; i++) {
+                glm::vec2 center(random.Range(2.0f, 62.0f), random.Range(2.0f, 62.0f));
+                glm::vec2 halfSize(random.Range(0.1f, 1.0f), random.Range(0.1f, 1.0f));
+                float height = random.Range(0.1f, 1.6f);
+
+                glm::vec2 axis(float(int32_t(random.Next() % 201) - 100), float(int32_t(random.Next() % 201) - 100));
+                float length = std::sqrt(axis.x * axis.x + axis.y * axis.y);
+                axis = length > 0.0f ? axis / length : glm::vec2(1.0f, 0.0f);
+
+                glm::vec2 u = axis * halfSize.x;
+                glm::vec2 v = glm::vec2(-axis.y, axis.x) * halfSize.y;
+                const glm::vec2 corners[4] = { center - u - v, center - u + v, center + u + v, center + u - v };
+                builder.AddPrism(corners, 0.0f, height);
+            }
+        }
+
+        // One big flat region, which is what the watershed and the detail mesh like least.
+        void BuildPlains(UBenchScene& scene) {
+            USceneBuilder builder(scene, "plains");
+            builder.AddGrid(32, 12.5f, [](uint32_t, uint32_t) { return 0.0f; });
+        }
+
+        // Recast's sample values for a human-sized agent, the same as UNavGenSettings' defaults. Fixed, so
+        // the golden hashes stay comparable between runs.
+        rcConfig MakeSceneConfig(const UBenchScene& scene) {
+            rcConfig config = {};
+            config.cs = 0.3f;
+            config.ch = 0.2f;
+            config.walkableSlopeAngle = 45.0f;
+            config.walkableHeight = 10;
+            config.walkableClimb = 4;
+            config.walkableRadius = 2;
+            config.maxEdgeLen = 40;
+            config.maxSimplificationError = 1.3f;
+            config.minRegionArea = 64;
+            config.mergeRegionArea = 400;
+            config.maxVertsPerPoly = 6;
+            config.detailSampleDist = config.cs * 6.0f;
+            config.detailSampleMaxError = config.ch * 1.0f;
+
+            rcVcopy(config.bmin, &scene.mBoundsMin.x);
+            rcVcopy(config.bmax, &scene.mBoundsMax.x);
+            rcCalcGridSize(config.bmin, config.bmax, config.cs, &config.width, &config.height);
+
+            return config;
+        }
+
+        struct UCompactHeightfieldDeleter { void operator()(rcCompactHeightfield* p) const { rcFreeCompactHeightfield(p); } };
+        struct UContourSetDeleter { void operator()(rcContourSet* p) const { rcFreeContourSet(p); } };
+        struct UPolyMeshDeleter { void operator()(rcPolyMesh* p) const { rcFreePolyMesh(p); } };
+        struct UPolyMeshDetailDeleter { void operator()(rcPolyMeshDetail* p) const { rcFreePolyMeshDetail(p); } };
+
+        // The pipeline's integer outputs. The detail mesh is left out; its vertices are floats that
+        // depend on the compiler's choice of instructions.
+        const char* HASH_NAMES[] = { "chf", "regions", "contours", "polymesh" };
+        constexpr uint32_t HASH_COUNT = 4;
+
+        struct USceneHashes {
+            uint64_t mHashes[HASH_COUNT] = {};
+
+            bool operator==(const USceneHashes& other) const { return std::equal(mHashes, mHashes + HASH_COUNT, other.mHashes); }
+            bool operator!=(const USceneHashes& other) const { return !(*this == other); }
+        };
+
+        uint64_t HashValue(uint32_t value, uint64_t hash) {
+            return UFileUtil::Hash(&value, sizeof(value), hash);
+        }
+
+        // Before regions are built, so just the spans, their links and the eroded areas.
+        uint64_t HashCompactHeightfield(const rcCompactHeightfield& chf) {
+            uint64_t hash = HashValue(uint32_t(chf.width), HashValue(uint32_t(chf.height), UFileUtil::Hash(nullptr, 0)));
+
+            for (int i = 0; i < chf.width * chf.height; i++) {
+                hash = HashValue(chf.cells[i].index, HashValue(chf.cells[i].count, hash));
+            }
+
+            for (int i = 0; i < chf.spanCount; i++) {
+                const rcCompactSpan& span = chf.spans[i];
+                hash = HashValue(span.y, HashValue(span.con, HashValue(span.h, hash)));
+            }
+
+            return UFileUtil::Hash(chf.areas, size_t(chf.spanCount), hash);
+        }
+
+        uint64_t HashRegions(const rcCompactHeightfield& chf) {
+            uint64_t hash = HashValue(chf.maxRegions, UFileUtil::Hash(nullptr, 0));
+
+            for (int i = 0; i < chf.spanCount; i++) {
+                hash = HashValue(chf.spans[i].reg, hash);
+            }
+
+            return hash;
+        }
+
+        uint64_t HashContours(const rcContourSet& contours) {
+            uint64_t hash = HashValue(uint32_t(contours.nconts), UFileUtil::Hash(nullptr, 0));
+
+            for (int i = 0; i < contours.nconts; i++) {
+                const rcContour& contour = contours.conts[i];
+                hash = HashValue(contour.reg, HashValue(contour.area, HashValue(uint32_t(contour.nverts), hash)));
+                hash = UFileUtil::Hash(contour.verts, sizeof(int) * 4 * size_t(contour.nverts), hash);
+            }
+
+            return hash;
+        }
+
+        uint64_t HashPolyMesh(const rcPolyMesh& mesh) {
+            uint64_t hash = HashValue(uint32_t(mesh.nverts), HashValue(uint32_t(mesh.npolys), UFileUtil::Hash(nullptr, 0)));
+            hash = UFileUtil::Hash(mesh.verts, sizeof(unsigned short) * 3 * size_t(mesh.nverts), hash);
+            hash = UFileUtil::Hash(mesh.polys, sizeof(unsigned short) * 2 * size_t(mesh.nvp) * size_t(mesh.npolys), hash);
+            hash = UFileUtil::Hash(mesh.regs, sizeof(unsigned short) * size_t(mesh.npolys), hash);
+
+            return UFileUtil::Hash(mesh.areas, size_t(mesh.npolys), hash);
+        }
+
+        // The same steps GenerateNavmesh takes for a tile, on the whole scene at once.
+        bool BuildScene(UNav::UNavBuildContext& context, const UBenchScene& scene, const rcConfig& config, USceneHashes& hashes) {
+            UNavAllocator::UTileScope allocScope;
+            rcScopedTimer totalTimer(&context, RC_TIMER_TOTAL);
+
+            const int vertexCount = int(scene.mVertices.size() / 3);
+            const int triangleCount = int(scene.mIndices.size() / 3);
+
+            std::vector<uint8_t> areas(size_t(triangleCount), 0);
+            rcMarkWalkableTriangles(&context, config.walkableSlopeAngle, scene.mVertices.data(), vertexCount, scene.mIndices.data(),
+                triangleCount, areas.data());
+
+            UHeightfieldPtr solid(rcAllocHeightfield());
+            if (solid == nullptr || !rcCreateHeightfield(&context, *solid, config.width, config.height, config.bmin, config.bmax, config.cs, config.ch) ||
+                !rcRasterizeTriangles(&context, scene.mVertices.data(), vertexCount, scene.mIndices.data(), areas.data(), triangleCount,
+                    *solid, config.walkableClimb))
+            {
+                return false;
+            }
+
+            rcFilterLowHangingWalkableObstacles(&context, config.walkableClimb, *solid);
+            rcFilterLedgeSpans(&context, config.walkableHeight, config.walkableClimb, *solid);
+            rcFilterWalkableLowHeightSpans(&context, config.walkableHeight, *solid);
+
+            std::unique_ptr<rcCompactHeightfield, UCompactHeightfieldDeleter> chf(rcAllocCompactHeightfield());
+            if (chf == nullptr || !rcBuildCompactHeightfield(&context, config.walkableHeight, config.walkableClimb, *solid, *chf)) {
+                return false;
+            }
+
+            solid.reset();
+
+            if (!rcErodeWalkableArea(&context, config.walkableRadius, *chf)) {
+                return false;
+            }
+
+            hashes.mHashes[0] = HashCompactHeightfield(*chf);
+
+            if (!rcBuildDistanceField(&context, *chf) || !rcBuildRegions(&context, *chf, 0, config.minRegionArea, config.mergeRegionArea)) {
+                return false;
+            }
+
+            hashes.mHashes[1] = HashRegions(*chf);
+
+            std::unique_ptr<rcContourSet, UContourSetDeleter> contours(rcAllocContourSet());
+            if (contours == nullptr || !rcBuildContours(&context, *chf, config.maxSimplificationError, config.maxEdgeLen, *contours)) {
+                return false;
+            }
+
+            hashes.mHashes[2] = HashContours(*contours);
+
+            std::unique_ptr<rcPolyMesh, UPolyMeshDeleter> polyMesh(rcAllocPolyMesh());
+            if (polyMesh == nullptr || !rcBuildPolyMesh(&context, *contours, config.maxVertsPerPoly, *polyMesh)) {
+                return false;
+            }
+
+            hashes.mHashes[3] = HashPolyMesh(*polyMesh);
+
+            std::unique_ptr<rcPolyMeshDetail, UPolyMeshDetailDeleter> detailMesh(rcAllocPolyMeshDetail());
+            return detailMesh != nullptr &&
+                rcBuildPolyMeshDetail(&context, *polyMesh, *chf, config.detailSampleDist, config.detailSampleMaxError, *detailMesh);
+        }
+
+        // "<scene> <output> <hash>" per line; # starts a comment.
+        std::map<std::string, uint64_t> ReadGolden(const std::filesystem::path& path) {
+            std::map<std::string, uint64_t> golden;
+            std::ifstream file(path);
+            std::string line;
+
+            while (std::getline(file, line)) {
+                if (line.empty() || line[0] == '#') {
+                    continue;
+                }
+
+                std::string scene, output, hash;
+                std::stringstream lineStream(line);
+                lineStream >> scene >> output >> hash;
+
+                if (!lineStream.fail()) {
+                    golden[scene + " " + output] = std::stoull(hash, nullptr, 16);
+                }
+            }
+
+            return golden;
+        }
+    }
+
+    int RunRasterization(const ANavBenchmarkSettings& settings) {
+        std::vector<UBenchScene> scenes;
+        for (const std::filesystem::path& path : settings.mScenePaths) {
+            UBenchScene scene;
+            if (!LoadScene(path, scene)) {
+                std::cout << "Skipping " << path.string() << ", not a navmesh with triangles" << std::endl;
+                continue;
+            }
+
+            scenes.push_back(std::move(scene));
+        }
+
+        if (scenes.empty()) {
+            std::cout << RASTER_USAGE << std::endl;
+            return 1;
+        }
+
+        rcContext context(false);
+        const rcRasterizationPath originalPath = rcGetRasterizationPath();
+        const rcRasterizationPath paths[] = { RC_RASTER_SCALAR, RC_RASTER_SSE41, RC_RASTER_AVX2 };
+
+        bool bMatched = true;
+        float totals[3] = {};
+
+        for (const UBenchScene& scene : scenes) {
+            std::printf("%s: %zu triangles\n", scene.mName.c_str(), scene.mAreas.size());
+
+            UHeightfieldPtr reference;
+            for (rcRasterizationPath path : paths) {
+                if (!rcSetRasterizationPath(path)) {
+                    continue;
+                }
+
+                float best = std::numeric_limits<float>::max();
+                UHeightfieldPtr hf;
+                for (uint32_t i = 0; i < settings.mIterations; i++) {
+                    float ms = 0.0f;
+                    hf = Rasterize(context, scene, settings, ms);
+                    if (hf == nullptr) {
+                        break;
+                    }
+
+                    best = std::min(best, ms);
+                }
+
+                if (hf == nullptr) {
+                    std::printf("  %-7s failed\n", PATH_NAMES[path]);
+                    bMatched = false;
+                    continue;
+                }
+
+                const char* check = "";
+                if (reference == nullptr) {
+                    reference = std::move(hf);
+                }
+                else if (SameSpans(*reference, *hf)) {
+                    check = ", spans match";
+                }
+                else {
+                    check = ", SPANS DIFFER";
+                    bMatched = false;
+                }
+
+                totals[path] += best;
+                std::printf("  %-7s %8.3f ms%s\n", PATH_NAMES[path], best, check);
+            }
+        }
+
+        rcSetRasterizationPath(originalPath);
+
+        std::printf("Total:\n");
+        for (rcRasterizationPath path : paths) {
+            if (rcIsRasterizationPathSupported(path)) {
+                std::printf("  %-7s %8.3f ms (%.2fx)\n", PATH_NAMES[path], totals[path], totals[path] > 0.0f ? totals[RC_RASTER_SCALAR] / totals[path] : 0.0f);
+            }
+        }
+
+        return bMatched ? 0 : 1;
+    }
+    int RunScenes(const ANavBenchmarkSettings& settings) {
+        void (*const builders[])(UBenchScene&) = { BuildTerrain, BuildStairs, BuildOverhangs, BuildClutter, BuildPlains };
+
+        std::vector<UBenchScene> scenes;
+        for (auto build : builders) {
+            UBenchScene scene;
+            build(scene);
+
+            bool bSelected = settings.mScenePaths.empty() || std::any_of(settings.mScenePaths.begin(), settings.mScenePaths.end(),
+                [&](const std::filesystem::path& name) { return name == scene.mName; });
+
+            if (bSelected) {
+                scenes.push_back(std::move(scene));
+            }
+        }
+
+        if (scenes.empty()) {
+            std::cout << SCENES_USAGE << std::endl;
+            return 1;
+        }
+
+        // The asset folder is copied next to the executable, so the default doesn't depend on where it's run from.
+        const std::filesystem::path goldenPath = settings.mGoldenPath.empty() ?
+            UFileUtil::GetExecutableDirectory() / "asset" / "navbench" / "golden.txt" : settings.mGoldenPath;
+
+        const std::map<std::string, uint64_t> golden = settings.bUpdateGolden ? std::map<std::string, uint64_t>() : ReadGolden(goldenPath);
+        if (!settings.bUpdateGolden && golden.empty()) {
+            std::cout << "No golden hashes in " << goldenPath.string() << ", run with --update-golden to create them" << std::endl;
+            return 1;
+        }
+
+        UJobSystem::Init(settings.mThreadCount);
+        UNavAllocator::Install();
+
+        bool bPassed = true;
+        std::stringstream goldenOut;
+        goldenOut << "# Recast output hashes for the --bench-recast scenes. Regenerate with --update-golden after a deliberate change.\n";
+
+        std::stringstream report;
+        report << "{\n  \"threads\": " << UJobSystem::GetThreadCount() + 1 << ",\n  \"iterations\": " << settings.mIterations << ",\n  \"scenes\": [";
+
+        bool bFirstReport = true;
+        for (const UBenchScene& scene : scenes) {
+            const rcConfig config = MakeSceneConfig(scene);
+            std::printf("%s: %zu triangles, %dx%d cells\n", scene.mName.c_str(), scene.mIndices.size() / 3, config.width, config.height);
+
+            // Averages cover the parallel iterations only; the serial one is its own baseline.
+            UNav::UNavBuildProfiler profiler;
+            double serialMs = 0.0;
+            USceneHashes hashes;
+            bool bBuilt = true, bStable = true;
+
+            for (uint32_t i = 0; i < settings.mIterations && bBuilt; i++) {
+                UNav::UNavBuildContext context;
+                context.enableParallel(i != 0);
+
+                USceneHashes iterationHashes;
+                bBuilt = BuildScene(context, scene, config, iterationHashes);
+
+                if (i == 0) {
+                    serialMs = context.GetStageMs(RC_TIMER_TOTAL);
+                    hashes = iterationHashes;
+                }
+                else {
+                    profiler.Add(context);
+
+                    if (iterationHashes != hashes) {
+                        bStable = false;
+                    }
+                }
+
+                if (!bBuilt) {
+                    std::printf("  build failed: %s\n", context.mError.c_str());
+                }
+            }
+
+            std::printf("  %-24s %9.3f ms\n", "Serial total", serialMs);
+
+            const UNav::UNavBuildProfile profile = profiler.GetProfile();
+            for (const UNav::UNavStageTime& stage : profile.mStages) {
+                std::printf("  %*s%-*s %9.3f ms\n", int(stage.mDepth) * 2, "", 24 - int(stage.mDepth) * 2, stage.mName, stage.mTotalMs / stage.mTileCount);
+            }
+
+            if (!bBuilt) {
+                bPassed = false;
+                continue;
+            }
+
+            if (!bStable) {
+                std::printf("  OUTPUT CHANGED between iterations with serial and parallel steps\n");
+                bPassed = false;
+            }
+
+            report << (bFirstReport ? "\n" : ",\n") << "    { \"name\": \"" << scene.mName << "\", \"hashes\": {";
+            bFirstReport = false;
+
+            for (uint32_t h = 0; h < HASH_COUNT; h++) {
+                char hash[17];
+                std::snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)hashes.mHashes[h]);
+                goldenOut << scene.mName << " " << HASH_NAMES[h] << " " << hash << "\n";
+                report << (h == 0 ? " " : ", ") << "\"" << HASH_NAMES[h] << "\": \"" << hash << "\"";
+
+                if (settings.bUpdateGolden) {
+                    std::printf("  %-9s %s\n", HASH_NAMES[h], hash);
+                    continue;
+                }
+
+                auto expected = golden.find(scene.mName + " " + HASH_NAMES[h]);
+                if (expected == golden.end()) {
+                    std::printf("  %-9s %s, no golden hash\n", HASH_NAMES[h], hash);
+                    bPassed = false;
+                }
+                else if (expected->second != hashes.mHashes[h]) {
+                    std::printf("  %-9s %s, EXPECTED %016llx\n", HASH_NAMES[h], hash, (unsigned long long)expected->second);
+                    bPassed = false;
+                }
+                else {
+                    std::printf("  %-9s %s, matches\n", HASH_NAMES[h], hash);
+                }
+            }
+
+            report << " },\n      \"serial_ms\": " << serialMs << ",\n      \"profile\": " << profile.ToJson() << "    }";
+        }
+
+        report << "\n  ]\n}\n";
+
+        UJobSystem::Shutdown();
+
+        if (!settings.mReportPath.empty()) {
+            std::ofstream reportFile(settings.mReportPath);
+            reportFile << report.str();
+        }
+
+        if (settings.bUpdateGolden) {
+            std::ofstream goldenFile(goldenPath);
+            goldenFile << goldenOut.str();
+
+            if (!goldenFile.good()) {
+                std::cout << "Couldn't write " << goldenPath.string() << std::endl;
+                return 1;
+            }
+
+            std::cout << "Wrote golden hashes to " << goldenPath.string() << std::endl;
+        }
+
+        std::cout << (bPassed ? "All scenes passed" : "FAILED") << std::endl;
+        return bPassed ? 0 : 1;
+    }
+
+    int Run(const ANavBenchmarkSettings& settings) {
+        if (!settings.mArgsError.empty()) {
+            std::cout << settings.mArgsError << std::endl;
+            std::cout << (settings.mMode == ENavBenchmarkMode::Rasterization ? RASTER_USAGE : SCENES_USAGE) << std::endl;
+            return 1;
+        }
+
+        switch (settings.mMode) {
+            case ENavBenchmarkMode::Rasterization: return RunRasterization(settings);
+            case ENavBenchmarkMode::Scenes: return RunScenes(settings);
+            default: return 1;
+        }
+    }
+}
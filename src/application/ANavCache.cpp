@@ -0,0 +1,133 @@
+#include "application/ANavCache.hpp"
+#include "application/ANavContext.hpp"
+#include "util/fileutil.hpp"
+#include "util/mappedfile.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace ANavCache {
+    namespace {
+        constexpr uint32_t MAGIC = 0x4256414E; // "NAVB"
+
+        // The packed geometry follows the header, then the BVH.
+        struct ABlobHeader {
+            uint32_t mMagic;
+            uint32_t mVersion;
+            uint64_t mContentHash;
+
+            uint32_t mVertexCount;
+            uint32_t mIndexCount;
+            float mBoundsMin[3];
+            float mBoundsMax[3];
+
+            uint32_t mPackedSize;
+            uint32_t mBVHSize;
+        };
+    }
+}
+
+std::filesystem::path ANavCache::GetBlobPath(uint64_t contentHash) {
+    char fileName[32];
+    snprintf(fileName, sizeof(fileName), "%016llx.nvb", (unsigned long long)contentHash);
+
+    return UFileUtil::GetCacheDirectory("navmesh") / fileName;
+}
+
+bool ANavCache::Read(const std::filesystem::path& blobPath, uint64_t contentHash, ANavmeshGeometry& geometry, UStagingBuffer& staging) {
+    ZoneScoped;
+
+    UMappedFile file;
+    if (!file.Open(blobPath) || file.GetSize() < sizeof(ABlobHeader)) {
+        return false;
+    }
+
+    ABlobHeader header;
+    std::memcpy(&header, file.GetData(), sizeof(header));
+
+    if (header.mMagic != MAGIC || header.mVersion != VERSION || header.mContentHash != contentHash ||
+        header.mPackedSize != ANavmeshArena::GetPackedSize(header.mVertexCount, header.mIndexCount) ||
+        file.GetSize() != sizeof(header) + size_t(header.mPackedSize) + header.mBVHSize)
+    {
+        return false;
+    }
+
+    const uint8_t* packed = file.GetData() + sizeof(header);
+
+    std::shared_ptr<UNav::UNavBVH> bvh = std::make_shared<UNav::UNavBVH>();
+    if (!bvh->Deserialize(packed + header.mPackedSize, header.mBVHSize)) {
+        return false;
+    }
+
+    geometry.mVertexCount = header.mVertexCount;
+    geometry.mIndexCount = header.mIndexCount;
+    geometry.mBoundsMin = glm::vec3(header.mBoundsMin[0], header.mBoundsMin[1], header.mBoundsMin[2]);
+    geometry.mBoundsMax = glm::vec3(header.mBoundsMax[0], header.mBoundsMax[1], header.mBoundsMax[2]);
+    geometry.mBVH = bvh;
+
+    geometry.mStaging = staging.Allocate(header.mPackedSize);
+    if (geometry.mStaging.IsValid()) {
+        std::memcpy(geometry.mStaging.mData, packed, header.mPackedSize);
+    }
+    else {
+        geometry.mPacked = std::make_unique<uint8_t[]>(header.mPackedSize);
+        std::memcpy(geometry.mPacked.get(), packed, header.mPackedSize);
+    }
+
+    return true;
+}
+
+bool ANavCache::Write(const std::filesystem::path& blobPath, uint64_t contentHash, const ANavmeshGeometry& geometry, const uint8_t* packed) {
+    ZoneScoped;
+
+    ABlobHeader header = {};
+    header.mMagic = MAGIC;
+    header.mVersion = VERSION;
+    header.mContentHash = contentHash;
+    header.mVertexCount = geometry.mVertexCount;
+    header.mIndexCount = geometry.mIndexCount;
+    std::memcpy(header.mBoundsMin, &geometry.mBoundsMin[0], sizeof(header.mBoundsMin));
+    std::memcpy(header.mBoundsMax, &geometry.mBoundsMax[0], sizeof(header.mBoundsMax));
+    header.mPackedSize = ANavmeshArena::GetPackedSize(geometry.mVertexCount, geometry.mIndexCount);
+
+    std::vector<uint8_t> bvh;
+    if (geometry.mBVH != nullptr) {
+        bvh.resize(geometry.mBVH->GetSerializedSize());
+        geometry.mBVH->Serialize(bvh.data());
+    }
+
+    header.mBVHSize = uint32_t(bvh.size());
+
+    // Written alongside and renamed into place, so a reader never maps a partial blob.
+    std::filesystem::path tempPath = blobPath;
+    tempPath += ".tmp";
+
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(packed), header.mPackedSize);
+        file.write(reinterpret_cast<const char*>(bvh.data()), std::streamsize(bvh.size()));
+
+        if (!file) {
+            file.close();
+
+            std::error_code error;
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, blobPath, error);
+    if (error) {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    return true;
+}
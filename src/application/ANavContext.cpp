@@ -1,136 +1,847 @@
 #include "application/ANavContext.hpp"
+#include "application/AFrameScheduler.hpp"
+#include "application/ANavCache.hpp"
+#include "application/AOptions.hpp"
 #include "ubo/common.hpp"
 #include "ubo/litsimple.hpp"
 #include "util/fileutil.hpp"
+#include "util/gpuprofiler.hpp"
+#include "util/jobsystem.hpp"
+#include "application/ATime.hpp"
 
 #include <glad/glad.h>
+#include <imgui.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+constexpr uint32_t NAV_STAGING_SIZE = 64 * 1024 * 1024;
+
+// Starting arena sizes; they double whenever a tile doesn't fit.
+constexpr uint32_t NAV_ARENA_INITIAL_VERTICES = 256 * 1024;
+constexpr uint32_t NAV_ARENA_INITIAL_INDICES = 1024 * 1024;
+
+namespace {
+    // Gribb/Hartmann plane extraction; planes point inwards.
+    std::array<glm::vec4, 6> GetFrustumPlanes(const glm::mat4& viewProj) {
+        glm::mat4 m = glm::transpose(viewProj);
+
+        std::array<glm::vec4, 6> planes = {
+            m[3] + m[0], m[3] - m[0],
+            m[3] + m[1], m[3] - m[1],
+            m[3] + m[2], m[3] - m[2]
+        };
+
+        for (glm::vec4& p : planes) {
+            p /= glm::length(glm::vec3(p));
+        }
+
+        return planes;
+    }
+
+    bool IsBoxInFrustum(const std::array<glm::vec4, 6>& planes, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+        for (const glm::vec4& p : planes) {
+            // Corner furthest along the plane normal.
+            glm::vec3 corner(p.x >= 0.0f ? boundsMax.x : boundsMin.x, p.y >= 0.0f ? boundsMax.y : boundsMin.y, p.z >= 0.0f ? boundsMax.z : boundsMin.z);
 
-constexpr uint32_t VERTEX_ATTRIB_INDEX = 0;
-constexpr uint32_t NORMAL_ATTRIB_INDEX = 1;
+            if (glm::dot(glm::vec3(p), corner) + p.w < 0.0f) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::filesystem::path GetHeightGridPath(uint64_t gridHash) {
+        char fileName[32];
+        snprintf(fileName, sizeof(fileName), "%016llx.hgt", (unsigned long long)gridHash);
+
+        return UFileUtil::GetCacheDirectory("heightgrid") / fileName;
+    }
 
-ANavmeshRenderData::ANavmeshRenderData() : mNavIndexCount(0), mNavVBO(0), mNavIBO(0), mNavVAO(0) {
+    // Rasterizes a navmesh's height grid and caches it. The grid that comes back is mapped from the
+    // cache file, or stays on the heap if the file couldn't be written.
+    std::shared_ptr<UNav::UHeightGrid> BuildHeightGrid(const std::filesystem::path& gridPath, uint64_t gridHash, const float* vertices, uint32_t vertexCount,
+        const uint32_t* indices, uint32_t indexCount, const glm::vec3& boundsMin, const glm::vec3& boundsMax, float cellSize)
+    {
+        ZoneScoped;
 
+        std::shared_ptr<UNav::UHeightGrid> grid = std::make_shared<UNav::UHeightGrid>();
+        grid->Build(vertices, 6, vertexCount, indices, indexCount, boundsMin, boundsMax, cellSize, gridHash);
+
+        if (grid->Save(gridPath)) {
+            std::shared_ptr<UNav::UHeightGrid> mapped = std::make_shared<UNav::UHeightGrid>();
+            if (mapped->Load(gridPath, gridHash)) {
+                return mapped;
+            }
+        }
+
+        return grid;
+    }
+
+    // Buckets tiles by their XZ footprint so a vertical ray only visits the tiles that are actually under it.
+    class UTileColumnGrid {
+        std::vector<const ANavmesh*> mTiles;
+        std::vector<std::vector<uint32_t>> mCells;
+
+        glm::vec2 mOrigin = glm::vec2(0.0f);
+        float mInvCellSize = 0.0f;
+        uint32_t mWidth = 0;
+        uint32_t mHeight = 0;
+
+    public:
+        static constexpr uint32_t MAX_DIMENSION = 256;
+
+        void Build(const std::unordered_map<std::string, std::shared_ptr<ANavmesh>>& navmeshes) {
+            glm::vec2 boundsMin(std::numeric_limits<float>::max());
+            glm::vec2 boundsMax(std::numeric_limits<float>::lowest());
+            float totalSize = 0.0f;
+
+            for (const auto& [path, navmesh] : navmeshes) {
+                const ANavmeshTile& tile = navmesh->mTile;
+
+                boundsMin = glm::min(boundsMin, glm::vec2(tile.mBoundsMin.x, tile.mBoundsMin.z));
+                boundsMax = glm::max(boundsMax, glm::vec2(tile.mBoundsMax.x, tile.mBoundsMax.z));
+                totalSize += std::max(tile.mBoundsMax.x - tile.mBoundsMin.x, tile.mBoundsMax.z - tile.mBoundsMin.z);
+
+                mTiles.push_back(navmesh.get());
+            }
+
+            if (mTiles.empty()) {
+                return;
+            }
+
+            // Roughly one tile per cell, within limits.
+            glm::vec2 extent = glm::max(boundsMax - boundsMin, glm::vec2(1.0f));
+            float cellSize = std::max({ totalSize / float(mTiles.size()), extent.x / MAX_DIMENSION, extent.y / MAX_DIMENSION, 1.0f });
+
+            mOrigin = boundsMin;
+            mInvCellSize = 1.0f / cellSize;
+            mWidth = std::min(uint32_t(extent.x * mInvCellSize) + 1, MAX_DIMENSION);
+            mHeight = std::min(uint32_t(extent.y * mInvCellSize) + 1, MAX_DIMENSION);
+            mCells.resize(size_t(mWidth) * mHeight);
+
+            for (uint32_t i = 0; i < mTiles.size(); i++) {
+                const ANavmeshTile& tile = mTiles[i]->mTile;
+
+                uint32_t x0, z0, x1, z1;
+                GetCell(glm::vec2(tile.mBoundsMin.x, tile.mBoundsMin.z), x0, z0);
+                GetCell(glm::vec2(tile.mBoundsMax.x, tile.mBoundsMax.z), x1, z1);
+
+                for (uint32_t z = z0; z <= z1; z++) {
+                    for (uint32_t x = x0; x <= x1; x++) {
+                        mCells[size_t(z) * mWidth + x].push_back(i);
+                    }
+                }
+            }
+        }
+
+        void GetCell(const glm::vec2& p, uint32_t& x, uint32_t& z) const {
+            glm::vec2 cell = glm::clamp((p - mOrigin) * mInvCellSize, glm::vec2(0.0f), glm::vec2(float(mWidth - 1), float(mHeight - 1)));
+            x = uint32_t(cell.x);
+            z = uint32_t(cell.y);
+        }
+
+        // First hit going straight down from top, no further than bottom.
+        bool CastDown(const glm::vec3& top, float bottom, glm::vec3& hitPosition) const {
+            if (mTiles.empty()) {
+                return false;
+            }
+
+            uint32_t x, z;
+            GetCell(glm::vec2(top.x, top.z), x, z);
+
+            float maxDistance = top.y - bottom;
+            bool bHit = false;
+
+            for (uint32_t tileIdx : mCells[size_t(z) * mWidth + x]) {
+                const ANavmesh* navmesh = mTiles[tileIdx];
+                const ANavmeshTile& tile = navmesh->mTile;
+
+                if (top.x < tile.mBoundsMin.x || top.x > tile.mBoundsMax.x || top.z < tile.mBoundsMin.z || top.z > tile.mBoundsMax.z ||
+                    tile.mBoundsMin.y > top.y || top.y - tile.mBoundsMax.y >= maxDistance)
+                {
+                    continue;
+                }
+
+                UNav::URayHit hit;
+                if (navmesh->mBVH->Raycast(top, glm::vec3(0.0f, -1.0f, 0.0f), maxDistance, hit)) {
+                    maxDistance = hit.mDistance;
+                    hitPosition = hit.mPosition;
+                    bHit = true;
+                }
+            }
+
+            return bHit;
+        }
+    };
 }
 
-ANavmeshRenderData::~ANavmeshRenderData() {
-    DeleteNavResources();
+ANavContext::ANavContext() : mLitSimpleProgram(0), mLoadQueue(std::make_shared<ANavLoadQueue>()), mBatchTotal(0), mBatchUploaded(0), bHasHoverHit(false) {
+    mLoadQueue->mStaging = std::make_shared<UStagingBuffer>();
 }
 
-void ANavmeshRenderData::CreateNavResources(std::shared_ptr<CNavmeshData> data) {
-    uint32_t numVertices = 0;
-    float* vertexData = nullptr;
-    uint32_t* indexData = nullptr;
-    data->GetVertices(vertexData, indexData, numVertices, mNavIndexCount);
+ANavContext::~ANavContext() {
+    glDeleteProgram(mLitSimpleProgram);
+    mLitSimpleProgram = 0;
+
+    mLoadQueue->mStaging->Destroy();
+    mArena.Destroy();
+}
 
-    //data->GetIndicesForPolys(indexData, mNavIndexCount);
+void ANavContext::LoadNavmesh(std::filesystem::path filePath) {
+    std::string key = filePath.generic_string();
+
+    if (mLoadedNavmeshes.count(key) != 0) {
+        return;
+    }
 
-    DeleteNavResources();
+    if (mPendingLoads.count(key) != 0) {
+        // Still in flight from before it was cancelled; just keep the result this time. If the job
+        // skipped it in the meantime, UploadGeometry starts the load again.
+        std::lock_guard<std::mutex> lock(mLoadQueue->mMutex);
+        mLoadQueue->mCancelled.erase(key);
 
-    glCreateBuffers(1, &mNavVBO);
-    glCreateBuffers(1, &mNavIBO);
+        return;
+    }
 
-    glNamedBufferStorage(mNavVBO, numVertices    * (sizeof(glm::vec3) + sizeof(glm::vec3)), vertexData, GL_MAP_WRITE_BIT | GL_DYNAMIC_STORAGE_BIT);
-    glNamedBufferStorage(mNavIBO, mNavIndexCount * sizeof(uint32_t),  indexData,  GL_MAP_WRITE_BIT | GL_DYNAMIC_STORAGE_BIT);
+    mPendingLoads.insert(key);
+    mFailedLoads.erase(key);
+    mBatchTotal++;
+    AFrameScheduler::Invalidate(INVALIDATE_ASYNC_LOAD);
+
+    // The job holds its own reference to the queue in case the context goes away before it finishes.
+    std::shared_ptr<ANavLoadQueue> queue = mLoadQueue;
+    bool bUseCache = OPTIONS.bNavmeshCache;
+    float heightGridCellSize = OPTIONS.mHeightGridCellSize;
+
+    UJobSystem::Submit([queue, filePath, bUseCache, heightGridCellSize]() {
+        ZoneScopedN("ANavContext::LoadNavmesh job");
+
+        std::string pathStr = filePath.generic_string();
+        ZoneText(pathStr.c_str(), pathStr.size());
+
+        std::unique_ptr<ANavmeshGeometry> geometry = std::make_unique<ANavmeshGeometry>();
+        geometry->mPath = filePath;
+
+        {
+            std::lock_guard<std::mutex> lock(queue->mMutex);
+            if (queue->mCancelled.count(pathStr) != 0) {
+                geometry->bSkipped = true;
+                queue->mReady.push_back(std::move(geometry));
+                queue->mParsed++;
+
+                AFrameScheduler::Invalidate(INVALIDATE_ASYNC_LOAD);
+                return;
+            }
+        }
+
+        try {
+            // Both caches are keyed by the file's contents, so they survive it being moved or touched.
+            uint64_t contentHash = 0;
+            if ((bUseCache || heightGridCellSize > 0.0f) && !UFileUtil::HashFileContents(filePath, contentHash)) {
+                throw std::runtime_error("couldn't read file");
+            }
+
+            std::filesystem::path gridPath;
+            uint64_t gridHash = 0;
+            if (heightGridCellSize > 0.0f) {
+                gridHash = UFileUtil::Hash(&heightGridCellSize, sizeof(heightGridCellSize), contentHash);
+                gridPath = GetHeightGridPath(gridHash);
+
+                geometry->mHeightGrid = std::make_shared<UNav::UHeightGrid>();
+                if (!geometry->mHeightGrid->Load(gridPath, gridHash)) {
+                    geometry->mHeightGrid = nullptr;
+                }
+            }
+
+            // A missing height grid needs the full-precision triangles, which only the parse gives us.
+            std::filesystem::path blobPath;
+            bool bCached = false;
+            if (bUseCache) {
+                blobPath = ANavCache::GetBlobPath(contentHash);
+                bCached = (heightGridCellSize <= 0.0f || geometry->mHeightGrid != nullptr) &&
+                    ANavCache::Read(blobPath, contentHash, *geometry, *queue->mStaging);
+            }
+
+            if (!bCached) {
+                std::shared_ptr<CNavmeshData> navmesh;
+                {
+                    ZoneScopedN("Parse YNV");
+                    navmesh = librdr3::ImportYnv(pathStr);
+                }
+
+                if (navmesh == nullptr) {
+                    throw std::runtime_error("not a valid navmesh");
+                }
+
+                ZoneScopedN("Build navmesh geometry");
+
+                float* vertexData = nullptr;
+                uint32_t* indexData = nullptr;
+                navmesh->GetVertices(vertexData, indexData, geometry->mVertexCount, geometry->mIndexCount);
+
+                std::unique_ptr<float[]> vertices(vertexData);
+                std::unique_ptr<uint32_t[]> indices(indexData);
+
+                geometry->mBoundsMin = glm::vec3(std::numeric_limits<float>::max());
+                geometry->mBoundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+                for (uint32_t i = 0; i < geometry->mVertexCount; i++) {
+                    glm::vec3 pos(vertexData[i * 6 + 0], vertexData[i * 6 + 1], vertexData[i * 6 + 2]);
+
+                    geometry->mBoundsMin = glm::min(geometry->mBoundsMin, pos);
+                    geometry->mBoundsMax = glm::max(geometry->mBoundsMax, pos);
+                }
+
+                {
+                    ZoneScopedN("Build navmesh BVH");
+
+                    geometry->mBVH = std::make_shared<UNav::UNavBVH>();
+                    geometry->mBVH->Build(vertexData, 6, geometry->mVertexCount, indexData, geometry->mIndexCount);
+                }
+
+                if (heightGridCellSize > 0.0f && geometry->mHeightGrid == nullptr) {
+                    geometry->mHeightGrid = BuildHeightGrid(gridPath, gridHash, vertexData, geometry->mVertexCount, indexData, geometry->mIndexCount,
+                        geometry->mBoundsMin, geometry->mBoundsMax, heightGridCellSize);
+                }
+
+                uint32_t packedSize = ANavmeshArena::GetPackedSize(geometry->mVertexCount, geometry->mIndexCount);
+
+                if (bUseCache) {
+                    // Staging memory is write-only, so pack on the heap where the cache can read it back.
+                    geometry->mPacked = std::make_unique<uint8_t[]>(packedSize);
+                    ANavmeshArena::PackGeometry(vertexData, geometry->mVertexCount, indexData, geometry->mIndexCount,
+                        geometry->mBoundsMin, geometry->mBoundsMax, geometry->mPacked.get());
+
+                    ANavCache::Write(blobPath, contentHash, *geometry, geometry->mPacked.get());
+
+                    geometry->mStaging = queue->mStaging->Allocate(packedSize);
+                    if (geometry->mStaging.IsValid()) {
+                        std::memcpy(geometry->mStaging.mData, geometry->mPacked.get(), packedSize);
+                        geometry->mPacked.reset();
+                    }
+                }
+                else {
+                    // Pack straight into GPU-visible memory and let librdr3's arrays go right away, instead of
+                    // holding them until the main thread gets around to uploading.
+                    uint8_t* packed = nullptr;
+                    geometry->mStaging = queue->mStaging->Allocate(packedSize);
+                    if (geometry->mStaging.IsValid()) {
+                        packed = geometry->mStaging.mData;
+                    }
+                    else {
+                        geometry->mPacked = std::make_unique<uint8_t[]>(packedSize);
+                        packed = geometry->mPacked.get();
+                    }
+
+                    ANavmeshArena::PackGeometry(vertexData, geometry->mVertexCount, indexData, geometry->mIndexCount,
+                        geometry->mBoundsMin, geometry->mBoundsMax, packed);
+                }
+            }
+        }
+        catch (const std::exception& e) {
+            std::cout << "Failed to load navmesh " << pathStr << ": " << e.what() << std::endl;
+
+            geometry = std::make_unique<ANavmeshGeometry>();
+            geometry->mPath = filePath;
+            geometry->bFailed = true;
+
+            std::lock_guard<std::mutex> lock(queue->mMutex);
+            queue->mReady.push_back(std::move(geometry));
+            queue->mFailed++;
+
+            AFrameScheduler::Invalidate(INVALIDATE_ASYNC_LOAD);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queue->mMutex);
+            queue->mReady.push_back(std::move(geometry));
+            queue->mParsed++;
+        }
+
+        AFrameScheduler::Invalidate(INVALIDATE_ASYNC_LOAD);
+    });
+}
 
-    delete[] vertexData;
-    delete[] indexData;
+void ANavContext::ProcessUploads(float budgetMs) {
+    mLoadQueue->mStaging->ReclaimCompleted();
 
-    glCreateVertexArrays(1, &mNavVAO);
-    glVertexArrayVertexBuffer(mNavVAO, 0, mNavVBO, 0, (sizeof(glm::vec3) + sizeof(glm::vec3)));
-    glVertexArrayElementBuffer(mNavVAO, mNavIBO);
+    if (mBatchTotal == 0) {
+        return;
+    }
 
-    glEnableVertexArrayAttrib(mNavVAO,  VERTEX_ATTRIB_INDEX);
-    glVertexArrayAttribBinding(mNavVAO, VERTEX_ATTRIB_INDEX, 0);
-    glVertexArrayAttribFormat(mNavVAO,  VERTEX_ATTRIB_INDEX, glm::vec3::length(), GL_FLOAT, GL_FALSE, 0);
+    ZoneScoped;
 
-    glEnableVertexArrayAttrib(mNavVAO, NORMAL_ATTRIB_INDEX);
-    glVertexArrayAttribBinding(mNavVAO, NORMAL_ATTRIB_INDEX, 0);
-    glVertexArrayAttribFormat(mNavVAO, NORMAL_ATTRIB_INDEX, glm::vec3::length(), GL_FLOAT, GL_FALSE, sizeof(glm::vec3));
+    Clock::time_point start = AUtil::GetTime();
+    bool bUploadedAny = false;
+
+    // Always upload at least one navmesh per frame so a tiny budget can't stall loading entirely.
+    while (!bUploadedAny || AUtil::GetDeltaTime(start, AUtil::GetTime()) * 1000.0f < budgetMs) {
+        std::unique_ptr<ANavmeshGeometry> geometry;
+        {
+            std::lock_guard<std::mutex> lock(mLoadQueue->mMutex);
+            if (mLoadQueue->mReady.empty()) {
+                break;
+            }
+
+            geometry = std::move(mLoadQueue->mReady.front());
+            mLoadQueue->mReady.pop_front();
+        }
+
+        UploadGeometry(*geometry);
+        mBatchUploaded++;
+        bUploadedAny = true;
+    }
+
+    if (bUploadedAny) {
+        AFrameScheduler::Invalidate(INVALIDATE_DATA);
+    }
+
+    if (mBatchUploaded == mBatchTotal) {
+        mBatchTotal = 0;
+        mBatchUploaded = 0;
+        mLoadQueue->mParsed = 0;
+        mLoadQueue->mFailed = 0;
+    }
+    else {
+        // More work is either queued or on its way; keep frames coming so the progress bar stays current.
+        AFrameScheduler::Invalidate(INVALIDATE_ASYNC_LOAD);
+    }
 }
 
-void ANavmeshRenderData::DeleteNavResources() {
-    uint32_t buffers[]{ mNavVBO, mNavIBO };
+void ANavContext::UploadGeometry(ANavmeshGeometry& geometry) {
+    std::string key = geometry.mPath.generic_string();
+    mPendingLoads.erase(key);
+
+    bool bCancelled;
+    {
+        std::lock_guard<std::mutex> lock(mLoadQueue->mMutex);
+        bCancelled = mLoadQueue->mCancelled.erase(key) != 0;
+    }
+
+    if (geometry.bSkipped) {
+        // Requested again after the job had already skipped it, so it has to be loaded from scratch.
+        if (!bCancelled) {
+            LoadNavmesh(geometry.mPath);
+        }
 
-    glDeleteBuffers(2, buffers);
-    glDeleteVertexArrays(1, &mNavVAO);
+        return;
+    }
+
+    if (bCancelled) {
+        mLoadQueue->mStaging->Retire(geometry.mStaging);
+        return;
+    }
+
+    if (geometry.bFailed) {
+        mFailedLoads.insert(key);
+        return;
+    }
+
+    std::shared_ptr<ANavmesh> navmesh = std::make_shared<ANavmesh>();
+    navmesh->mBVH = geometry.mBVH;
+    navmesh->mHeightGrid = geometry.mHeightGrid;
+
+    ANavmeshTile* tile = &navmesh->mTile;
+    tile->mBoundsMin = geometry.mBoundsMin;
+    tile->mBoundsMax = geometry.mBoundsMax;
+
+    if (geometry.mVertexCount == 0 || geometry.mIndexCount == 0) {
+        // Nothing to draw, but it still counts as loaded so the streamer doesn't keep asking for it.
+        mLoadQueue->mStaging->Retire(geometry.mStaging);
+    }
+    else if (!mArena.AllocateTile(*tile, geometry.mVertexCount, geometry.mIndexCount)) {
+        std::cout << "Out of navmesh arena space for " << key << std::endl;
 
-    mNavVBO = 0;
-    mNavIBO = 0;
-    mNavVAO = 0;
+        mLoadQueue->mStaging->Retire(geometry.mStaging);
+        mFailedLoads.insert(key);
+        return;
+    }
+    else if (geometry.mStaging.IsValid()) {
+        mArena.CopyTile(*tile, mLoadQueue->mStaging->GetBuffer(), geometry.mStaging.mOffset);
+        mLoadQueue->mStaging->Retire(geometry.mStaging);
+    }
+    else {
+        mArena.UploadTile(*tile, geometry.mPacked.get());
+    }
+
+    mHeightGrids.Add(navmesh->mHeightGrid);
+    mLoadedNavmeshes[key] = navmesh;
 }
 
-void ANavmeshRenderData::Render() {
-    glBindVertexArray(mNavVAO);
+void ANavContext::UnloadNavmesh(std::filesystem::path filePath) {
+    std::string key = filePath.generic_string();
 
-    ULitSimpleUniformBuffer::SetAmbientColor(glm::vec4(0.15f, 0.15f, 0.15f, 1.0f));
-    ULitSimpleUniformBuffer::SubmitUBO();
+    if (mPendingLoads.count(key) != 0) {
+        std::lock_guard<std::mutex> lock(mLoadQueue->mMutex);
+        mLoadQueue->mCancelled.insert(key);
 
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
+        return;
+    }
 
-    glEnable(GL_BLEND);
-    glBlendEquation(GL_FUNC_ADD);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    auto it = mLoadedNavmeshes.find(key);
+    if (it == mLoadedNavmeshes.end()) {
+        return;
+    }
 
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
+    mArena.FreeTile(it->second->mTile);
+    mHeightGrids.Remove(it->second->mHeightGrid);
+    mLoadedNavmeshes.erase(it);
 
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    //glPolygonOffset(-5.0f, 1.0f);
+    if (mHoverNavmesh == key) {
+        bHasHoverHit = false;
+    }
 
-    glDrawElements(GL_TRIANGLES, mNavIndexCount, GL_UNSIGNED_INT, 0);
+    AFrameScheduler::Invalidate(INVALIDATE_DATA);
+}
 
-    //ULitSimpleUniformBuffer::SetAmbientColor(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
-    //ULitSimpleUniformBuffer::SubmitUBO();
+void ANavContext::CancelPendingLoads() {
+    std::lock_guard<std::mutex> lock(mLoadQueue->mMutex);
+    mLoadQueue->mCancelled.insert(mPendingLoads.begin(), mPendingLoads.end());
+}
 
-    //glDisable(GL_BLEND);
+bool ANavContext::IsNavmeshLoaded(const std::filesystem::path& filePath) const {
+    return mLoadedNavmeshes.count(filePath.generic_string()) != 0;
+}
 
-    //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    //glPolygonOffset(-10.0f, 1.0f);
+bool ANavContext::IsNavmeshPending(const std::filesystem::path& filePath) const {
+    std::string key = filePath.generic_string();
+    if (mPendingLoads.count(key) == 0) {
+        return false;
+    }
 
-    //glDrawElements(GL_TRIANGLES, mNavIndexCount, GL_UNSIGNED_INT, 0);
+    std::lock_guard<std::mutex> lock(mLoadQueue->mMutex);
+    return mLoadQueue->mCancelled.count(key) == 0;
+}
 
-    glBindVertexArray(0);
+bool ANavContext::HasNavmeshFailed(const std::filesystem::path& filePath) const {
+    return mFailedLoads.count(filePath.generic_string()) != 0;
 }
 
-ANavContext::ANavContext() : mLitSimpleProgram(0) {
+size_t ANavContext::GetNavmeshCPUMemoryUsage(const std::filesystem::path& filePath) const {
+    auto it = mLoadedNavmeshes.find(filePath.generic_string());
+    if (it == mLoadedNavmeshes.end()) {
+        return 0;
+    }
+
+    const ANavmesh& navmesh = *it->second;
 
+    size_t size = navmesh.mBVH != nullptr ? navmesh.mBVH->GetMemoryUsage() : 0;
+    if (navmesh.mHeightGrid != nullptr) {
+        size += navmesh.mHeightGrid->GetMemoryUsage();
+    }
+
+    return size;
 }
 
-ANavContext::~ANavContext() {
-    glDeleteProgram(mLitSimpleProgram);
-    mLitSimpleProgram = 0;
+bool ANavContext::Raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDistance, UNav::URayHit& hit, std::string* navmeshPath) const {
+    ZoneScoped;
+
+    glm::vec3 invDir = 1.0f / dir;
+    bool bHit = false;
+
+    for (const auto& [path, navmesh] : mLoadedNavmeshes) {
+        const ANavmeshTile& tile = navmesh->mTile;
+
+        // Cheap rejection against the tile bounds before walking its BVH.
+        glm::vec3 t1 = (tile.mBoundsMin - origin) * invDir;
+        glm::vec3 t2 = (tile.mBoundsMax - origin) * invDir;
+        glm::vec3 tMin = glm::min(t1, t2);
+        glm::vec3 tMax = glm::max(t1, t2);
+
+        float tNear = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+        float tFar = std::min(std::min(tMax.x, tMax.y), tMax.z);
+
+        if (tNear > tFar || tNear >= maxDistance) {
+            continue;
+        }
+
+        if (navmesh->mBVH->Raycast(origin, dir, maxDistance, hit)) {
+            maxDistance = hit.mDistance;
+            bHit = true;
+
+            if (navmeshPath != nullptr) {
+                *navmeshPath = path;
+            }
+        }
+    }
+
+    return bHit;
 }
 
-void ANavContext::LoadNavmesh(std::filesystem::path filePath) {
-    std::shared_ptr<ANavmeshRenderData> newData = std::make_shared<ANavmeshRenderData>();
-    newData->CreateNavResources(librdr3::ImportYnv(filePath.generic_string()));
+bool ANavContext::FindClosestPoint(const glm::vec3& point, float maxDistance, UNav::UClosestHit& hit, std::string* navmeshPath) const {
+    ZoneScoped;
+
+    bool bFound = false;
+
+    for (const auto& [path, navmesh] : mLoadedNavmeshes) {
+        const ANavmeshTile& tile = navmesh->mTile;
+
+        glm::vec3 d = glm::max(glm::max(tile.mBoundsMin - point, glm::vec3(0.0f)), point - tile.mBoundsMax);
+        if (glm::length(d) > maxDistance) {
+            continue;
+        }
+
+        if (navmesh->mBVH->FindClosestPoint(point, maxDistance, hit)) {
+            maxDistance = hit.mDistance;
+            bFound = true;
+
+            if (navmeshPath != nullptr) {
+                *navmeshPath = path;
+            }
+        }
+    }
 
-    mLoadedNavmeshes.push_back(newData);
+    return bFound;
+}
+
+uint32_t ANavContext::SnapToGround(std::vector<glm::vec3>& points, float searchHeight, float searchDepth, std::vector<uint8_t>* snapped) const {
+    ZoneScoped;
+
+    if (snapped != nullptr) {
+        snapped->assign(points.size(), 0);
+    }
+
+    if (mLoadedNavmeshes.empty() || points.empty()) {
+        return 0;
+    }
+
+    UTileColumnGrid grid;
+    grid.Build(mLoadedNavmeshes);
+
+    std::atomic<uint32_t> snappedCount = 0;
+
+    UJobSystem::ParallelFor(uint32_t(points.size()), 1024, [&](uint32_t begin, uint32_t end) {
+        ZoneScopedN("Snap to ground chunk");
+
+        uint32_t chunkSnapped = 0;
+
+        for (uint32_t i = begin; i < end; i++) {
+            glm::vec3 top = points[i] + glm::vec3(0.0f, searchHeight, 0.0f);
+
+            glm::vec3 ground;
+            if (!grid.CastDown(top, points[i].y - searchDepth, ground)) {
+                continue;
+            }
+
+            points[i] = ground;
+            chunkSnapped++;
+
+            if (snapped != nullptr) {
+                (*snapped)[i] = 1;
+            }
+        }
+
+        snappedCount += chunkSnapped;
+    });
+
+    return snappedCount;
+}
+
+bool ANavContext::SetPreviewMesh(const float* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount) {
+    ZoneScoped;
+
+    ClearPreviewMesh();
+
+    if (vertexCount == 0 || indexCount == 0) {
+        return false;
+    }
+
+    std::unique_ptr<ANavmeshTile> tile = std::make_unique<ANavmeshTile>();
+    tile->bPreview = true;
+    tile->mBoundsMin = glm::vec3(std::numeric_limits<float>::max());
+    tile->mBoundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        glm::vec3 pos(vertices[i * 6 + 0], vertices[i * 6 + 1], vertices[i * 6 + 2]);
+
+        tile->mBoundsMin = glm::min(tile->mBoundsMin, pos);
+        tile->mBoundsMax = glm::max(tile->mBoundsMax, pos);
+    }
+
+    if (!mArena.AllocateTile(*tile, vertexCount, indexCount)) {
+        std::cout << "Out of navmesh arena space for the preview mesh" << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> packed(ANavmeshArena::GetPackedSize(vertexCount, indexCount));
+    ANavmeshArena::PackGeometry(vertices, vertexCount, indices, indexCount, tile->mBoundsMin, tile->mBoundsMax, packed.data());
+    mArena.UploadTile(*tile, packed.data());
+
+    mPreviewTile = std::move(tile);
+    AFrameScheduler::Invalidate(INVALIDATE_DATA);
+
+    return true;
+}
+
+void ANavContext::ClearPreviewMesh() {
+    if (mPreviewTile == nullptr) {
+        return;
+    }
+
+    mArena.FreeTile(*mPreviewTile);
+    mPreviewTile.reset();
+
+    AFrameScheduler::Invalidate(INVALIDATE_DATA);
+}
+
+void ANavContext::OnMouseHover(ASceneCamera& camera, glm::vec2 viewportSize, int32_t pX, int32_t pY) {
+    ZoneScoped;
+
+    bHasHoverHit = false;
+
+    if (mLoadedNavmeshes.empty() || viewportSize.x <= 0.0f || viewportSize.y <= 0.0f) {
+        return;
+    }
+
+    glm::vec2 ndc = (glm::vec2(pX, pY) + 0.5f) / viewportSize * 2.0f - 1.0f;
+    glm::mat4 invViewProj = glm::inverse(camera.GetProjectionMatrix() * camera.GetViewMatrix());
+
+    glm::vec4 nearPoint = invViewProj * glm::vec4(ndc, -1.0f, 1.0f);
+    glm::vec4 farPoint = invViewProj * glm::vec4(ndc, 1.0f, 1.0f);
+
+    glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+    glm::vec3 ray = glm::vec3(farPoint) / farPoint.w - origin;
+
+    float length = glm::length(ray);
+    if (length <= 0.0f) {
+        return;
+    }
+
+    bHasHoverHit = Raycast(origin, ray / length, length, mHoverHit, &mHoverNavmesh);
+}
+
+void ANavContext::RenderHoverInfo() {
+    if (!bHasHoverHit) {
+        return;
+    }
+
+    // Angle from horizontal; the navmesh is Y up.
+    float slope = glm::degrees(std::acos(glm::clamp(std::abs(mHoverHit.mNormal.y), 0.0f, 1.0f)));
+
+    ImGui::BeginTooltip();
+    ImGui::TextUnformatted(std::filesystem::path(mHoverNavmesh).filename().u8string().c_str());
+    ImGui::Text("Triangle %u", mHoverHit.mTriangle);
+    ImGui::Text("Position: %.2f, %.2f, %.2f", mHoverHit.mPosition.x, mHoverHit.mPosition.y, mHoverHit.mPosition.z);
+    ImGui::Text("Slope: %.1f deg", slope);
+    ImGui::Text("Distance: %.1f", mHoverHit.mDistance);
+
+    float gridHeight;
+    if (GetGroundHeight(mHoverHit.mPosition.x, mHoverHit.mPosition.z, gridHeight)) {
+        ImGui::Text("Grid height: %.2f", gridHeight);
+    }
+    ImGui::EndTooltip();
+}
+
+void ANavContext::FinishPendingLoads() {
+    while (IsLoading()) {
+        ProcessUploads(std::numeric_limits<float>::max());
+
+        if (IsLoading()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+void ANavContext::RenderLoadProgress() {
+    if (mBatchTotal == 0) {
+        return;
+    }
+
+    uint32_t parsed = mLoadQueue->mParsed;
+    uint32_t failed = mLoadQueue->mFailed;
+
+    // Parsing is the slow part, so weight it over the upload.
+    float progress = (float(parsed + failed) * 0.75f + float(mBatchUploaded) * 0.25f) / float(mBatchTotal);
+
+    const ImGuiViewport* mainViewport = ImGui::GetMainViewport();
+    ImGui::SetNextWindowPos(ImVec2(mainViewport->WorkPos.x + mainViewport->WorkSize.x - 10.0f, mainViewport->WorkPos.y + mainViewport->WorkSize.y - 10.0f), ImGuiCond_Always, ImVec2(1.0f, 1.0f));
+    ImGui::SetNextWindowBgAlpha(0.75f);
+
+    ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoDocking | ImGuiWindowFlags_AlwaysAutoResize |
+        ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav;
+
+    if (ImGui::Begin("##navLoadProgress", nullptr, flags)) {
+        ImGui::Text("Loading navmeshes: %u/%u parsed, %u/%u uploaded", parsed + failed, mBatchTotal, mBatchUploaded, mBatchTotal);
+        if (failed != 0) {
+            ImGui::SameLine();
+            ImGui::TextDisabled("(%u failed)", failed);
+        }
+
+        ImGui::ProgressBar(progress, ImVec2(300.0f, 0.0f));
+
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel")) {
+            CancelPendingLoads();
+        }
+    }
+
+    ImGui::End();
 }
 
 void ANavContext::Render(ASceneCamera& camera) {
-    if (mLoadedNavmeshes.size() == 0) {
+    ZoneScoped;
+
+    if (mLoadedNavmeshes.size() == 0 && mPreviewTile == nullptr) {
         return;
     }
 
+    GPUZone("Navmesh");
+
+    // Culling just flips instance counts in the indirect buffer; the draw call itself doesn't change.
+    std::array<glm::vec4, 6> frustum = GetFrustumPlanes(camera.GetProjectionMatrix() * camera.GetViewMatrix());
+    for (auto& [path, navmesh] : mLoadedNavmeshes) {
+        ANavmeshTile& tile = navmesh->mTile;
+        mArena.SetTileVisible(tile, IsBoxInFrustum(frustum, tile.mBoundsMin, tile.mBoundsMax));
+    }
+
+    if (mPreviewTile != nullptr) {
+        mArena.SetTileVisible(*mPreviewTile, IsBoxInFrustum(frustum, mPreviewTile->mBoundsMin, mPreviewTile->mBoundsMax));
+    }
+
     UCommonUniformBuffer::SetProjAndViewMatrices(camera.GetProjectionMatrix(), camera.GetViewMatrix());
     UCommonUniformBuffer::SetModelMatrix(glm::identity<glm::mat4>());
     UCommonUniformBuffer::SubmitUBO();
 
     ULitSimpleUniformBuffer::SetLight(glm::vec4(0.0f, 10000.0f, 0.0f, 1.0f), glm::vec4(0.75f, 0.75f, 0.75f, 1.0f), 1.0f, 0.0f);
     ULitSimpleUniformBuffer::SetViewPos(glm::vec4(camera.GetPosition(), 1.0f));
+    ULitSimpleUniformBuffer::SetAmbientColor(glm::vec4(0.15f, 0.15f, 0.15f, 1.0f));
+    ULitSimpleUniformBuffer::SubmitUBO();
 
     glUseProgram(mLitSimpleProgram);
 
-    for (std::shared_ptr<ANavmeshRenderData> r : mLoadedNavmeshes) {
-        r->Render();
-    }
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LEQUAL);
+
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    mArena.Draw();
 
     glUseProgram(0);
 }
 
 void ANavContext::OnGLInitialized() {
+    mArena.Create(NAV_ARENA_INITIAL_VERTICES, NAV_ARENA_INITIAL_INDICES);
+
+    // Without it every load just takes the regular glNamedBufferStorage path.
+    if (!mLoadQueue->mStaging->Create(NAV_STAGING_SIZE)) {
+        std::cout << "Failed to create the navmesh staging buffer" << std::endl;
+    }
+
     // Compile vertex shader
     std::string vertTxt = UFileUtil::LoadShaderText("lit_simple.vert");
     const char* vertTxtChars = vertTxt.data();
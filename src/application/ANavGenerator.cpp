@@ -0,0 +1,317 @@
+#include "application/ANavGenerator.hpp"
+#include "application/ADrawableContext.hpp"
+#include "application/AFrameScheduler.hpp"
+#include "application/ANavContext.hpp"
+
+#include "util/fileutil.hpp"
+#include "util/jobsystem.hpp"
+
+#include <imgui.h>
+#include <ImGuiFileDialog.h>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+    // Interleaves position and an area-weighted vertex normal, the layout the navmesh arena packs from.
+    std::vector<float> BuildPreviewVertices(const UNav::UNavGenResult& result) {
+        uint32_t vertexCount = uint32_t(result.mVertices.size() / 3);
+
+        std::vector<glm::vec3> normals(vertexCount, glm::vec3(0.0f));
+        for (size_t i = 0; i + 2 < result.mIndices.size(); i += 3) {
+            uint32_t a = result.mIndices[i + 0], b = result.mIndices[i + 1], c = result.mIndices[i + 2];
+
+            glm::vec3 p0(result.mVertices[a * 3 + 0], result.mVertices[a * 3 + 1], result.mVertices[a * 3 + 2]);
+            glm::vec3 p1(result.mVertices[b * 3 + 0], result.mVertices[b * 3 + 1], result.mVertices[b * 3 + 2]);
+            glm::vec3 p2(result.mVertices[c * 3 + 0], result.mVertices[c * 3 + 1], result.mVertices[c * 3 + 2]);
+
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            normals[a] += n;
+            normals[b] += n;
+            normals[c] += n;
+        }
+
+        std::vector<float> vertices(size_t(vertexCount) * 6);
+        for (uint32_t i = 0; i < vertexCount; i++) {
+            float length = glm::length(normals[i]);
+            glm::vec3 n = length > 0.0f ? normals[i] / length : glm::vec3(0.0f, 1.0f, 0.0f);
+
+            vertices[i * 6 + 0] = result.mVertices[i * 3 + 0];
+            vertices[i * 6 + 1] = result.mVertices[i * 3 + 1];
+            vertices[i * 6 + 2] = result.mVertices[i * 3 + 2];
+            vertices[i * 6 + 3] = n.x;
+            vertices[i * 6 + 4] = n.y;
+            vertices[i * 6 + 5] = n.z;
+        }
+
+        return vertices;
+    }
+}
+
+ANavGenerator::ANavGenerator() {
+    mTileCache = std::make_shared<UNav::UNavTileCache>(UFileUtil::GetCacheDirectory("navgen"));
+}
+
+ANavGenerator::~ANavGenerator() {
+    Cancel();
+}
+
+bool ANavGenerator::Start(const ADrawableContext& drawableContext) {
+    ZoneScoped;
+
+    Cancel();
+
+    if (mCancelledJob != nullptr && mCancelledJob->bFinished) {
+        mCancelledJob.reset();
+    }
+
+    std::shared_ptr<ANavGenJob> job = std::make_shared<ANavGenJob>();
+    job->mSettings = mSettings;
+    job->mTileCache = mTileCache;
+
+    UNav::UNavGenInput& input = job->mInput;
+
+    if (drawableContext.CollectTriangles(input.mVertices, input.mIndices) == 0) {
+        mStatus = drawableContext.GetDrawableCount() == 0 ? "Load a drawable to build from." :
+            "Reading geometry out of drawables isn't supported by this build's librdr3 yet, so there's nothing to build from.";
+        return false;
+    }
+
+    mJob = job;
+    mStatus.clear();
+
+    if (mCancelledJob == nullptr) {
+        Submit(job);
+    }
+
+    AFrameScheduler::Invalidate(INVALIDATE_ASYNC_LOAD);
+    return true;
+}
+
+void ANavGenerator::Submit(const std::shared_ptr<ANavGenJob>& job) {
+    job->bSubmitted = true;
+
+    UJobSystem::Submit([job]() {
+        ZoneScopedN("ANavGenerator job");
+
+        UNav::GenerateNavmesh(job->mInput, job->mSettings, job->mProgress, job->mResult, job->mTileCache.get());
+
+        // The input can be sizeable and nothing needs it past this point.
+        job->mInput = UNav::UNavGenInput();
+        job->bFinished = true;
+
+        AFrameScheduler::Invalidate(INVALIDATE_ASYNC_LOAD);
+    });
+}
+
+void ANavGenerator::Cancel() {
+    if (mJob == nullptr) {
+        return;
+    }
+
+    // The worker holds its own reference and finishes in the background; its result is just dropped.
+    mJob->mProgress.bCancelled = true;
+    if (mJob->bSubmitted) {
+        mCancelledJob = std::move(mJob);
+    }
+
+    mJob.reset();
+}
+
+void ANavGenerator::Update(ANavContext& navContext) {
+    if (mCancelledJob != nullptr && mCancelledJob->bFinished) {
+        mCancelledJob.reset();
+    }
+
+    if (mJob == nullptr) {
+        return;
+    }
+
+    if (!mJob->bSubmitted && mCancelledJob == nullptr) {
+        Submit(mJob);
+    }
+
+    if (!mJob->bFinished) {
+        // Keep frames coming so the progress bar stays current.
+        AFrameScheduler::Invalidate(INVALIDATE_ASYNC_LOAD);
+        return;
+    }
+
+    ZoneScoped;
+
+    std::shared_ptr<ANavGenJob> job = std::move(mJob);
+    const UNav::UNavGenResult& result = job->mResult;
+
+    if (!result.bSucceeded) {
+        mStatus = "Failed: " + result.mError;
+        return;
+    }
+
+    std::vector<float> vertices = BuildPreviewVertices(result);
+    if (!navContext.SetPreviewMesh(vertices.data(), uint32_t(result.mVertices.size() / 3), result.mIndices.data(), uint32_t(result.mIndices.size()))) {
+        mStatus = "Built, but the preview couldn't be shown.";
+        return;
+    }
+
+    char status[320];
+    snprintf(status, sizeof(status), "%u polygons, %u triangles from %u tiles in %.0f ms (%u built, %u reused, %u from disk)\n"
+        "%llu Recast allocations, %llu from the heap, %.1f MB peak temporary memory per tile",
+        result.mPolyCount, uint32_t(result.mIndices.size() / 3), result.mTileCount, result.mBuildTimeMs,
+        result.mTilesBuilt, result.mTilesReused, result.mTilesFromDisk,
+        (unsigned long long)result.mAllocations, (unsigned long long)result.mHeapAllocations, double(result.mPeakArenaBytes) / (1024.0 * 1024.0));
+    mStatus = status;
+    mProfile = result.mProfile;
+}
+
+void ANavGenerator::RenderProfile() {
+    if (mProfile.IsEmpty() || !ImGui::CollapsingHeader("Stage timings")) {
+        return;
+    }
+
+    ImGui::Text("%u tiles built on %u threads; times are summed over tiles.", mProfile.mTilesBuilt, mProfile.mThreadCount);
+
+    // Top-level tile stages are a share of the tiles' total; nested ones of their parent stage.
+    const UNav::UNavStageTime* total = mProfile.FindTotal();
+    const uint32_t maxDepth = 3;
+    double parentMs[maxDepth + 1] = { total != nullptr ? total->mTotalMs : 0.0 };
+
+    if (ImGui::BeginTable("##navGenStages", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Stage");
+        ImGui::TableSetupColumn("Total (ms)");
+        ImGui::TableSetupColumn("Share");
+        ImGui::TableSetupColumn("Max tile (ms)");
+        ImGui::TableSetupColumn("Tiles");
+        ImGui::TableHeadersRow();
+
+        for (const UNav::UNavStageTime& stage : mProfile.mStages) {
+            uint32_t depth = std::min(stage.mDepth, maxDepth);
+            if (depth < maxDepth) {
+                parentMs[depth + 1] = stage.mTotalMs;
+            }
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Indent(float(depth) * ImGui::GetStyle().IndentSpacing);
+            ImGui::TextUnformatted(stage.mName);
+            ImGui::Unindent(float(depth) * ImGui::GetStyle().IndentSpacing);
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", stage.mTotalMs);
+            ImGui::TableNextColumn();
+            if (depth > 0 && parentMs[depth] > 0.0) {
+                ImGui::Text("%.1f%%", 100.0 * stage.mTotalMs / parentMs[depth]);
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", stage.mMaxMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", stage.mTileCount);
+        }
+
+        ImGui::EndTable();
+    }
+
+    if (ImGui::Button("Save report...")) {
+        std::string startingDir = UFileUtil::GetCacheDirectory("navgen").string();
+        ImGuiFileDialog::Instance()->OpenDialog("saveNavProfileDialog", "Save Build Profile", ".json", startingDir, 1, nullptr, ImGuiFileDialogFlags_Modal);
+    }
+}
+
+void ANavGenerator::RenderUI(bool* open, ANavContext& navContext, const ADrawableContext& drawableContext) {
+    if (!*open) {
+        return;
+    }
+
+    if (!ImGui::Begin("Navmesh Generation", open)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::BeginDisabled(IsRunning());
+
+    if (ImGui::CollapsingHeader("Rasterization", ImGuiTreeNodeFlags_DefaultOpen)) {
+        ImGui::DragFloat("Cell size", &mSettings.mCellSize, 0.01f, 0.05f, 4.0f, "%.2f");
+        ImGui::DragFloat("Cell height", &mSettings.mCellHeight, 0.01f, 0.05f, 4.0f, "%.2f");
+
+        int tileSize = int(mSettings.mTileSize);
+        if (ImGui::DragInt("Tile size (cells)", &tileSize, 1.0f, 16, 1024)) {
+            mSettings.mTileSize = uint32_t(tileSize);
+        }
+    }
+
+    if (ImGui::CollapsingHeader("Agent", ImGuiTreeNodeFlags_DefaultOpen)) {
+        ImGui::DragFloat("Height", &mSettings.mAgentHeight, 0.05f, 0.1f, 20.0f, "%.2f");
+        ImGui::DragFloat("Radius", &mSettings.mAgentRadius, 0.05f, 0.0f, 10.0f, "%.2f");
+        ImGui::DragFloat("Max climb", &mSettings.mAgentMaxClimb, 0.05f, 0.0f, 10.0f, "%.2f");
+        ImGui::DragFloat("Max slope", &mSettings.mAgentMaxSlope, 0.5f, 0.0f, 89.0f, "%.1f deg");
+    }
+
+    if (ImGui::CollapsingHeader("Regions and polygons")) {
+        ImGui::DragFloat("Min region size", &mSettings.mRegionMinSize, 0.5f, 0.0f, 150.0f, "%.0f");
+        ImGui::DragFloat("Merged region size", &mSettings.mRegionMergeSize, 0.5f, 0.0f, 150.0f, "%.0f");
+        ImGui::DragFloat("Max edge length", &mSettings.mEdgeMaxLength, 0.5f, 0.0f, 100.0f, "%.1f");
+        ImGui::DragFloat("Max edge error", &mSettings.mEdgeMaxError, 0.05f, 0.1f, 5.0f, "%.2f");
+
+        int vertsPerPoly = int(mSettings.mVertsPerPoly);
+        if (ImGui::DragInt("Verts per poly", &vertsPerPoly, 0.1f, 3, 6)) {
+            mSettings.mVertsPerPoly = uint32_t(vertsPerPoly);
+        }
+
+        ImGui::DragFloat("Detail sample distance", &mSettings.mDetailSampleDistance, 0.1f, 0.0f, 16.0f, "%.1f");
+        ImGui::DragFloat("Detail max error", &mSettings.mDetailSampleMaxError, 0.1f, 0.0f, 16.0f, "%.1f");
+    }
+
+    ImGui::Checkbox("Parallel steps within tiles", &mSettings.bParallelSteps);
+
+    ImGui::EndDisabled();
+
+    ImGui::Separator();
+
+    if (IsRunning()) {
+        const UNav::UNavGenProgress& progress = mJob->mProgress;
+        UNav::ENavGenStage stage = progress.mStage;
+
+        char overlay[64];
+        if (stage == UNav::ENavGenStage::BuildTiles) {
+            snprintf(overlay, sizeof(overlay), "%s %u/%u", UNav::GetStageName(stage), progress.mTilesDone.load(), progress.mTileCount.load());
+        }
+        else {
+            snprintf(overlay, sizeof(overlay), "%s", UNav::GetStageName(stage));
+        }
+
+        ImGui::ProgressBar(progress.GetFraction(), ImVec2(-1.0f, 0.0f), overlay);
+
+        if (ImGui::Button("Cancel")) {
+            Cancel();
+            mStatus = "Cancelled.";
+        }
+    }
+    else {
+        if (ImGui::Button("Generate")) {
+            Start(drawableContext);
+        }
+
+        ImGui::SameLine();
+
+        ImGui::BeginDisabled(!navContext.HasPreviewMesh());
+        if (ImGui::Button("Clear preview")) {
+            navContext.ClearPreviewMesh();
+        }
+        ImGui::EndDisabled();
+    }
+
+    if (!mStatus.empty()) {
+        ImGui::TextWrapped("%s", mStatus.c_str());
+    }
+
+    RenderProfile();
+
+    ImGui::End();
+
+    if (ImGuiFileDialog::Instance()->Display("saveNavProfileDialog", 32, { 800, 600 })) {
+        if (ImGuiFileDialog::Instance()->IsOk() && !mProfile.WriteJson(ImGuiFileDialog::Instance()->GetFilePathName())) {
+            mStatus = "Couldn't write the build profile.";
+        }
+
+        ImGuiFileDialog::Instance()->Close();
+    }
+}
@@ -0,0 +1,411 @@
+#include "application/ANavStreamer.hpp"
+#include "application/ANavContext.hpp"
+#include "application/ANavmeshArena.hpp"
+#include "application/ACamera.hpp"
+#include "application/AFrameScheduler.hpp"
+#include "application/AOptions.hpp"
+
+#include "util/jobsystem.hpp"
+
+#include <librdr3.hpp>
+#include <pugixml.hpp>
+#include <imgui.h>
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+
+constexpr const char* NAV_INDEX_FILE_NAME = "navigator_index.xml";
+
+// Tiles that were requested stay requested until the camera is this much further than the radius,
+// so a tile right on the edge doesn't flip between loading and cancelled every frame.
+constexpr float STREAM_CANCEL_HYSTERESIS = 1.25f;
+
+// How much a tile behind the camera is penalized relative to one straight ahead at the same distance.
+constexpr float STREAM_BEHIND_PENALTY = 0.5f;
+
+namespace {
+    int64_t GetWriteTime(const std::filesystem::path& path) {
+        std::error_code error;
+        auto time = std::filesystem::last_write_time(path, error);
+
+        return error ? 0 : int64_t(time.time_since_epoch().count());
+    }
+
+    float GetDistanceToBox(const glm::vec3& point, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+        glm::vec3 delta = glm::max(glm::max(boxMin - point, glm::vec3(0.0f)), point - boxMax);
+        return glm::length(delta);
+    }
+}
+
+size_t ANavStreamTile::GetEstimatedSize() const {
+    return ANavmeshArena::GetPackedSize(mVertexCount, mIndexCount);
+}
+
+ANavStreamer::ANavStreamer() : mIndexTotal(0), mFrame(0) {
+
+}
+
+ANavStreamer::~ANavStreamer() {
+    if (mIndexQueue != nullptr) {
+        mIndexQueue->bCancelled = true;
+    }
+}
+
+void ANavStreamer::OpenDirectory(ANavContext& navContext, std::filesystem::path directory) {
+    ZoneScoped;
+
+    Close(navContext);
+
+    if (!std::filesystem::is_directory(directory)) {
+        return;
+    }
+
+    mDirectory = directory;
+
+    std::vector<ANavStreamTile> cachedTiles;
+    LoadIndex(cachedTiles);
+
+    std::unordered_map<std::string, const ANavStreamTile*> cachedByName;
+    for (const ANavStreamTile& tile : cachedTiles) {
+        cachedByName[tile.mPath.filename().u8string()] = &tile;
+    }
+
+    std::vector<ANavStreamTile> toIndex;
+    for (const auto& entry : std::filesystem::directory_iterator(mDirectory)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".ynv") {
+            continue;
+        }
+
+        ANavStreamTile tile;
+        tile.mPath = entry.path();
+        tile.mFileSize = entry.file_size();
+        tile.mWriteTime = GetWriteTime(entry.path());
+
+        auto cached = cachedByName.find(tile.mPath.filename().u8string());
+        if (cached != cachedByName.end() && cached->second->mFileSize == tile.mFileSize && cached->second->mWriteTime == tile.mWriteTime) {
+            tile.mBoundsMin = cached->second->mBoundsMin;
+            tile.mBoundsMax = cached->second->mBoundsMax;
+            tile.mVertexCount = cached->second->mVertexCount;
+            tile.mIndexCount = cached->second->mIndexCount;
+
+            mTiles.push_back(tile);
+        }
+        else {
+            toIndex.push_back(tile);
+        }
+    }
+
+    if (toIndex.empty()) {
+        // Drops entries for files that were deleted since the index was written.
+        if (mTiles.size() != cachedTiles.size()) {
+            SaveIndex();
+        }
+
+        return;
+    }
+
+    mIndexQueue = std::make_shared<ANavIndexQueue>();
+    mIndexTotal = uint32_t(toIndex.size());
+
+    for (ANavStreamTile& tile : toIndex) {
+        std::shared_ptr<ANavIndexQueue> queue = mIndexQueue;
+
+        UJobSystem::Submit([queue, tile]() mutable {
+            ZoneScopedN("ANavStreamer index job");
+
+            if (queue->bCancelled) {
+                return;
+            }
+
+            std::string pathStr = tile.mPath.generic_string();
+
+            try {
+                std::shared_ptr<CNavmeshData> navmesh = librdr3::ImportYnv(pathStr);
+                if (navmesh == nullptr) {
+                    throw std::runtime_error("not a valid navmesh");
+                }
+
+                float* vertexData = nullptr;
+                uint32_t* indexData = nullptr;
+                navmesh->GetVertices(vertexData, indexData, tile.mVertexCount, tile.mIndexCount);
+
+                std::unique_ptr<float[]> vertices(vertexData);
+                std::unique_ptr<uint32_t[]> indices(indexData);
+
+                tile.mBoundsMin = glm::vec3(std::numeric_limits<float>::max());
+                tile.mBoundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+                for (uint32_t i = 0; i < tile.mVertexCount; i++) {
+                    glm::vec3 pos(vertexData[i * 6 + 0], vertexData[i * 6 + 1], vertexData[i * 6 + 2]);
+
+                    tile.mBoundsMin = glm::min(tile.mBoundsMin, pos);
+                    tile.mBoundsMax = glm::max(tile.mBoundsMax, pos);
+                }
+
+                std::lock_guard<std::mutex> lock(queue->mMutex);
+                queue->mIndexed.push_back(tile);
+            }
+            catch (const std::exception& e) {
+                std::cout << "Failed to index navmesh " << pathStr << ": " << e.what() << std::endl;
+            }
+
+            queue->mDone++;
+            AFrameScheduler::Invalidate(INVALIDATE_ASYNC_LOAD);
+        });
+    }
+}
+
+void ANavStreamer::Close(ANavContext& navContext) {
+    if (mIndexQueue != nullptr) {
+        mIndexQueue->bCancelled = true;
+        mIndexQueue.reset();
+    }
+
+    for (const ANavStreamTile& tile : mTiles) {
+        if (tile.bStreamed) {
+            navContext.UnloadNavmesh(tile.mPath);
+        }
+    }
+
+    mTiles.clear();
+    mDirectory.clear();
+    mIndexTotal = 0;
+}
+
+void ANavStreamer::LoadIndex(std::vector<ANavStreamTile>& tiles) {
+    pugi::xml_document doc;
+    if (!doc.load_file((mDirectory / NAV_INDEX_FILE_NAME).c_str())) {
+        return;
+    }
+
+    pugi::xml_node rootNode = doc.child("navigatorIndex");
+    for (pugi::xml_node tileNode : rootNode.children("tile")) {
+        ANavStreamTile tile;
+        tile.mPath = mDirectory / tileNode.attribute("file").as_string();
+        tile.mFileSize = tileNode.attribute("size").as_ullong();
+        tile.mWriteTime = tileNode.attribute("time").as_llong();
+
+        tile.mBoundsMin = glm::vec3(tileNode.attribute("minX").as_float(), tileNode.attribute("minY").as_float(), tileNode.attribute("minZ").as_float());
+        tile.mBoundsMax = glm::vec3(tileNode.attribute("maxX").as_float(), tileNode.attribute("maxY").as_float(), tileNode.attribute("maxZ").as_float());
+
+        tile.mVertexCount = tileNode.attribute("vertices").as_uint();
+        tile.mIndexCount = tileNode.attribute("indices").as_uint();
+
+        tiles.push_back(tile);
+    }
+}
+
+void ANavStreamer::SaveIndex() {
+    pugi::xml_document doc;
+
+    pugi::xml_node rootNode = doc.append_child("navigatorIndex");
+    for (const ANavStreamTile& tile : mTiles) {
+        pugi::xml_node tileNode = rootNode.append_child("tile");
+        tileNode.append_attribute("file").set_value(tile.mPath.filename().u8string().data());
+        tileNode.append_attribute("size").set_value((unsigned long long)tile.mFileSize);
+        tileNode.append_attribute("time").set_value((long long)tile.mWriteTime);
+
+        tileNode.append_attribute("minX").set_value(tile.mBoundsMin.x);
+        tileNode.append_attribute("minY").set_value(tile.mBoundsMin.y);
+        tileNode.append_attribute("minZ").set_value(tile.mBoundsMin.z);
+        tileNode.append_attribute("maxX").set_value(tile.mBoundsMax.x);
+        tileNode.append_attribute("maxY").set_value(tile.mBoundsMax.y);
+        tileNode.append_attribute("maxZ").set_value(tile.mBoundsMax.z);
+
+        tileNode.append_attribute("vertices").set_value(tile.mVertexCount);
+        tileNode.append_attribute("indices").set_value(tile.mIndexCount);
+    }
+
+    // The directory might be read-only; the index just gets rebuilt next time then.
+    if (!doc.save_file((mDirectory / NAV_INDEX_FILE_NAME).c_str(), PUGIXML_TEXT("\t"), pugi::format_indent, pugi::encoding_utf8)) {
+        std::cout << "Couldn't write navmesh index to " << mDirectory.generic_string() << std::endl;
+    }
+}
+
+void ANavStreamer::Update(ANavContext& navContext, ASceneCamera& camera) {
+    if (!IsActive()) {
+        return;
+    }
+
+    ZoneScoped;
+
+    mFrame++;
+
+    if (mIndexQueue != nullptr) {
+        {
+            std::lock_guard<std::mutex> lock(mIndexQueue->mMutex);
+            mTiles.insert(mTiles.end(), mIndexQueue->mIndexed.begin(), mIndexQueue->mIndexed.end());
+            mIndexQueue->mIndexed.clear();
+        }
+
+        if (mIndexQueue->mDone == mIndexTotal) {
+            mIndexQueue.reset();
+            SaveIndex();
+        }
+    }
+
+    glm::vec3 eye = camera.GetPosition();
+    glm::vec3 forward = camera.GetForwardVector();
+
+    float radius = OPTIONS.mStreamRadius;
+    size_t gpuBudget = size_t(OPTIONS.mStreamGPUBudgetMB) * 1024 * 1024;
+    size_t cpuBudget = size_t(OPTIONS.mStreamCPUBudgetMB) * 1024 * 1024;
+
+    std::vector<std::pair<float, ANavStreamTile*>> wanted;
+    std::vector<ANavStreamTile*> evictable;
+
+    size_t pendingBytes = 0;
+    uint32_t pendingCount = 0;
+    // BVHs and height grids of everything loaded from the directory, streamed or not.
+    size_t residentBytes = 0;
+
+    for (ANavStreamTile& tile : mTiles) {
+        float distance = GetDistanceToBox(eye, tile.mBoundsMin, tile.mBoundsMax);
+        bool bInRange = distance <= radius;
+
+        if (navContext.IsNavmeshLoaded(tile.mPath)) {
+            if (bInRange) {
+                tile.mLastUsedFrame = mFrame;
+            }
+
+            residentBytes += navContext.GetNavmeshCPUMemoryUsage(tile.mPath);
+
+            if (tile.bStreamed) {
+                evictable.push_back(&tile);
+            }
+        }
+        else if (navContext.IsNavmeshPending(tile.mPath)) {
+            if (tile.bStreamed && distance > radius * STREAM_CANCEL_HYSTERESIS) {
+                navContext.UnloadNavmesh(tile.mPath);
+                tile.bStreamed = false;
+                continue;
+            }
+
+            tile.mLastUsedFrame = mFrame;
+            pendingBytes += tile.GetEstimatedSize();
+            pendingCount++;
+        }
+        else {
+            // Unloaded or failed; whoever loads it next owns it.
+            tile.bStreamed = false;
+
+            if (bInRange && !navContext.HasNavmeshFailed(tile.mPath)) {
+                // Nearest first, with tiles in front of the camera ahead of ones at the same distance behind it.
+                float priority = distance;
+                if (distance > 0.0f) {
+                    glm::vec3 toTile = glm::normalize((tile.mBoundsMin + tile.mBoundsMax) * 0.5f - eye);
+                    priority *= 1.0f + STREAM_BEHIND_PENALTY * (1.0f - glm::dot(forward, toTile));
+                }
+
+                wanted.emplace_back(priority, &tile);
+            }
+        }
+    }
+
+    // Oldest first, so eviction can pop from the back.
+    std::sort(evictable.begin(), evictable.end(), [](const ANavStreamTile* a, const ANavStreamTile* b) { return a->mLastUsedFrame > b->mLastUsedFrame; });
+
+    // Parsed geometry sits in memory until it's uploaded, and the BVH and height grid stay for as long as the
+    // tile is loaded, so both count against the CPU budget.
+    size_t gpuUsed = navContext.GetGPUMemoryUsage() + pendingBytes;
+    size_t cpuUsed = residentBytes + pendingBytes;
+
+    // Evicts streamed tiles that went out of range until size more bytes fit in both budgets.
+    auto makeRoom = [&](size_t size) {
+        while ((gpuUsed + size > gpuBudget || cpuUsed + size > cpuBudget) && !evictable.empty() && evictable.back()->mLastUsedFrame != mFrame) {
+            ANavStreamTile* evicted = evictable.back();
+            evictable.pop_back();
+
+            gpuUsed -= std::min(gpuUsed, evicted->GetEstimatedSize());
+            cpuUsed -= std::min(cpuUsed, navContext.GetNavmeshCPUMemoryUsage(evicted->mPath));
+
+            navContext.UnloadNavmesh(evicted->mPath);
+            evicted->bStreamed = false;
+        }
+    };
+
+    // Done every frame, so lowering a budget takes effect even when nothing new needs loading.
+    makeRoom(0);
+
+    if (wanted.empty()) {
+        return;
+    }
+
+    std::sort(wanted.begin(), wanted.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    // Enough in flight to keep every worker busy without queueing up loads the camera may have moved away from.
+    uint32_t maxInFlight = std::max(UJobSystem::GetThreadCount(), 1u) * 2;
+
+    for (auto& [priority, tile] : wanted) {
+        if (pendingCount >= maxInFlight) {
+            break;
+        }
+
+        size_t size = tile->GetEstimatedSize();
+        makeRoom(size);
+
+        // Everything that's still resident is in range; the budget is just too small for the radius.
+        if (gpuUsed + size > gpuBudget) {
+            break;
+        }
+
+        // Always allow one tile into an empty CPU budget so a tile larger than the budget can't stall streaming.
+        if (cpuUsed != 0 && cpuUsed + size > cpuBudget) {
+            break;
+        }
+
+        navContext.LoadNavmesh(tile->mPath);
+        tile->bStreamed = true;
+
+        gpuUsed += size;
+        cpuUsed += size;
+        pendingCount++;
+    }
+}
+
+void ANavStreamer::RenderUI(ANavContext& navContext) {
+    if (!IsActive()) {
+        return;
+    }
+
+    ImGui::Begin("Navmesh Streaming");
+
+    ImGui::TextUnformatted(mDirectory.u8string().c_str());
+
+    if (mIndexQueue != nullptr) {
+        uint32_t done = mIndexQueue->mDone;
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), "Indexing %u/%u", done, mIndexTotal);
+
+        ImGui::ProgressBar(float(done) / float(mIndexTotal), ImVec2(-1.0f, 0.0f), overlay);
+    }
+
+    ImGui::Text("Tiles: %u loaded, %u loading, %u indexed", navContext.GetLoadedNavmeshCount(), navContext.GetPendingLoadCount(), uint32_t(mTiles.size()));
+
+    float gpuUsedMB = float(navContext.GetGPUMemoryUsage()) / (1024.0f * 1024.0f);
+    char gpuOverlay[64];
+    snprintf(gpuOverlay, sizeof(gpuOverlay), "%.1f / %u MB", gpuUsedMB, OPTIONS.mStreamGPUBudgetMB);
+    ImGui::ProgressBar(gpuUsedMB / float(std::max(OPTIONS.mStreamGPUBudgetMB, 1u)), ImVec2(-1.0f, 0.0f), gpuOverlay);
+
+    ImGui::Text("Height grids: %u, %.1f MB", navContext.GetHeightGridCount(), float(navContext.GetHeightGridMemoryUsage()) / (1024.0f * 1024.0f));
+
+    ImGui::Separator();
+
+    ImGui::DragFloat("Radius", &OPTIONS.mStreamRadius, 10.0f, 50.0f, 20000.0f, "%.0f");
+
+    int gpuBudget = int(OPTIONS.mStreamGPUBudgetMB);
+    if (ImGui::DragInt("GPU budget (MB)", &gpuBudget, 4.0f, 16, 16384)) {
+        OPTIONS.mStreamGPUBudgetMB = uint32_t(gpuBudget);
+    }
+
+    int cpuBudget = int(OPTIONS.mStreamCPUBudgetMB);
+    if (ImGui::DragInt("CPU budget (MB)", &cpuBudget, 4.0f, 16, 16384)) {
+        OPTIONS.mStreamCPUBudgetMB = uint32_t(cpuBudget);
+    }
+
+    if (ImGui::Button("Stop streaming")) {
+        Close(navContext);
+    }
+
+    ImGui::End();
+}
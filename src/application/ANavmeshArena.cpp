@@ -0,0 +1,392 @@
+#include "application/ANavmeshArena.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+constexpr uint32_t VERTEX_ATTRIB_INDEX = 0;
+constexpr uint32_t TILE_ORIGIN_ATTRIB_INDEX = 2;
+constexpr uint32_t TILE_SCALE_ATTRIB_INDEX = 3;
+
+constexpr uint32_t VERTEX_BINDING = 0;
+constexpr uint32_t TILE_DATA_BINDING = 1;
+
+constexpr uint32_t MIN_INDIRECT_CAPACITY = 64;
+constexpr uint32_t MIN_TILE_DATA_CAPACITY = 64;
+
+constexpr float QUANTIZE_MAX = 65535.0f;
+
+namespace {
+    uint16_t EncodeOctahedral(glm::vec3 n) {
+        float length = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        if (length == 0.0f) {
+            return 0x7F7F;
+        }
+
+        n /= length;
+
+        glm::vec2 e(n.x, n.y);
+        if (n.z < 0.0f) {
+            e = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * glm::vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+        }
+
+        uint32_t x = uint32_t(std::lround((e.x * 0.5f + 0.5f) * 255.0f));
+        uint32_t y = uint32_t(std::lround((e.y * 0.5f + 0.5f) * 255.0f));
+
+        return uint16_t(x | (y << 8));
+    }
+
+    // Degenerate (flat) axes still need a non-zero scale to avoid dividing by zero when packing.
+    glm::vec3 GetQuantizeScale(const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+        return glm::max(boundsMax - boundsMin, glm::vec3(1e-6f)) / QUANTIZE_MAX;
+    }
+}
+
+ANavmeshArena::ANavmeshArena() : mVertexBuffer(0), mIndexBuffer(0), mTileDataBuffer(0), mVAO(0), mDataSlotCount(0), mDataSlotCapacity(0) {
+
+}
+
+ANavmeshArena::~ANavmeshArena() {
+    Destroy();
+}
+
+void ANavmeshArena::Create(uint32_t initialVertices, uint32_t initialIndices) {
+    Destroy();
+
+    // Index space is handed out in 4-byte units so 32-bit tiles stay aligned.
+    uint32_t initialIndexUnits = initialIndices / 2;
+
+    glCreateBuffers(1, &mVertexBuffer);
+    glCreateBuffers(1, &mIndexBuffer);
+    glCreateBuffers(1, &mTileDataBuffer);
+
+    glNamedBufferStorage(mVertexBuffer, GLsizeiptr(initialVertices) * NAV_VERTEX_STRIDE, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glNamedBufferStorage(mIndexBuffer, GLsizeiptr(initialIndexUnits) * sizeof(uint32_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glNamedBufferStorage(mTileDataBuffer, GLsizeiptr(MIN_TILE_DATA_CAPACITY) * sizeof(ANavTileData), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    mVertexAllocator.Reset(initialVertices);
+    mIndexAllocator.Reset(initialIndexUnits);
+    mDataSlotCapacity = MIN_TILE_DATA_CAPACITY;
+
+    glCreateVertexArrays(1, &mVAO);
+    BindBuffers();
+
+    glEnableVertexArrayAttrib(mVAO,  VERTEX_ATTRIB_INDEX);
+    glVertexArrayAttribBinding(mVAO, VERTEX_ATTRIB_INDEX, VERTEX_BINDING);
+    glVertexArrayAttribIFormat(mVAO, VERTEX_ATTRIB_INDEX, 4, GL_UNSIGNED_SHORT, 0);
+
+    // Per tile: the draw command's base instance picks the tile's entry.
+    glVertexArrayBindingDivisor(mVAO, TILE_DATA_BINDING, 1);
+
+    glEnableVertexArrayAttrib(mVAO,  TILE_ORIGIN_ATTRIB_INDEX);
+    glVertexArrayAttribBinding(mVAO, TILE_ORIGIN_ATTRIB_INDEX, TILE_DATA_BINDING);
+    glVertexArrayAttribFormat(mVAO,  TILE_ORIGIN_ATTRIB_INDEX, glm::vec4::length(), GL_FLOAT, GL_FALSE, offsetof(ANavTileData, mOrigin));
+
+    glEnableVertexArrayAttrib(mVAO,  TILE_SCALE_ATTRIB_INDEX);
+    glVertexArrayAttribBinding(mVAO, TILE_SCALE_ATTRIB_INDEX, TILE_DATA_BINDING);
+    glVertexArrayAttribFormat(mVAO,  TILE_SCALE_ATTRIB_INDEX, glm::vec3::length(), GL_FLOAT, GL_FALSE, offsetof(ANavTileData, mScale));
+}
+
+void ANavmeshArena::Destroy() {
+    uint32_t buffers[]{ mVertexBuffer, mIndexBuffer, mTileDataBuffer, mCommandLists[0].mIndirectBuffer, mCommandLists[1].mIndirectBuffer };
+
+    glDeleteBuffers(5, buffers);
+    glDeleteVertexArrays(1, &mVAO);
+
+    mVertexBuffer = 0;
+    mIndexBuffer = 0;
+    mTileDataBuffer = 0;
+    mVAO = 0;
+
+    for (ANavCommandList& list : mCommandLists) {
+        for (ANavmeshTile* tile : list.mTiles) {
+            tile->mVertexOffset = UBlockAllocator::INVALID_OFFSET;
+            tile->mIndexOffset = UBlockAllocator::INVALID_OFFSET;
+            tile->mCommandIdx = UINT32_MAX;
+            tile->mDataSlot = UINT32_MAX;
+        }
+
+        list = ANavCommandList();
+    }
+
+    mVertexAllocator.Reset(0);
+    mIndexAllocator.Reset(0);
+
+    mFreeDataSlots.clear();
+    mDataSlotCount = 0;
+    mDataSlotCapacity = 0;
+}
+
+void ANavmeshArena::BindBuffers() {
+    glVertexArrayVertexBuffer(mVAO, VERTEX_BINDING, mVertexBuffer, 0, NAV_VERTEX_STRIDE);
+    glVertexArrayVertexBuffer(mVAO, TILE_DATA_BINDING, mTileDataBuffer, 0, sizeof(ANavTileData));
+    glVertexArrayElementBuffer(mVAO, mIndexBuffer);
+}
+
+uint32_t ANavmeshArena::GetPackedSize(uint32_t vertexCount, uint32_t indexCount) {
+    // The vertex size is a multiple of 8, so the indices come out aligned without padding.
+    return GetPackedVertexSize(vertexCount) + indexCount * GetIndexSize(vertexCount);
+}
+
+void ANavmeshArena::PackGeometry(const float* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount,
+    const glm::vec3& boundsMin, const glm::vec3& boundsMax, uint8_t* dst)
+{
+    glm::vec3 invScale = 1.0f / GetQuantizeScale(boundsMin, boundsMax);
+
+    ANavPackedVertex* packedVertices = reinterpret_cast<ANavPackedVertex*>(dst);
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        const float* src = vertices + i * 6;
+
+        glm::vec3 q = glm::clamp((glm::vec3(src[0], src[1], src[2]) - boundsMin) * invScale + 0.5f, glm::vec3(0.0f), glm::vec3(QUANTIZE_MAX));
+
+        packedVertices[i].mPosition[0] = uint16_t(q.x);
+        packedVertices[i].mPosition[1] = uint16_t(q.y);
+        packedVertices[i].mPosition[2] = uint16_t(q.z);
+        packedVertices[i].mNormal = EncodeOctahedral(glm::vec3(src[3], src[4], src[5]));
+    }
+
+    uint8_t* packedIndices = dst + GetPackedVertexSize(vertexCount);
+    if (UsesWideIndices(vertexCount)) {
+        std::memcpy(packedIndices, indices, size_t(indexCount) * sizeof(uint32_t));
+    }
+    else {
+        uint16_t* narrowIndices = reinterpret_cast<uint16_t*>(packedIndices);
+        for (uint32_t i = 0; i < indexCount; i++) {
+            narrowIndices[i] = uint16_t(indices[i]);
+        }
+    }
+}
+
+bool ANavmeshArena::GrowBuffer(uint32_t& buffer, UBlockAllocator& allocator, uint32_t elementSize, uint32_t minElements) {
+    uint64_t oldSize = allocator.GetSize();
+    uint64_t newSize = std::max(oldSize * 2, oldSize + minElements);
+
+    if (newSize * elementSize > UINT32_MAX) {
+        return false;
+    }
+
+    uint32_t newBuffer = 0;
+    glCreateBuffers(1, &newBuffer);
+    glNamedBufferStorage(newBuffer, GLsizeiptr(newSize * elementSize), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    if (oldSize != 0) {
+        glCopyNamedBufferSubData(buffer, newBuffer, 0, 0, GLsizeiptr(oldSize * elementSize));
+    }
+
+    glDeleteBuffers(1, &buffer);
+    buffer = newBuffer;
+
+    allocator.Grow(uint32_t(newSize));
+    BindBuffers();
+
+    return true;
+}
+
+uint32_t ANavmeshArena::AllocateDataSlot() {
+    if (!mFreeDataSlots.empty()) {
+        uint32_t slot = mFreeDataSlots.back();
+        mFreeDataSlots.pop_back();
+
+        return slot;
+    }
+
+    if (mDataSlotCount == mDataSlotCapacity) {
+        uint32_t newCapacity = std::max(MIN_TILE_DATA_CAPACITY, mDataSlotCapacity * 2);
+
+        uint32_t newBuffer = 0;
+        glCreateBuffers(1, &newBuffer);
+        glNamedBufferStorage(newBuffer, GLsizeiptr(newCapacity) * sizeof(ANavTileData), nullptr, GL_DYNAMIC_STORAGE_BIT);
+        glCopyNamedBufferSubData(mTileDataBuffer, newBuffer, 0, 0, GLsizeiptr(mDataSlotCount) * sizeof(ANavTileData));
+
+        glDeleteBuffers(1, &mTileDataBuffer);
+        mTileDataBuffer = newBuffer;
+        mDataSlotCapacity = newCapacity;
+
+        BindBuffers();
+    }
+
+    return mDataSlotCount++;
+}
+
+bool ANavmeshArena::AllocateTile(ANavmeshTile& tile, uint32_t vertexCount, uint32_t indexCount) {
+    // Nothing to draw. The tile keeps no command, which FreeTile and SetTileVisible already skip.
+    if (vertexCount == 0 || indexCount == 0) {
+        return true;
+    }
+
+    bool bWide = UsesWideIndices(vertexCount);
+    uint32_t indexUnits = bWide ? indexCount : (indexCount + 1) / 2;
+
+    uint32_t vertexOffset = mVertexAllocator.Allocate(vertexCount);
+    if (vertexOffset == UBlockAllocator::INVALID_OFFSET) {
+        if (!GrowBuffer(mVertexBuffer, mVertexAllocator, NAV_VERTEX_STRIDE, vertexCount)) {
+            return false;
+        }
+
+        vertexOffset = mVertexAllocator.Allocate(vertexCount);
+    }
+
+    uint32_t indexOffset = mIndexAllocator.Allocate(indexUnits);
+    if (indexOffset == UBlockAllocator::INVALID_OFFSET) {
+        if (!GrowBuffer(mIndexBuffer, mIndexAllocator, sizeof(uint32_t), indexUnits)) {
+            mVertexAllocator.Free(vertexOffset, vertexCount);
+            return false;
+        }
+
+        indexOffset = mIndexAllocator.Allocate(indexUnits);
+    }
+
+    tile.mVertexOffset = vertexOffset;
+    tile.mVertexCount = vertexCount;
+    tile.mIndexOffset = indexOffset;
+    tile.mIndexCount = indexCount;
+    tile.bWideIndices = bWide;
+    tile.mDataSlot = AllocateDataSlot();
+
+    ANavTileData data;
+    data.mOrigin = glm::vec4(tile.mBoundsMin, tile.bPreview ? 1.0f : 0.0f);
+    data.mScale = glm::vec4(GetQuantizeScale(tile.mBoundsMin, tile.mBoundsMax), 0.0f);
+    glNamedBufferSubData(mTileDataBuffer, GLintptr(tile.mDataSlot) * sizeof(ANavTileData), sizeof(ANavTileData), &data);
+
+    // firstIndex counts elements of the list's index type.
+    uint32_t firstIndex = bWide ? indexOffset : indexOffset * 2;
+
+    ANavCommandList& list = mCommandLists[bWide];
+    tile.mCommandIdx = uint32_t(list.mCommands.size());
+
+    list.mCommands.push_back({ indexCount, tile.bVisible ? 1u : 0u, firstIndex, int32_t(vertexOffset), tile.mDataSlot });
+    list.mTiles.push_back(&tile);
+    MarkCommandDirty(list, tile.mCommandIdx);
+
+    return true;
+}
+
+void ANavmeshArena::FreeTile(ANavmeshTile& tile) {
+    if (tile.mCommandIdx == UINT32_MAX) {
+        return;
+    }
+
+    mVertexAllocator.Free(tile.mVertexOffset, tile.mVertexCount);
+    mIndexAllocator.Free(tile.mIndexOffset, tile.bWideIndices ? tile.mIndexCount : (tile.mIndexCount + 1) / 2);
+    mFreeDataSlots.push_back(tile.mDataSlot);
+
+    // Move the last command into the freed slot so the draw list stays dense.
+    ANavCommandList& list = mCommandLists[tile.bWideIndices];
+
+    uint32_t idx = tile.mCommandIdx;
+    uint32_t lastIdx = uint32_t(list.mCommands.size()) - 1;
+
+    if (idx != lastIdx) {
+        list.mCommands[idx] = list.mCommands[lastIdx];
+        list.mTiles[idx] = list.mTiles[lastIdx];
+        list.mTiles[idx]->mCommandIdx = idx;
+
+        MarkCommandDirty(list, idx);
+    }
+
+    list.mCommands.pop_back();
+    list.mTiles.pop_back();
+
+    tile.mVertexOffset = UBlockAllocator::INVALID_OFFSET;
+    tile.mIndexOffset = UBlockAllocator::INVALID_OFFSET;
+    tile.mCommandIdx = UINT32_MAX;
+    tile.mDataSlot = UINT32_MAX;
+}
+
+void ANavmeshArena::UploadTile(const ANavmeshTile& tile, const uint8_t* packed) {
+    uint32_t vertexBytes = GetPackedVertexSize(tile.mVertexCount);
+    uint32_t indexBytes = tile.mIndexCount * GetIndexSize(tile.mVertexCount);
+
+    glNamedBufferSubData(mVertexBuffer, GLintptr(tile.mVertexOffset) * NAV_VERTEX_STRIDE, vertexBytes, packed);
+    glNamedBufferSubData(mIndexBuffer, GLintptr(tile.mIndexOffset) * sizeof(uint32_t), indexBytes, packed + vertexBytes);
+}
+
+void ANavmeshArena::CopyTile(const ANavmeshTile& tile, uint32_t srcBuffer, uint32_t srcOffset) {
+    uint32_t vertexBytes = GetPackedVertexSize(tile.mVertexCount);
+    uint32_t indexBytes = tile.mIndexCount * GetIndexSize(tile.mVertexCount);
+
+    glCopyNamedBufferSubData(srcBuffer, mVertexBuffer, srcOffset, GLintptr(tile.mVertexOffset) * NAV_VERTEX_STRIDE, vertexBytes);
+    glCopyNamedBufferSubData(srcBuffer, mIndexBuffer, srcOffset + vertexBytes, GLintptr(tile.mIndexOffset) * sizeof(uint32_t), indexBytes);
+}
+
+void ANavmeshArena::SetTileVisible(ANavmeshTile& tile, bool visible) {
+    if (tile.bVisible == visible) {
+        return;
+    }
+
+    tile.bVisible = visible;
+
+    if (tile.mCommandIdx != UINT32_MAX) {
+        ANavCommandList& list = mCommandLists[tile.bWideIndices];
+
+        list.mCommands[tile.mCommandIdx].mInstanceCount = visible ? 1 : 0;
+        MarkCommandDirty(list, tile.mCommandIdx);
+    }
+}
+
+void ANavmeshArena::MarkCommandDirty(ANavCommandList& list, uint32_t commandIdx) {
+    list.mDirtyBegin = std::min(list.mDirtyBegin, commandIdx);
+    list.mDirtyEnd = std::max(list.mDirtyEnd, commandIdx + 1);
+}
+
+void ANavmeshArena::FlushCommands(ANavCommandList& list) {
+    uint32_t commandCount = uint32_t(list.mCommands.size());
+
+    if (commandCount > list.mCapacity) {
+        glDeleteBuffers(1, &list.mIndirectBuffer);
+
+        list.mCapacity = std::max(MIN_INDIRECT_CAPACITY, std::max(list.mCapacity * 2, commandCount));
+
+        glCreateBuffers(1, &list.mIndirectBuffer);
+        glNamedBufferStorage(list.mIndirectBuffer, GLsizeiptr(list.mCapacity) * sizeof(ANavDrawCommand), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+        list.mDirtyBegin = 0;
+        list.mDirtyEnd = commandCount;
+    }
+
+    list.mDirtyEnd = std::min(list.mDirtyEnd, commandCount);
+
+    if (list.mDirtyBegin < list.mDirtyEnd) {
+        glNamedBufferSubData(list.mIndirectBuffer, GLintptr(list.mDirtyBegin) * sizeof(ANavDrawCommand),
+            GLsizeiptr(list.mDirtyEnd - list.mDirtyBegin) * sizeof(ANavDrawCommand), &list.mCommands[list.mDirtyBegin]);
+    }
+
+    list.mDirtyBegin = UINT32_MAX;
+    list.mDirtyEnd = 0;
+}
+
+void ANavmeshArena::Draw() {
+    if (GetTileCount() == 0) {
+        return;
+    }
+
+    glBindVertexArray(mVAO);
+
+    const GLenum indexTypes[]{ GL_UNSIGNED_SHORT, GL_UNSIGNED_INT };
+    for (uint32_t i = 0; i < 2; i++) {
+        ANavCommandList& list = mCommandLists[i];
+        if (list.mCommands.empty()) {
+            continue;
+        }
+
+        FlushCommands(list);
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, list.mIndirectBuffer);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, indexTypes[i], nullptr, GLsizei(list.mCommands.size()), 0);
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+size_t ANavmeshArena::GetGPUMemoryUsage() const {
+    return size_t(mVertexAllocator.GetSize()) * NAV_VERTEX_STRIDE + size_t(mIndexAllocator.GetSize()) * sizeof(uint32_t) +
+        size_t(mCommandLists[0].mCapacity + mCommandLists[1].mCapacity) * sizeof(ANavDrawCommand) + size_t(mDataSlotCapacity) * sizeof(ANavTileData);
+}
+
+size_t ANavmeshArena::GetUsedMemory() const {
+    return size_t(mVertexAllocator.GetUsed()) * NAV_VERTEX_STRIDE + size_t(mIndexAllocator.GetUsed()) * sizeof(uint32_t) +
+        size_t(GetTileCount()) * (sizeof(ANavDrawCommand) + sizeof(ANavTileData));
+}
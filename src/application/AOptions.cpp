@@ -6,11 +6,15 @@ constexpr const char* OPTIONS_FILE_NAME = "navigator.xml";
 
 AOptions OPTIONS;
 
-AOptions::AOptions() : mLastOpenedDir(""), mLastOpenedRailroadDir(""), mLastSavedRailroadDir("") {
+AOptions::AOptions() : mLastOpenedDir(""), mLastOpenedRailroadDir(""), mLastSavedRailroadDir(""), bRenderOnDemand(true), bSinglePassPicking(true),
+	mStreamRadius(1000.0f), mStreamGPUBudgetMB(512), mStreamCPUBudgetMB(256),
+	mSnapSearchHeight(50.0f), mSnapSearchDepth(500.0f), bNavmeshCache(true), mHeightGridCellSize(1.0f) {
 
 }
 
 void AOptions::Load() {
+	ZoneScoped;
+
 	std::filesystem::path optionsPath = std::filesystem::current_path() / OPTIONS_FILE_NAME;
 	if (!std::filesystem::exists(optionsPath)) {
 		Save();
@@ -28,9 +32,24 @@ void AOptions::Load() {
 	OPTIONS.mLastOpenedDir = rootNode.child("lastOpenedDir").text().as_string();
 	OPTIONS.mLastOpenedRailroadDir = rootNode.child("lastOpenedRailroadDir").text().as_string();
 	OPTIONS.mLastSavedRailroadDir  = rootNode.child("lastSavedRailroadDir").text().as_string();
+
+	OPTIONS.bRenderOnDemand = rootNode.child("renderOnDemand").text().as_bool(true);
+	OPTIONS.bSinglePassPicking = rootNode.child("singlePassPicking").text().as_bool(true);
+
+	OPTIONS.mStreamRadius = rootNode.child("streamRadius").text().as_float(1000.0f);
+	OPTIONS.mStreamGPUBudgetMB = rootNode.child("streamGPUBudgetMB").text().as_uint(512);
+	OPTIONS.mStreamCPUBudgetMB = rootNode.child("streamCPUBudgetMB").text().as_uint(256);
+
+	OPTIONS.mSnapSearchHeight = rootNode.child("snapSearchHeight").text().as_float(50.0f);
+	OPTIONS.mSnapSearchDepth = rootNode.child("snapSearchDepth").text().as_float(500.0f);
+
+	OPTIONS.bNavmeshCache = rootNode.child("navmeshCache").text().as_bool(true);
+	OPTIONS.mHeightGridCellSize = rootNode.child("heightGridCellSize").text().as_float(1.0f);
 }
 
 void AOptions::Save() {
+	ZoneScoped;
+
 	std::filesystem::path optionsPath = std::filesystem::current_path() / OPTIONS_FILE_NAME;
 
 	pugi::xml_document doc;
@@ -41,5 +60,18 @@ void AOptions::Save() {
 	rootNode.append_child("lastOpenedRailroadDir").text().set(OPTIONS.mLastOpenedRailroadDir.u8string().data());
 	rootNode.append_child("lastSavedRailroadDir").text().set(OPTIONS.mLastSavedRailroadDir.u8string().data());
 
+	rootNode.append_child("renderOnDemand").text().set(OPTIONS.bRenderOnDemand);
+	rootNode.append_child("singlePassPicking").text().set(OPTIONS.bSinglePassPicking);
+
+	rootNode.append_child("streamRadius").text().set(OPTIONS.mStreamRadius);
+	rootNode.append_child("streamGPUBudgetMB").text().set(OPTIONS.mStreamGPUBudgetMB);
+	rootNode.append_child("streamCPUBudgetMB").text().set(OPTIONS.mStreamCPUBudgetMB);
+
+	rootNode.append_child("snapSearchHeight").text().set(OPTIONS.mSnapSearchHeight);
+	rootNode.append_child("snapSearchDepth").text().set(OPTIONS.mSnapSearchDepth);
+
+	rootNode.append_child("navmeshCache").text().set(OPTIONS.bNavmeshCache);
+	rootNode.append_child("heightGridCellSize").text().set(OPTIONS.mHeightGridCellSize);
+
 	doc.save_file(optionsPath.c_str(), PUGIXML_TEXT("\t"), pugi::format_indent | pugi::format_indent_attributes | pugi::format_save_file_text, pugi::encoding_utf8);
 }
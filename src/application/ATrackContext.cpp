@@ -4,8 +4,11 @@
 #include "ubo/common.hpp"
 #include "util/fileutil.hpp"
 #include "util/uiutil.hpp"
+#include "util/gpuprofiler.hpp"
 #include "ui/UViewportPicker.hpp"
 #include "application/AInput.hpp"
+#include "application/AFrameScheduler.hpp"
+#include "application/ANavContext.hpp"
 #include "ui/UPathRenderer.hpp"
 
 #include "primitives/USphere.hpp"
@@ -34,7 +37,14 @@ constexpr glm::vec4 HANDLE_COLOR = { 1.0f, 0.5f, 1.0f, 1.0f };
 constexpr uint32_t HANDLE_A_MASK = 0x40000000;
 constexpr uint32_t HANDLE_B_MASK = 0x80000000;
 
-ATrackContext::ATrackContext() : mPntVBO(0), mPntIBO(0), mPntVAO(0), mSimpleProgram(0), bGLInitialized(false), mBaseColorUniform(0),
+uint32_t GetPickId(uint32_t trackIdx, uint32_t pointIdx) {
+    uint32_t trackId = ((trackIdx + 1) << 16) & 0x3FFF0000;
+    uint32_t pointId = pointIdx + 1;
+
+    return trackId | pointId;
+}
+
+ATrackContext::ATrackContext() : mPntVBO(0), mPntIBO(0), mPntVAO(0), mSimpleProgram(0), bGLInitialized(false), mBaseColorUniform(0), mObjectIdUniform(0),
     mSelectedTrack(), mSelectedPickType(ETrackNodePickType::Position), bSelectingJunctionPartner(false), mPendingNewTrackName(""),
     bTrackDialogOpen(false), bCanDuplicatePoint(true)
 {
@@ -128,6 +138,7 @@ void ATrackContext::InitSimpleShader() {
 
     UCommonUniformBuffer::LinkShaderToUBO(mSimpleProgram);
     mBaseColorUniform = glGetUniformLocation(mSimpleProgram, "uBaseColor");
+    mObjectIdUniform = glGetUniformLocation(mSimpleProgram, "uObjectId");
 }
 
 void ATrackContext::DestroyGLResources() {
@@ -146,6 +157,8 @@ void ATrackContext::DestroyGLResources() {
 }
 
 void ATrackContext::LoadTracks(std::filesystem::path filePath) {
+    ZoneScoped;
+
     pugi::xml_document doc;
     pugi::xml_parse_result result = doc.load_file(filePath.c_str());
 
@@ -155,6 +168,7 @@ void ATrackContext::LoadTracks(std::filesystem::path filePath) {
 
     if (IsLoaded()) {
         ClearSelectedPoints();
+        mHoveredPoint.reset();
         mTracks.clear();
         mTrackPoints.clear();
         mPathRenderers.clear();
@@ -188,9 +202,12 @@ void ATrackContext::LoadTracks(std::filesystem::path filePath) {
     }
 
     PostprocessNodes();
+    AFrameScheduler::Invalidate(INVALIDATE_DATA);
 }
 
 void ATrackContext::PostprocessNodes() {
+    ZoneScoped;
+
     for (shared_vector<UTracks::UTrackPoint> trackPoints : mTrackPoints) {
         for (const std::shared_ptr<UTracks::UTrackPoint> pnt : trackPoints) {
             if (!pnt->IsJunction() || !pnt->GetJunctionPartner().expired()) {
@@ -220,6 +237,8 @@ void ATrackContext::PostprocessNodes() {
 }
 
 void ATrackContext::SaveTracks(std::filesystem::path dirPath) {
+    ZoneScoped;
+
     std::filesystem::path fullConfigPath = dirPath / TRACKS_FILE_NAME;
     pugi::xml_document doc;
     doc.document_element().append_attribute("encoding").set_value("UTF-8");
@@ -276,11 +295,13 @@ void ATrackContext::RenderTreeView() {
             if (track->IsHidden()) {
                 if (ImGui::Button("Show", { 40, 0 })) {
                     track->SetHidden(false);
+                    AFrameScheduler::Invalidate(INVALIDATE_DATA);
                 }
             }
             else {
                 if (ImGui::Button("Hide", { 40, 0 })) {
                     track->SetHidden(true);
+                    AFrameScheduler::Invalidate(INVALIDATE_DATA);
                 }
             }
 
@@ -361,6 +382,7 @@ void ATrackContext::RenderPointDataEditorSingle(std::shared_ptr<UTracks::UTrackP
 
                 if (ImGui::Button("Clear Junction")) {
                     point->SetJunctionPartner(nullptr);
+                    AFrameScheduler::Invalidate(INVALIDATE_DATA);
                 }
             }
         }
@@ -373,7 +395,7 @@ void ATrackContext::RenderPointDataEditorSingle(std::shared_ptr<UTracks::UTrackP
 
         ImGui::Spacing();
         if (ImGui::Checkbox("Is curve?", point->GetIsCurveForEditor())) {
-
+            AFrameScheduler::Invalidate(INVALIDATE_DATA);
         }
 
         ImGui::Unindent();
@@ -420,6 +442,7 @@ void ATrackContext::RenderNewTrackDialog() {
             pathRenderer->UpdateData();
             mPathRenderers.push_back(pathRenderer);
 
+            AFrameScheduler::Invalidate(INVALIDATE_DATA);
             ImGui::CloseCurrentPopup();
         }
         if (mPendingNewTrackName.empty()) {
@@ -562,6 +585,9 @@ void ATrackContext::RenderUI(ASceneCamera& camera) {
     }
 
     if (bUpdated) {
+        // Undo only covers the last batch edit; restoring it now would also throw away this drag.
+        mUndoState.clear();
+
         for (const APointSelection& s : mSelectedPoints) {
             CPathPoint& p = mPathRenderers[s.TrackIdx]->mPath[s.PointIdx];
             p.Position = mTrackPoints[s.TrackIdx][s.PointIdx]->GetPosition();
@@ -570,70 +596,85 @@ void ATrackContext::RenderUI(ASceneCamera& camera) {
 
             mPathRenderers[s.TrackIdx]->UpdateData();
         }
+
+        AFrameScheduler::Invalidate(INVALIDATE_DATA);
     }
 }
 
 void ATrackContext::Render(ASceneCamera& camera) {
+    ZoneScoped;
+
     if (mTracks.size() == 0) {
         return;
     }
 
-    UCommonUniformBuffer::SetProjAndViewMatrices(camera.GetProjectionMatrix(), camera.GetViewMatrix());
-    glBindVertexArray(mPntVAO);
+    {
+        GPUZone("Track Nodes");
 
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
+        UCommonUniformBuffer::SetProjAndViewMatrices(camera.GetProjectionMatrix(), camera.GetViewMatrix());
+        glBindVertexArray(mPntVAO);
 
-    glEnable(GL_BLEND);
-    glBlendEquation(GL_FUNC_ADD);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LEQUAL);
 
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
+        glEnable(GL_BLEND);
+        glBlendEquation(GL_FUNC_ADD);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    glUseProgram(mSimpleProgram);
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_BACK);
 
-    for (uint32_t trackIdx = 0; trackIdx < mTracks.size(); trackIdx++) {
-        if (mTracks[trackIdx]->IsHidden()) {
-            continue;
-        }
+        glUseProgram(mSimpleProgram);
 
-        for (const std::shared_ptr<UTracks::UTrackPoint> pnt : mTrackPoints[trackIdx]) {
-            if (pnt->IsSelected()) {
-                glUniform4fv(mBaseColorUniform, 1, &SELECTED_COLOR.x);
-            }
-            else if (pnt->IsHighlighted()) {
-                glUniform4fv(mBaseColorUniform, 1, &HIGHLIGHT_COLOR.x);
-            }
-            else {
-                glUniform4fv(mBaseColorUniform, 1, &NORMAL_COLOR.x);
+        for (uint32_t trackIdx = 0; trackIdx < mTracks.size(); trackIdx++) {
+            if (mTracks[trackIdx]->IsHidden()) {
+                continue;
             }
 
-            UCommonUniformBuffer::SetModelMatrix(glm::translate(glm::identity<glm::mat4>(), pnt->GetPosition()));
-            UCommonUniformBuffer::SubmitUBO();
+            for (uint32_t pointIdx = 0; pointIdx < mTrackPoints[trackIdx].size(); pointIdx++) {
+                const std::shared_ptr<UTracks::UTrackPoint> pnt = mTrackPoints[trackIdx][pointIdx];
+                uint32_t pickId = GetPickId(trackIdx, pointIdx);
 
-            glDrawElements(GL_TRIANGLES, USphere::IndexCount, GL_UNSIGNED_INT, 0);
-
-            pnt->SetHighlighted(false);
+                if (pnt->IsSelected()) {
+                    glUniform4fv(mBaseColorUniform, 1, &SELECTED_COLOR.x);
+                }
+                else if (pnt->IsHighlighted()) {
+                    glUniform4fv(mBaseColorUniform, 1, &HIGHLIGHT_COLOR.x);
+                }
+                else {
+                    glUniform4fv(mBaseColorUniform, 1, &NORMAL_COLOR.x);
+                }
 
-            // Draw handles
-            if (pnt->IsCurve() && pnt->IsSelected()) {
-                glUniform4fv(mBaseColorUniform, 1, &HANDLE_COLOR.r);
-                UCommonUniformBuffer::SetModelMatrix(glm::translate(glm::identity<glm::mat4>(), pnt->GetHandleA()));
+                UCommonUniformBuffer::SetModelMatrix(glm::translate(glm::identity<glm::mat4>(), pnt->GetPosition()));
                 UCommonUniformBuffer::SubmitUBO();
 
+                // Only lands anywhere if the viewport has its pick ID attachment enabled.
+                glUniform1ui(mObjectIdUniform, pickId);
                 glDrawElements(GL_TRIANGLES, USphere::IndexCount, GL_UNSIGNED_INT, 0);
 
-                UCommonUniformBuffer::SetModelMatrix(glm::translate(glm::identity<glm::mat4>(), pnt->GetHandleB()));
-                UCommonUniformBuffer::SubmitUBO();
+                // Draw handles
+                if (pnt->IsCurve() && pnt->IsSelected()) {
+                    glUniform4fv(mBaseColorUniform, 1, &HANDLE_COLOR.r);
+                    UCommonUniformBuffer::SetModelMatrix(glm::translate(glm::identity<glm::mat4>(), pnt->GetHandleA()));
+                    UCommonUniformBuffer::SubmitUBO();
 
-                glDrawElements(GL_TRIANGLES, USphere::IndexCount, GL_UNSIGNED_INT, 0);
+                    glUniform1ui(mObjectIdUniform, HANDLE_A_MASK | pickId);
+                    glDrawElements(GL_TRIANGLES, USphere::IndexCount, GL_UNSIGNED_INT, 0);
+
+                    UCommonUniformBuffer::SetModelMatrix(glm::translate(glm::identity<glm::mat4>(), pnt->GetHandleB()));
+                    UCommonUniformBuffer::SubmitUBO();
+
+                    glUniform1ui(mObjectIdUniform, HANDLE_B_MASK | pickId);
+                    glDrawElements(GL_TRIANGLES, USphere::IndexCount, GL_UNSIGNED_INT, 0);
+                }
             }
         }
+
+        glUseProgram(0);
+        glBindVertexArray(0);
     }
 
-    glUseProgram(0);
-    glBindVertexArray(0);
+    GPUZone("Track Paths");
 
     for (uint32_t trackIdx = 0; trackIdx < mTracks.size(); trackIdx++) {
         if (mTracks[trackIdx]->IsHidden()) {
@@ -645,6 +686,14 @@ void ATrackContext::Render(ASceneCamera& camera) {
 }
 
 void ATrackContext::RenderPickingBuffer(ASceneCamera& camera) {
+    // In single-pass mode Render() already wrote the IDs next to the color buffer.
+    if (UViewportPicker::UsesSharedSource()) {
+        return;
+    }
+
+    ZoneScoped;
+    GPUZone("Picking");
+
     UViewportPicker::BindBuffer();
 
     UCommonUniformBuffer::SetProjAndViewMatrices(camera.GetProjectionMatrix(), camera.GetViewMatrix());
@@ -669,9 +718,8 @@ void ATrackContext::RenderPickingBuffer(ASceneCamera& camera) {
             UCommonUniformBuffer::SetModelMatrix(glm::translate(glm::identity<glm::mat4>(), mTrackPoints[trackIdx][pointIdx]->GetPosition()));
             UCommonUniformBuffer::SubmitUBO();
 
-            uint32_t trackId = ((trackIdx + 1) << 16) & 0x3FFF0000;
-            uint32_t pointId = pointIdx + 1;
-            UViewportPicker::SetIdUniform(trackId | pointId);
+            uint32_t pickId = GetPickId(trackIdx, pointIdx);
+            UViewportPicker::SetIdUniform(pickId);
 
             glDrawElements(GL_TRIANGLES, USphere::IndexCount, GL_UNSIGNED_INT, 0);
 
@@ -679,13 +727,13 @@ void ATrackContext::RenderPickingBuffer(ASceneCamera& camera) {
                 UCommonUniformBuffer::SetModelMatrix(glm::translate(glm::identity<glm::mat4>(), mTrackPoints[trackIdx][pointIdx]->GetHandleA()));
                 UCommonUniformBuffer::SubmitUBO();
 
-                UViewportPicker::SetIdUniform(HANDLE_A_MASK | trackId | pointId);
+                UViewportPicker::SetIdUniform(HANDLE_A_MASK | pickId);
                 glDrawElements(GL_TRIANGLES, USphere::IndexCount, GL_UNSIGNED_INT, 0);
 
                 UCommonUniformBuffer::SetModelMatrix(glm::translate(glm::identity<glm::mat4>(), mTrackPoints[trackIdx][pointIdx]->GetHandleB()));
                 UCommonUniformBuffer::SubmitUBO();
 
-                UViewportPicker::SetIdUniform(HANDLE_B_MASK | trackId | pointId);
+                UViewportPicker::SetIdUniform(HANDLE_B_MASK | pickId);
                 glDrawElements(GL_TRIANGLES, USphere::IndexCount, GL_UNSIGNED_INT, 0);
             }
         }
@@ -695,6 +743,8 @@ void ATrackContext::RenderPickingBuffer(ASceneCamera& camera) {
 }
 
 void ATrackContext::OnMouseHover(ASceneCamera& camera, int32_t pX, int32_t pY) {
+    ZoneScoped;
+
     if (mTracks.size() == 0 || ImGuizmo::IsUsing()) {
         return;
     }
@@ -702,18 +752,36 @@ void ATrackContext::OnMouseHover(ASceneCamera& camera, int32_t pX, int32_t pY) {
     RenderPickingBuffer(camera);
 
     uint32_t result = UViewportPicker::Query(pX, pY);
-    if (result == 0) {
+
+    std::shared_ptr<UTracks::UTrackPoint> hoveredPoint = nullptr;
+    if (result != 0) {
+        //mSelectedPickType = ETrackNodePickType((result & 0xC0000000) >> 30);
+        uint16_t trackIdx = ((result & 0x3FFF0000) >> 16) - 1;
+        uint16_t pointIdx = (result & 0xFFFF) - 1;
+
+        hoveredPoint = mTrackPoints[trackIdx][pointIdx];
+    }
+
+    // Only touch the highlight state (and re-render) when the hovered node actually changes.
+    std::shared_ptr<UTracks::UTrackPoint> prevHoveredPoint = mHoveredPoint.lock();
+    if (hoveredPoint == prevHoveredPoint) {
         return;
     }
 
-    //mSelectedPickType = ETrackNodePickType((result & 0xC0000000) >> 30);
-    uint16_t trackIdx = ((result & 0x3FFF0000) >> 16) - 1;
-    uint16_t pointIdx = (result & 0xFFFF) - 1;
+    if (prevHoveredPoint != nullptr) {
+        prevHoveredPoint->SetHighlighted(false);
+    }
+    if (hoveredPoint != nullptr) {
+        hoveredPoint->SetHighlighted(true);
+    }
 
-    mTrackPoints[trackIdx][pointIdx]->SetHighlighted(true);
+    mHoveredPoint = hoveredPoint;
+    AFrameScheduler::Invalidate(INVALIDATE_DATA);
 }
 
 void ATrackContext::OnMouseClick(ASceneCamera& camera, int32_t pX, int32_t pY) {
+    ZoneScoped;
+
     if (mTracks.size() == 0 || ImGuizmo::IsUsing()) {
         return;
     }
@@ -721,6 +789,9 @@ void ATrackContext::OnMouseClick(ASceneCamera& camera, int32_t pX, int32_t pY) {
     RenderPickingBuffer(camera);
     uint32_t result = UViewportPicker::Query(pX, pY);
 
+    // Selection and junction changes are both visible in the viewport.
+    AFrameScheduler::Invalidate(INVALIDATE_DATA);
+
     ETrackNodePickType pickType = ETrackNodePickType((result & 0xC0000000) >> 30);
     uint16_t trackIdx = ((result & 0x3FFF0000) >> 16) - 1;
     uint16_t pointIdx = (result & 0xFFFF) - 1;
@@ -780,6 +851,137 @@ void ATrackContext::OnMouseClick(ASceneCamera& camera, int32_t pX, int32_t pY) {
     }
 }
 
+void ATrackContext::SyncPathRenderer(uint32_t trackIdx) {
+    shared_vector<UTracks::UTrackPoint>& points = mTrackPoints[trackIdx];
+    std::shared_ptr<CPathRenderer> pathRenderer = mPathRenderers[trackIdx];
+
+    for (uint32_t i = 0; i < points.size() && i < pathRenderer->mPath.size(); i++) {
+        pathRenderer->mPath[i].Position = points[i]->GetPosition();
+        pathRenderer->mPath[i].LeftHandle = points[i]->GetHandleA();
+        pathRenderer->mPath[i].RightHandle = points[i]->GetHandleB();
+    }
+
+    pathRenderer->UpdateData();
+}
+
+uint32_t ATrackContext::SnapToGround(const ANavContext& navContext, ETrackSnapScope scope, float searchHeight, float searchDepth) {
+    ZoneScoped;
+
+    std::vector<APointSelection> targets;
+
+    switch (scope) {
+        case ETrackSnapScope::Snap_Selected_Nodes:
+            targets = mSelectedPoints;
+            break;
+        case ETrackSnapScope::Snap_Selected_Track:
+        case ETrackSnapScope::Snap_All_Tracks:
+        {
+            std::shared_ptr<UTracks::UTrack> selectedTrack = mSelectedTrack.lock();
+
+            for (uint16_t i = 0; i < mTracks.size(); i++) {
+                if (scope == ETrackSnapScope::Snap_Selected_Track && mTracks[i] != selectedTrack) {
+                    continue;
+                }
+
+                for (uint16_t j = 0; j < mTrackPoints[i].size(); j++) {
+                    targets.push_back({ i, j });
+                }
+            }
+
+            break;
+        }
+    }
+
+    if (targets.empty()) {
+        return 0;
+    }
+
+    // Node, handle A, handle B for every target, all snapped in one batch.
+    std::vector<glm::vec3> queries;
+    queries.reserve(targets.size() * 3);
+
+    for (const APointSelection& s : targets) {
+        std::shared_ptr<UTracks::UTrackPoint> pnt = mTrackPoints[s.TrackIdx][s.PointIdx];
+
+        queries.push_back(pnt->GetPosition());
+        queries.push_back(pnt->GetHandleA());
+        queries.push_back(pnt->GetHandleB());
+    }
+
+    std::vector<uint8_t> snapped;
+    if (navContext.SnapToGround(queries, searchHeight, searchDepth, &snapped) == 0) {
+        return 0;
+    }
+
+    mUndoState.clear();
+
+    std::vector<bool> dirtyTracks(mTracks.size(), false);
+    uint32_t movedCount = 0;
+
+    for (uint32_t i = 0; i < targets.size(); i++) {
+        const APointSelection& s = targets[i];
+        std::shared_ptr<UTracks::UTrackPoint> pnt = mTrackPoints[s.TrackIdx][s.PointIdx];
+
+        if (!snapped[i * 3] && !(pnt->IsCurve() && (snapped[i * 3 + 1] || snapped[i * 3 + 2]))) {
+            continue;
+        }
+
+        mUndoState.push_back({ pnt, pnt->GetPosition(), pnt->GetHandleA(), pnt->GetHandleB() });
+
+        glm::vec3 delta = queries[i * 3] - pnt->GetPosition();
+        pnt->GetPositionForEditor() = queries[i * 3];
+
+        if (pnt->IsCurve()) {
+            // A handle with nothing under it keeps its height relative to the node.
+            pnt->GetHandleAForEditor() = snapped[i * 3 + 1] ? queries[i * 3 + 1] : pnt->GetHandleA() + delta;
+            pnt->GetHandleBForEditor() = snapped[i * 3 + 2] ? queries[i * 3 + 2] : pnt->GetHandleB() + delta;
+        }
+        else {
+            pnt->GetHandleAForEditor() += delta;
+            pnt->GetHandleBForEditor() += delta;
+        }
+
+        dirtyTracks[s.TrackIdx] = true;
+        movedCount++;
+    }
+
+    for (uint32_t i = 0; i < dirtyTracks.size(); i++) {
+        if (dirtyTracks[i]) {
+            SyncPathRenderer(i);
+        }
+    }
+
+    AFrameScheduler::Invalidate(INVALIDATE_DATA);
+    return movedCount;
+}
+
+void ATrackContext::Undo() {
+    ZoneScoped;
+
+    if (mUndoState.empty()) {
+        return;
+    }
+
+    for (const ATrackPointState& state : mUndoState) {
+        std::shared_ptr<UTracks::UTrackPoint> pnt = state.mPoint.lock();
+        if (pnt == nullptr) {
+            continue;
+        }
+
+        pnt->GetPositionForEditor() = state.mPosition;
+        pnt->GetHandleAForEditor() = state.mHandleA;
+        pnt->GetHandleBForEditor() = state.mHandleB;
+    }
+
+    mUndoState.clear();
+
+    for (uint32_t i = 0; i < mTracks.size(); i++) {
+        SyncPathRenderer(i);
+    }
+
+    AFrameScheduler::Invalidate(INVALIDATE_DATA);
+}
+
 void ATrackContext::ClearSelectedPoints() {
     for (APointSelection pnt : mSelectedPoints) {
         uint16_t trackIdx, pointIdx;
@@ -1,8 +1,63 @@
 #include "application/AGatorApplication.hpp"
+#include "application/AHeadlessApplication.hpp"
+#include "application/ANavBenchmark.hpp"
 
 #include <iostream>
+#include <new>
+#include <cstdlib>
+
+#ifdef TRACY_ENABLE
+// Report every heap allocation to Tracy so memory usage shows up next to the zones.
+void* operator new(std::size_t size) {
+	void* ptr = std::malloc(size == 0 ? 1 : size);
+	if (ptr == nullptr) {
+		throw std::bad_alloc();
+	}
+
+	TracyAlloc(ptr, size);
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+	TracyFree(ptr);
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	TracyFree(ptr);
+	std::free(ptr);
+}
+#endif
 
 int main(int argc, char* argv[]) {
+	ANavBenchmarkSettings benchmarkSettings;
+	if (benchmarkSettings.ParseArgs(argc, argv)) {
+		return ANavBenchmark::Run(benchmarkSettings);
+	}
+
+#ifdef NAVIGATOR_HEADLESS
+	AHeadlessSettings headlessSettings;
+	if (headlessSettings.ParseArgs(argc, argv)) {
+		if (!headlessSettings.mArgsError.empty()) {
+			std::cout << headlessSettings.mArgsError << std::endl;
+			std::cout << AHeadlessSettings::USAGE << std::endl;
+			return 1;
+		}
+
+		AHeadlessApplication headlessApp(headlessSettings);
+
+		if (!headlessApp.Setup()) {
+			std::cout << "Failed to set up headless rendering!" << std::endl;
+			return 1;
+		}
+
+		headlessApp.Run();
+		headlessApp.Teardown();
+
+		return 0;
+	}
+#endif
+
 	AGatorApplication app;
 
 	if (!app.Setup()) {
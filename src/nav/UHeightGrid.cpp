@@ -0,0 +1,364 @@
+#include "nav/UHeightGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace {
+    // Everything below this is treated as "no surface" while rasterizing.
+    constexpr float NO_HEIGHT = std::numeric_limits<float>::lowest();
+
+    // Slack on the edge tests so cell centres that land exactly on a shared edge aren't missed by both triangles.
+    constexpr float EDGE_EPSILON = 1e-4f;
+}
+
+UNav::UHeightGrid::UHeightGrid() : mHeader(), mCells(nullptr) {
+
+}
+
+void UNav::UHeightGrid::Build(const float* vertices, uint32_t vertexStride, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount,
+    const glm::vec3& boundsMin, const glm::vec3& boundsMax, float cellSize, uint64_t sourceHash)
+{
+    ZoneScoped;
+
+    mFile.Close();
+    mOwnedCells.clear();
+    mCells = nullptr;
+
+    glm::vec2 extent(std::max(boundsMax.x - boundsMin.x, 0.0f), std::max(boundsMax.z - boundsMin.z, 0.0f));
+    cellSize = std::max({ cellSize, extent.x / MAX_DIMENSION, extent.y / MAX_DIMENSION, 0.01f });
+
+    mHeader = {};
+    mHeader.mMagic = MAGIC;
+    mHeader.mVersion = VERSION;
+    mHeader.mSourceHash = sourceHash;
+    mHeader.mOriginX = boundsMin.x;
+    mHeader.mOriginZ = boundsMin.z;
+    mHeader.mCellSize = cellSize;
+    mHeader.mWidth = std::min(std::max(uint32_t(std::ceil(extent.x / cellSize)), 1u), MAX_DIMENSION);
+    mHeader.mHeight = std::min(std::max(uint32_t(std::ceil(extent.y / cellSize)), 1u), MAX_DIMENSION);
+
+    const uint32_t width = mHeader.mWidth;
+    const uint32_t height = mHeader.mHeight;
+    const float invCellSize = 1.0f / cellSize;
+
+    std::vector<float> heights(size_t(width) * height, NO_HEIGHT);
+
+    auto splat = [&](uint32_t x, uint32_t z, float y) {
+        float& cell = heights[size_t(z) * width + x];
+        cell = std::max(cell, y);
+    };
+
+    // Cell centre (x + 0.5, z + 0.5) * cellSize, relative to the origin.
+    for (uint32_t i = 0; i + 2 < indexCount; i += 3) {
+        if (indices[i + 0] >= vertexCount || indices[i + 1] >= vertexCount || indices[i + 2] >= vertexCount) {
+            continue;
+        }
+
+        const float* p0 = vertices + size_t(indices[i + 0]) * vertexStride;
+        const float* p1 = vertices + size_t(indices[i + 1]) * vertexStride;
+        const float* p2 = vertices + size_t(indices[i + 2]) * vertexStride;
+
+        glm::vec2 a((p0[0] - mHeader.mOriginX) * invCellSize, (p0[2] - mHeader.mOriginZ) * invCellSize);
+        glm::vec2 b((p1[0] - mHeader.mOriginX) * invCellSize, (p1[2] - mHeader.mOriginZ) * invCellSize);
+        glm::vec2 c((p2[0] - mHeader.mOriginX) * invCellSize, (p2[2] - mHeader.mOriginZ) * invCellSize);
+
+        float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        if (std::abs(area) < 1e-8f) {
+            continue;
+        }
+
+        float invArea = 1.0f / area;
+
+        int32_t x0 = std::max(int32_t(std::ceil(std::min({ a.x, b.x, c.x }) - 0.5f)), 0);
+        int32_t z0 = std::max(int32_t(std::ceil(std::min({ a.y, b.y, c.y }) - 0.5f)), 0);
+        int32_t x1 = std::min(int32_t(std::floor(std::max({ a.x, b.x, c.x }) - 0.5f)), int32_t(width) - 1);
+        int32_t z1 = std::min(int32_t(std::floor(std::max({ a.y, b.y, c.y }) - 0.5f)), int32_t(height) - 1);
+
+        for (int32_t z = z0; z <= z1; z++) {
+            for (int32_t x = x0; x <= x1; x++) {
+                glm::vec2 p(float(x) + 0.5f, float(z) + 0.5f);
+
+                // Barycentrics, normalized so they're positive inside regardless of winding.
+                float w0 = ((b.x - p.x) * (c.y - p.y) - (b.y - p.y) * (c.x - p.x)) * invArea;
+                float w1 = ((c.x - p.x) * (a.y - p.y) - (c.y - p.y) * (a.x - p.x)) * invArea;
+                float w2 = 1.0f - w0 - w1;
+
+                if (w0 < -EDGE_EPSILON || w1 < -EDGE_EPSILON || w2 < -EDGE_EPSILON) {
+                    continue;
+                }
+
+                splat(uint32_t(x), uint32_t(z), w0 * p0[1] + w1 * p1[1] + w2 * p2[1]);
+            }
+        }
+    }
+
+    // Slivers too thin to cover any cell centre would otherwise vanish, so their vertices fill in
+    // whatever cells were left empty. Covered cells keep their interpolated heights.
+    std::vector<float> vertexHeights(heights.size(), NO_HEIGHT);
+    for (uint32_t i = 0; i + 2 < indexCount; i += 3) {
+        if (indices[i + 0] >= vertexCount || indices[i + 1] >= vertexCount || indices[i + 2] >= vertexCount) {
+            continue;
+        }
+
+        for (uint32_t corner = 0; corner < 3; corner++) {
+            const float* p = vertices + size_t(indices[i + corner]) * vertexStride;
+
+            int32_t x = std::clamp(int32_t((p[0] - mHeader.mOriginX) * invCellSize), 0, int32_t(width) - 1);
+            int32_t z = std::clamp(int32_t((p[2] - mHeader.mOriginZ) * invCellSize), 0, int32_t(height) - 1);
+
+            float& cell = vertexHeights[size_t(z) * width + x];
+            cell = std::max(cell, p[1]);
+        }
+    }
+
+    for (size_t i = 0; i < heights.size(); i++) {
+        if (heights[i] == NO_HEIGHT) {
+            heights[i] = vertexHeights[i];
+        }
+    }
+
+    float minHeight = std::numeric_limits<float>::max();
+    float maxHeight = std::numeric_limits<float>::lowest();
+    for (float h : heights) {
+        if (h != NO_HEIGHT) {
+            minHeight = std::min(minHeight, h);
+            maxHeight = std::max(maxHeight, h);
+        }
+    }
+
+    if (minHeight > maxHeight) {
+        minHeight = maxHeight = boundsMin.y;
+    }
+
+    // EMPTY_CELL is reserved, so the range maps onto one less than the full 16 bits.
+    mHeader.mMinHeight = minHeight;
+    mHeader.mHeightScale = std::max(maxHeight - minHeight, 1e-6f) / float(EMPTY_CELL - 1);
+
+    const float invScale = 1.0f / mHeader.mHeightScale;
+
+    mOwnedCells.resize(heights.size());
+    for (size_t i = 0; i < heights.size(); i++) {
+        if (heights[i] == NO_HEIGHT) {
+            mOwnedCells[i] = EMPTY_CELL;
+        }
+        else {
+            mOwnedCells[i] = uint16_t(std::min((heights[i] - minHeight) * invScale + 0.5f, float(EMPTY_CELL - 1)));
+        }
+    }
+
+    mCells = mOwnedCells.data();
+}
+
+bool UNav::UHeightGrid::Save(const std::filesystem::path& path) const {
+    ZoneScoped;
+
+    if (mCells == nullptr) {
+        return false;
+    }
+
+    // Write next to the destination and swap it in, so a reader never maps a half-written file.
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(&mHeader), sizeof(mHeader));
+        file.write(reinterpret_cast<const char*>(mCells), GetMemoryUsage());
+
+        if (!file) {
+            file.close();
+
+            std::error_code error;
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    return true;
+}
+
+bool UNav::UHeightGrid::Load(const std::filesystem::path& path, uint64_t sourceHash) {
+    ZoneScoped;
+
+    mOwnedCells.clear();
+    mOwnedCells.shrink_to_fit();
+    mCells = nullptr;
+
+    if (!mFile.Open(path) || mFile.GetSize() < sizeof(UHeightGridHeader)) {
+        mFile.Close();
+        return false;
+    }
+
+    UHeightGridHeader header;
+    std::memcpy(&header, mFile.GetData(), sizeof(header));
+
+    if (header.mMagic != MAGIC || header.mVersion != VERSION || header.mSourceHash != sourceHash ||
+        header.mWidth == 0 || header.mHeight == 0 || header.mWidth > MAX_DIMENSION || header.mHeight > MAX_DIMENSION ||
+        mFile.GetSize() != sizeof(header) + size_t(header.mWidth) * header.mHeight * sizeof(uint16_t))
+    {
+        mFile.Close();
+        return false;
+    }
+
+    mHeader = header;
+    // The header is a multiple of four bytes and mappings are page aligned, so this is properly aligned.
+    mCells = reinterpret_cast<const uint16_t*>(mFile.GetData() + sizeof(UHeightGridHeader));
+
+    return true;
+}
+
+glm::vec2 UNav::UHeightGrid::GetBoundsMax() const {
+    return GetBoundsMin() + glm::vec2(float(mHeader.mWidth), float(mHeader.mHeight)) * mHeader.mCellSize;
+}
+
+bool UNav::UHeightGrid::GetHeight(float x, float z, float& height) const {
+    if (mCells == nullptr) {
+        return false;
+    }
+
+    float invCellSize = 1.0f / mHeader.mCellSize;
+    float fx = (x - mHeader.mOriginX) * invCellSize;
+    float fz = (z - mHeader.mOriginZ) * invCellSize;
+
+    if (!(fx >= 0.0f && fz >= 0.0f && fx <= float(mHeader.mWidth) && fz <= float(mHeader.mHeight))) {
+        return false;
+    }
+
+    // Cell centres sit at +0.5, so shift before picking the four to blend. The outer half cell
+    // extrapolates from the last two centres rather than flattening out.
+    float sx = fx - 0.5f;
+    float sz = fz - 0.5f;
+
+    uint32_t x0 = uint32_t(std::clamp(int32_t(std::floor(sx)), 0, std::max(int32_t(mHeader.mWidth) - 2, 0)));
+    uint32_t z0 = uint32_t(std::clamp(int32_t(std::floor(sz)), 0, std::max(int32_t(mHeader.mHeight) - 2, 0)));
+    uint32_t x1 = std::min(x0 + 1, mHeader.mWidth - 1);
+    uint32_t z1 = std::min(z0 + 1, mHeader.mHeight - 1);
+    float tx = sx - float(x0);
+    float tz = sz - float(z0);
+
+    uint16_t c00 = GetCell(x0, z0);
+    uint16_t c10 = GetCell(x1, z0);
+    uint16_t c01 = GetCell(x0, z1);
+    uint16_t c11 = GetCell(x1, z1);
+
+    if (c00 != EMPTY_CELL && c10 != EMPTY_CELL && c01 != EMPTY_CELL && c11 != EMPTY_CELL) {
+        float top = glm::mix(float(c00), float(c10), tx);
+        float bottom = glm::mix(float(c01), float(c11), tx);
+        height = mHeader.mMinHeight + glm::mix(top, bottom, tz) * mHeader.mHeightScale;
+
+        return true;
+    }
+
+    // Near an edge of the surface; blending in empty cells would be meaningless.
+    uint16_t nearest = GetCell(std::min(uint32_t(fx), mHeader.mWidth - 1), std::min(uint32_t(fz), mHeader.mHeight - 1));
+    if (nearest == EMPTY_CELL) {
+        return false;
+    }
+
+    height = DecodeHeight(nearest);
+    return true;
+}
+
+void UNav::UHeightGridIndex::GetBucketRange(const UHeightGrid& grid, int32_t& x0, int32_t& z0, int32_t& x1, int32_t& z1) {
+    glm::vec2 boundsMin = grid.GetBoundsMin() / BUCKET_SIZE;
+    glm::vec2 boundsMax = grid.GetBoundsMax() / BUCKET_SIZE;
+
+    x0 = int32_t(std::floor(boundsMin.x));
+    z0 = int32_t(std::floor(boundsMin.y));
+    x1 = int32_t(std::floor(boundsMax.x));
+    z1 = int32_t(std::floor(boundsMax.y));
+}
+
+void UNav::UHeightGridIndex::Add(const std::shared_ptr<const UHeightGrid>& grid) {
+    if (grid == nullptr || grid->IsEmpty()) {
+        return;
+    }
+
+    int32_t x0, z0, x1, z1;
+    GetBucketRange(*grid, x0, z0, x1, z1);
+
+    for (int32_t z = z0; z <= z1; z++) {
+        for (int32_t x = x0; x <= x1; x++) {
+            mBuckets[GetBucketKey(x, z)].push_back(grid);
+        }
+    }
+
+    mGridCount++;
+    mMemoryUsage += grid->GetMemoryUsage();
+}
+
+void UNav::UHeightGridIndex::Remove(const std::shared_ptr<const UHeightGrid>& grid) {
+    if (grid == nullptr || grid->IsEmpty()) {
+        return;
+    }
+
+    int32_t x0, z0, x1, z1;
+    GetBucketRange(*grid, x0, z0, x1, z1);
+
+    bool bFound = false;
+
+    for (int32_t z = z0; z <= z1; z++) {
+        for (int32_t x = x0; x <= x1; x++) {
+            auto it = mBuckets.find(GetBucketKey(x, z));
+            if (it == mBuckets.end()) {
+                continue;
+            }
+
+            std::vector<std::shared_ptr<const UHeightGrid>>& bucket = it->second;
+
+            auto gridIt = std::find(bucket.begin(), bucket.end(), grid);
+            if (gridIt != bucket.end()) {
+                bucket.erase(gridIt);
+                bFound = true;
+            }
+
+            if (bucket.empty()) {
+                mBuckets.erase(it);
+            }
+        }
+    }
+
+    if (bFound) {
+        mGridCount--;
+        mMemoryUsage -= grid->GetMemoryUsage();
+    }
+}
+
+void UNav::UHeightGridIndex::Clear() {
+    mBuckets.clear();
+    mGridCount = 0;
+    mMemoryUsage = 0;
+}
+
+bool UNav::UHeightGridIndex::GetHeight(float x, float z, float& height) const {
+    auto it = mBuckets.find(GetBucketKey(int32_t(std::floor(x / BUCKET_SIZE)), int32_t(std::floor(z / BUCKET_SIZE))));
+    if (it == mBuckets.end()) {
+        return false;
+    }
+
+    bool bFound = false;
+
+    for (const std::shared_ptr<const UHeightGrid>& grid : it->second) {
+        float gridHeight;
+        if (grid->GetHeight(x, z, gridHeight) && (!bFound || gridHeight > height)) {
+            height = gridHeight;
+            bFound = true;
+        }
+    }
+
+    return bFound;
+}
@@ -0,0 +1,362 @@
+#include "nav/UNavAllocator.hpp"
+
+#include <RecastAlloc.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+
+namespace UNavAllocator {
+    namespace {
+        // Ahead of every block so rcFree, which gets no hint, knows where it came from. Keeps the 16-byte
+        // alignment malloc gives.
+        struct alignas(16) UBlockHeader {
+            // Usable bytes after the header.
+            size_t mCapacity;
+            uint32_t mKind;
+        };
+
+        enum EBlockKind : uint32_t {
+            BLOCK_HEAP = 0x50414548,
+            BLOCK_ARENA = 0x4E455241,
+            // A heap block that can go back on the thread's recycle lists.
+            BLOCK_SIZED = 0x455A4953
+        };
+
+        constexpr size_t MIN_ARENA_BLOCK = 1024 * 1024;
+
+        // Recycled blocks come in four steps per power of two, so they're at most 25% larger than asked for.
+        constexpr size_t MIN_SIZE_CLASS = 64;
+        constexpr uint32_t MAX_SIZE_CLASS_BITS = 28;
+        constexpr uint32_t SIZE_CLASS_COUNT = 1 + (MAX_SIZE_CLASS_BITS - 6) * 4;
+        // Per thread; frees past this go straight back to the heap.
+        constexpr size_t MAX_RECYCLED_BYTES = 64 * 1024 * 1024;
+
+        struct UArenaBlock {
+            uint8_t* mData;
+            size_t mSize;
+        };
+
+        struct UThreadState {
+            // Held for the whole of a tile scope, so Trim() only touches threads that are between tiles.
+            std::mutex mMutex;
+            uint32_t mDepth = 0;
+
+            std::vector<UArenaBlock> mBlocks;
+            size_t mBlockOffset = 0;
+            // In earlier blocks of this scope; they're merged into one when it ends.
+            size_t mFullBytes = 0;
+            size_t mPeakBytes = 0;
+
+            // Intrusive lists through the freed blocks themselves.
+            void* mRecycled[SIZE_CLASS_COUNT] = {};
+            size_t mRecycledBytes = 0;
+
+            // Only written by the owning thread.
+            std::atomic<uint64_t> mAllocations = 0;
+            std::atomic<uint64_t> mHeapAllocations = 0;
+            std::atomic<uint64_t> mArenaAllocations = 0;
+            std::atomic<uint64_t> mRecycledAllocations = 0;
+            std::atomic<size_t> mPeakArenaBytes = 0;
+            std::atomic<size_t> mRetainedBytes = 0;
+        };
+
+        std::mutex mRegistryMutex;
+        std::vector<UThreadState*> mThreads;
+
+        // Counts from threads that have exited.
+        UNavAllocStats mExitedStats;
+
+        std::once_flag mInstallFlag;
+
+        size_t GetArenaCapacity(const UThreadState& state) {
+            size_t capacity = 0;
+            for (const UArenaBlock& block : state.mBlocks) {
+                capacity += block.mSize;
+            }
+
+            return capacity;
+        }
+
+        void ReleaseMemory(UThreadState& state) {
+            for (UArenaBlock& block : state.mBlocks) {
+                std::free(block.mData);
+            }
+
+            state.mBlocks.clear();
+            state.mBlockOffset = 0;
+            state.mFullBytes = 0;
+
+            for (void*& list : state.mRecycled) {
+                while (list != nullptr) {
+                    void* next = *static_cast<void**>(list);
+                    std::free(static_cast<UBlockHeader*>(list) - 1);
+                    list = next;
+                }
+            }
+
+            state.mRecycledBytes = 0;
+            state.mRetainedBytes = 0;
+        }
+
+        // Registers the thread on first use and cleans up after it when it exits.
+        struct UThreadStateOwner {
+            UThreadState* mState = nullptr;
+
+            UThreadState& Get() {
+                if (mState == nullptr) {
+                    mState = new UThreadState();
+
+                    std::lock_guard<std::mutex> lock(mRegistryMutex);
+                    mThreads.push_back(mState);
+                }
+
+                return *mState;
+            }
+
+            ~UThreadStateOwner() {
+                if (mState == nullptr) {
+                    return;
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mRegistryMutex);
+                    mThreads.erase(std::find(mThreads.begin(), mThreads.end(), mState));
+
+                    mExitedStats.mAllocations += mState->mAllocations;
+                    mExitedStats.mHeapAllocations += mState->mHeapAllocations;
+                    mExitedStats.mArenaAllocations += mState->mArenaAllocations;
+                    mExitedStats.mRecycledAllocations += mState->mRecycledAllocations;
+                    mExitedStats.mPeakArenaBytes = std::max(mExitedStats.mPeakArenaBytes, mState->mPeakArenaBytes.load());
+                }
+
+                ReleaseMemory(*mState);
+                delete mState;
+            }
+        };
+
+        thread_local UThreadStateOwner tThreadState;
+
+        bool GetSizeClass(size_t size, uint32_t& index, size_t& capacity) {
+            if (size <= MIN_SIZE_CLASS) {
+                index = 0;
+                capacity = MIN_SIZE_CLASS;
+                return true;
+            }
+
+            // size is in (2^(bits-1), 2^bits].
+            uint32_t bits = 0;
+            while ((size_t(1) << bits) < size) {
+                bits++;
+            }
+
+            if (bits > MAX_SIZE_CLASS_BITS) {
+                return false;
+            }
+
+            size_t step = size_t(1) << (bits - 3);
+            capacity = (size + step - 1) & ~(step - 1);
+            index = 1 + (bits - 7) * 4 + uint32_t(capacity / step) - 5;
+
+            return true;
+        }
+
+        void* AllocateHeap(UThreadState& state, size_t capacity, uint32_t kind) {
+            UBlockHeader* header = static_cast<UBlockHeader*>(std::malloc(sizeof(UBlockHeader) + capacity));
+            if (header == nullptr) {
+                return nullptr;
+            }
+
+            header->mCapacity = capacity;
+            header->mKind = kind;
+
+            state.mHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+            return header + 1;
+        }
+
+        void* AllocateArena(UThreadState& state, size_t size) {
+            size_t needed = sizeof(UBlockHeader) + ((size + 15) & ~size_t(15));
+
+            if (state.mBlocks.empty() || state.mBlockOffset + needed > state.mBlocks.back().mSize) {
+                if (!state.mBlocks.empty()) {
+                    state.mFullBytes += state.mBlockOffset;
+                }
+
+                size_t blockSize = std::max({ needed, MIN_ARENA_BLOCK, state.mBlocks.empty() ? size_t(0) : state.mBlocks.back().mSize * 2 });
+
+                uint8_t* data = static_cast<uint8_t*>(std::malloc(blockSize));
+                if (data == nullptr) {
+                    return nullptr;
+                }
+
+                state.mBlocks.push_back({ data, blockSize });
+                state.mBlockOffset = 0;
+                state.mHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            UBlockHeader* header = reinterpret_cast<UBlockHeader*>(state.mBlocks.back().mData + state.mBlockOffset);
+            header->mCapacity = needed - sizeof(UBlockHeader);
+            header->mKind = BLOCK_ARENA;
+
+            state.mBlockOffset += needed;
+            state.mPeakBytes = std::max(state.mPeakBytes, state.mFullBytes + state.mBlockOffset);
+            state.mArenaAllocations.fetch_add(1, std::memory_order_relaxed);
+
+            return header + 1;
+        }
+
+        void* Allocate(size_t size, rcAllocHint hint) {
+            UThreadState& state = tThreadState.Get();
+            state.mAllocations.fetch_add(1, std::memory_order_relaxed);
+
+            if (state.mDepth == 0) {
+                return AllocateHeap(state, size, BLOCK_HEAP);
+            }
+
+            if (hint == RC_ALLOC_TEMP) {
+                return AllocateArena(state, size);
+            }
+
+            uint32_t sizeClass;
+            size_t capacity;
+            if (!GetSizeClass(size, sizeClass, capacity)) {
+                return AllocateHeap(state, size, BLOCK_HEAP);
+            }
+
+            void* recycled = state.mRecycled[sizeClass];
+            if (recycled != nullptr) {
+                state.mRecycled[sizeClass] = *static_cast<void**>(recycled);
+                state.mRecycledBytes -= capacity;
+                state.mRecycledAllocations.fetch_add(1, std::memory_order_relaxed);
+
+                return recycled;
+            }
+
+            return AllocateHeap(state, capacity, BLOCK_SIZED);
+        }
+
+        void Free(void* ptr) {
+            UBlockHeader* header = static_cast<UBlockHeader*>(ptr) - 1;
+
+            if (header->mKind == BLOCK_ARENA) {
+                // Arena memory comes back when the scope ends; the most recent allocation can be popped early.
+                UThreadState& state = tThreadState.Get();
+                if (state.mDepth != 0 && !state.mBlocks.empty()) {
+                    uint8_t* top = state.mBlocks.back().mData + state.mBlockOffset;
+                    if (static_cast<uint8_t*>(ptr) + header->mCapacity == top) {
+                        state.mBlockOffset -= sizeof(UBlockHeader) + header->mCapacity;
+                    }
+                }
+
+                return;
+            }
+
+            if (header->mKind == BLOCK_SIZED) {
+                UThreadState& state = tThreadState.Get();
+
+                uint32_t sizeClass;
+                size_t capacity;
+                if (state.mDepth != 0 && state.mRecycledBytes + header->mCapacity <= MAX_RECYCLED_BYTES &&
+                    GetSizeClass(header->mCapacity, sizeClass, capacity))
+                {
+                    *static_cast<void**>(ptr) = state.mRecycled[sizeClass];
+                    state.mRecycled[sizeClass] = ptr;
+                    state.mRecycledBytes += capacity;
+                    return;
+                }
+            }
+
+            std::free(header);
+        }
+    }
+}
+
+void UNavAllocator::Install() {
+    std::call_once(mInstallFlag, []() {
+        rcAllocSetCustom(Allocate, Free);
+    });
+}
+
+UNavAllocator::UTileScope::UTileScope() {
+    UThreadState& state = tThreadState.Get();
+
+    if (state.mDepth++ == 0) {
+        state.mMutex.lock();
+    }
+}
+
+UNavAllocator::UTileScope::~UTileScope() {
+    UThreadState& state = tThreadState.Get();
+
+    if (--state.mDepth != 0) {
+        return;
+    }
+
+    if (state.mPeakBytes > state.mPeakArenaBytes) {
+        state.mPeakArenaBytes = state.mPeakBytes;
+    }
+
+    // Anything that spilled into more blocks gets one block big enough for all of it, so the next
+    // tile of the same size doesn't have to grow the arena again.
+    if (state.mBlocks.size() > 1) {
+        size_t capacity = GetArenaCapacity(state);
+
+        for (UArenaBlock& block : state.mBlocks) {
+            std::free(block.mData);
+        }
+
+        state.mBlocks.clear();
+
+        uint8_t* data = static_cast<uint8_t*>(std::malloc(capacity));
+        if (data != nullptr) {
+            state.mBlocks.push_back({ data, capacity });
+            state.mHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    state.mBlockOffset = 0;
+    state.mFullBytes = 0;
+    state.mPeakBytes = 0;
+    state.mRetainedBytes = GetArenaCapacity(state) + state.mRecycledBytes;
+
+    state.mMutex.unlock();
+}
+
+UNavAllocator::UNavAllocStats UNavAllocator::GetStats() {
+    std::lock_guard<std::mutex> lock(mRegistryMutex);
+
+    UNavAllocStats stats = mExitedStats;
+    for (const UThreadState* state : mThreads) {
+        stats.mAllocations += state->mAllocations;
+        stats.mHeapAllocations += state->mHeapAllocations;
+        stats.mArenaAllocations += state->mArenaAllocations;
+        stats.mRecycledAllocations += state->mRecycledAllocations;
+        stats.mPeakArenaBytes = std::max(stats.mPeakArenaBytes, state->mPeakArenaBytes.load());
+        stats.mRetainedBytes += state->mRetainedBytes;
+    }
+
+    return stats;
+}
+
+void UNavAllocator::ResetPeak() {
+    std::lock_guard<std::mutex> lock(mRegistryMutex);
+
+    mExitedStats.mPeakArenaBytes = 0;
+    for (UThreadState* state : mThreads) {
+        state->mPeakArenaBytes = 0;
+    }
+}
+
+void UNavAllocator::Trim() {
+    ZoneScoped;
+
+    std::lock_guard<std::mutex> lock(mRegistryMutex);
+
+    for (UThreadState* state : mThreads) {
+        std::unique_lock<std::mutex> stateLock(state->mMutex, std::try_to_lock);
+        if (stateLock.owns_lock()) {
+            ReleaseMemory(*state);
+        }
+    }
+}
@@ -0,0 +1,670 @@
+#include "nav/UNavBVH.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NAV_BVH_SSE 1
+#include <emmintrin.h>
+#endif
+
+constexpr uint32_t BVH_LEAF_SIZE = 4;
+constexpr uint32_t BVH_SAH_BINS = 12;
+
+// Past this depth nodes are split at the median, which bounds the tree depth (and so the traversal stack)
+// even on geometry where SAH keeps peeling off tiny slivers.
+constexpr uint32_t BVH_MEDIAN_SPLIT_DEPTH = 48;
+constexpr uint32_t BVH_MAX_STACK = 96;
+
+namespace {
+    struct UBounds {
+        glm::vec3 mMin = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 mMax = glm::vec3(std::numeric_limits<float>::lowest());
+
+        void Grow(const glm::vec3& p) { mMin = glm::min(mMin, p); mMax = glm::max(mMax, p); }
+        void Grow(const UBounds& b) { mMin = glm::min(mMin, b.mMin); mMax = glm::max(mMax, b.mMax); }
+
+        float GetHalfArea() const {
+            glm::vec3 e = mMax - mMin;
+            return e.x * e.y + e.y * e.z + e.z * e.x;
+        }
+    };
+
+    struct UBuildTriangle {
+        UBounds mBounds;
+        glm::vec3 mCentroid;
+    };
+
+    struct UBuildTask {
+        uint32_t mNode;
+        uint32_t mBegin;
+        uint32_t mEnd;
+        uint32_t mDepth;
+    };
+
+    // Entry distance of the ray into the node's box, or false if it misses within maxDistance.
+    bool IntersectBox(const UNav::UBVHNode& node, const glm::vec3& origin, const glm::vec3& invDir, float maxDistance, float& tNear) {
+        glm::vec3 t1 = (node.mMin - origin) * invDir;
+        glm::vec3 t2 = (node.mMax - origin) * invDir;
+
+        glm::vec3 tMin = glm::min(t1, t2);
+        glm::vec3 tMax = glm::max(t1, t2);
+
+        tNear = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+        float tFar = std::min(std::min(tMax.x, tMax.y), tMax.z);
+
+        return tNear <= tFar && tNear < maxDistance;
+    }
+
+    float GetDistanceSqToBox(const UNav::UBVHNode& node, const glm::vec3& point) {
+        glm::vec3 d = glm::max(glm::max(node.mMin - point, glm::vec3(0.0f)), point - node.mMax);
+        return glm::dot(d, d);
+    }
+
+    // Ericson, Real-Time Collision Detection 5.1.5.
+    glm::vec3 GetClosestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+        glm::vec3 ab = b - a;
+        glm::vec3 ac = c - a;
+        glm::vec3 ap = p - a;
+
+        float d1 = glm::dot(ab, ap);
+        float d2 = glm::dot(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f) {
+            return a;
+        }
+
+        glm::vec3 bp = p - b;
+        float d3 = glm::dot(ab, bp);
+        float d4 = glm::dot(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3) {
+            return b;
+        }
+
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+            return a + ab * (d1 / (d1 - d3));
+        }
+
+        glm::vec3 cp = p - c;
+        float d5 = glm::dot(ab, cp);
+        float d6 = glm::dot(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6) {
+            return c;
+        }
+
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+            return a + ac * (d2 / (d2 - d6));
+        }
+
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+            return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+        }
+
+        float denom = 1.0f / (va + vb + vc);
+        return a + ab * (vb * denom) + ac * (vc * denom);
+    }
+
+    glm::vec3 GetLane(const float (&v)[3][4], uint32_t lane) {
+        return glm::vec3(v[0][lane], v[1][lane], v[2][lane]);
+    }
+
+    // Moller-Trumbore against all four lanes. Returns the closest hit lane nearer than maxDistance, or -1.
+    int32_t IntersectPack(const UNav::UTrianglePack& pack, const glm::vec3& origin, const glm::vec3& dir, float maxDistance, float& tHit) {
+#ifdef NAV_BVH_SSE
+        const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+        const __m128 dx = _mm_set1_ps(dir.x), dy = _mm_set1_ps(dir.y), dz = _mm_set1_ps(dir.z);
+
+        const __m128 e1x = _mm_load_ps(pack.mE1[0]), e1y = _mm_load_ps(pack.mE1[1]), e1z = _mm_load_ps(pack.mE1[2]);
+        const __m128 e2x = _mm_load_ps(pack.mE2[0]), e2y = _mm_load_ps(pack.mE2[1]), e2z = _mm_load_ps(pack.mE2[2]);
+
+        // p = dir x e2
+        __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+        __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+        __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+
+        __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+
+        __m128 tx = _mm_sub_ps(ox, _mm_load_ps(pack.mV0[0]));
+        __m128 ty = _mm_sub_ps(oy, _mm_load_ps(pack.mV0[1]));
+        __m128 tz = _mm_sub_ps(oz, _mm_load_ps(pack.mV0[2]));
+
+        // q = t x e1
+        __m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+        __m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+        __m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+
+        __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+        __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), invDet);
+        __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), invDet);
+        __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+
+        const __m128 zero = _mm_setzero_ps();
+        __m128 absDet = _mm_andnot_ps(_mm_set1_ps(-0.0f), det);
+
+        __m128 mask = _mm_cmpgt_ps(absDet, _mm_set1_ps(1e-12f));
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+        mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(t, zero));
+        mask = _mm_and_ps(mask, _mm_cmplt_ps(t, _mm_set1_ps(maxDistance)));
+
+        int32_t hits = _mm_movemask_ps(mask);
+        if (hits == 0) {
+            return -1;
+        }
+
+        alignas(16) float distances[4];
+        _mm_store_ps(distances, t);
+#else
+        float distances[4];
+        int32_t hits = 0;
+
+        for (uint32_t lane = 0; lane < 4; lane++) {
+            glm::vec3 e1 = GetLane(pack.mE1, lane);
+            glm::vec3 e2 = GetLane(pack.mE2, lane);
+
+            glm::vec3 p = glm::cross(dir, e2);
+            float det = glm::dot(e1, p);
+            if (std::abs(det) <= 1e-12f) {
+                continue;
+            }
+
+            float invDet = 1.0f / det;
+            glm::vec3 s = origin - GetLane(pack.mV0, lane);
+            glm::vec3 q = glm::cross(s, e1);
+
+            float u = glm::dot(s, p) * invDet;
+            float v = glm::dot(dir, q) * invDet;
+            distances[lane] = glm::dot(e2, q) * invDet;
+
+            if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && distances[lane] >= 0.0f && distances[lane] < maxDistance) {
+                hits |= 1 << lane;
+            }
+        }
+
+        if (hits == 0) {
+            return -1;
+        }
+#endif
+
+        int32_t bestLane = -1;
+        for (int32_t lane = 0; lane < 4; lane++) {
+            if ((hits & (1 << lane)) && (bestLane < 0 || distances[lane] < distances[bestLane])) {
+                bestLane = lane;
+            }
+        }
+
+        tHit = distances[bestLane];
+        return bestLane;
+    }
+
+    // Bitmask of lanes whose triangle bounds overlap the box.
+    int32_t OverlapPack(const UNav::UTrianglePack& pack, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+#ifdef NAV_BVH_SSE
+        __m128 mask = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+        for (uint32_t axis = 0; axis < 3; axis++) {
+            __m128 v0 = _mm_load_ps(pack.mV0[axis]);
+            __m128 v1 = _mm_add_ps(v0, _mm_load_ps(pack.mE1[axis]));
+            __m128 v2 = _mm_add_ps(v0, _mm_load_ps(pack.mE2[axis]));
+
+            __m128 triMin = _mm_min_ps(v0, _mm_min_ps(v1, v2));
+            __m128 triMax = _mm_max_ps(v0, _mm_max_ps(v1, v2));
+
+            mask = _mm_and_ps(mask, _mm_cmple_ps(triMin, _mm_set1_ps(boxMax[axis])));
+            mask = _mm_and_ps(mask, _mm_cmpge_ps(triMax, _mm_set1_ps(boxMin[axis])));
+        }
+
+        return _mm_movemask_ps(mask);
+#else
+        int32_t hits = 0;
+
+        for (uint32_t lane = 0; lane < 4; lane++) {
+            glm::vec3 v0 = GetLane(pack.mV0, lane);
+            glm::vec3 v1 = v0 + GetLane(pack.mE1, lane);
+            glm::vec3 v2 = v0 + GetLane(pack.mE2, lane);
+
+            glm::vec3 triMin = glm::min(v0, glm::min(v1, v2));
+            glm::vec3 triMax = glm::max(v0, glm::max(v1, v2));
+
+            if (glm::all(glm::lessThanEqual(triMin, boxMax)) && glm::all(glm::greaterThanEqual(triMax, boxMin))) {
+                hits |= 1 << lane;
+            }
+        }
+
+        return hits;
+#endif
+    }
+}
+
+void UNav::UNavBVH::Build(const float* vertices, uint32_t vertexStride, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount) {
+    ZoneScoped;
+
+    mNodes.clear();
+    mPacks.clear();
+    mTriangleIds.clear();
+
+    uint32_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    auto getVertex = [&](uint32_t triangle, uint32_t corner) {
+        const float* v = vertices + size_t(indices[triangle * 3 + corner]) * vertexStride;
+        return glm::vec3(v[0], v[1], v[2]);
+    };
+
+    // Triangles with an index past the vertices are left out rather than read out of bounds; the ids of
+    // the rest stay their position in the index buffer.
+    std::vector<UBuildTriangle> triangles(triangleCount);
+    std::vector<uint32_t> order;
+    order.reserve(triangleCount);
+
+    for (uint32_t i = 0; i < triangleCount; i++) {
+        if (indices[i * 3 + 0] >= vertexCount || indices[i * 3 + 1] >= vertexCount || indices[i * 3 + 2] >= vertexCount) {
+            continue;
+        }
+
+        for (uint32_t corner = 0; corner < 3; corner++) {
+            triangles[i].mBounds.Grow(getVertex(i, corner));
+        }
+
+        triangles[i].mCentroid = (triangles[i].mBounds.mMin + triangles[i].mBounds.mMax) * 0.5f;
+        order.push_back(i);
+    }
+
+    if (order.empty()) {
+        return;
+    }
+
+    mNodes.reserve(order.size() / 2 + 1);
+    mNodes.emplace_back();
+
+    std::vector<UBuildTask> tasks;
+    tasks.push_back({ 0, 0, uint32_t(order.size()), 0 });
+
+    while (!tasks.empty()) {
+        UBuildTask task = tasks.back();
+        tasks.pop_back();
+
+        UBounds bounds;
+        UBounds centroidBounds;
+        for (uint32_t i = task.mBegin; i < task.mEnd; i++) {
+            bounds.Grow(triangles[order[i]].mBounds);
+            centroidBounds.Grow(triangles[order[i]].mCentroid);
+        }
+
+        mNodes[task.mNode].mMin = bounds.mMin;
+        mNodes[task.mNode].mMax = bounds.mMax;
+
+        uint32_t count = task.mEnd - task.mBegin;
+        if (count <= BVH_LEAF_SIZE) {
+            UTrianglePack pack = {};
+
+            for (uint32_t lane = 0; lane < count; lane++) {
+                uint32_t triangle = order[task.mBegin + lane];
+
+                glm::vec3 v0 = getVertex(triangle, 0);
+                glm::vec3 e1 = getVertex(triangle, 1) - v0;
+                glm::vec3 e2 = getVertex(triangle, 2) - v0;
+
+                for (uint32_t axis = 0; axis < 3; axis++) {
+                    pack.mV0[axis][lane] = v0[axis];
+                    pack.mE1[axis][lane] = e1[axis];
+                    pack.mE2[axis][lane] = e2[axis];
+                }
+            }
+
+            mNodes[task.mNode].mFirst = uint32_t(mPacks.size());
+            mNodes[task.mNode].mCount = count;
+
+            mPacks.push_back(pack);
+            for (uint32_t lane = 0; lane < BVH_LEAF_SIZE; lane++) {
+                mTriangleIds.push_back(lane < count ? order[task.mBegin + lane] : UINT32_MAX);
+            }
+
+            continue;
+        }
+
+        glm::vec3 centroidExtent = centroidBounds.mMax - centroidBounds.mMin;
+        uint32_t axis = centroidExtent.x > centroidExtent.y ? (centroidExtent.x > centroidExtent.z ? 0 : 2) : (centroidExtent.y > centroidExtent.z ? 1 : 2);
+
+        uint32_t mid = task.mBegin + count / 2;
+        bool bSplit = false;
+
+        if (centroidExtent[axis] > 0.0f && task.mDepth < BVH_MEDIAN_SPLIT_DEPTH) {
+            UBounds binBounds[BVH_SAH_BINS];
+            uint32_t binCounts[BVH_SAH_BINS] = {};
+
+            float binScale = float(BVH_SAH_BINS) * 0.9999f / centroidExtent[axis];
+            auto getBin = [&](uint32_t triangle) {
+                return std::min(uint32_t((triangles[triangle].mCentroid[axis] - centroidBounds.mMin[axis]) * binScale), BVH_SAH_BINS - 1);
+            };
+
+            for (uint32_t i = task.mBegin; i < task.mEnd; i++) {
+                uint32_t bin = getBin(order[i]);
+                binBounds[bin].Grow(triangles[order[i]].mBounds);
+                binCounts[bin]++;
+            }
+
+            // Cost of splitting after each bin, swept from both sides.
+            float leftCost[BVH_SAH_BINS - 1];
+            UBounds sweep;
+            uint32_t sweepCount = 0;
+            for (uint32_t i = 0; i < BVH_SAH_BINS - 1; i++) {
+                sweep.Grow(binBounds[i]);
+                sweepCount += binCounts[i];
+                leftCost[i] = sweepCount == 0 ? 0.0f : sweep.GetHalfArea() * float(sweepCount);
+            }
+
+            float bestCost = std::numeric_limits<float>::max();
+            uint32_t bestSplit = 0;
+
+            sweep = UBounds();
+            sweepCount = 0;
+            for (uint32_t i = BVH_SAH_BINS - 1; i > 0; i--) {
+                sweep.Grow(binBounds[i]);
+                sweepCount += binCounts[i];
+
+                float cost = leftCost[i - 1] + (sweepCount == 0 ? 0.0f : sweep.GetHalfArea() * float(sweepCount));
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestSplit = i;
+                }
+            }
+
+            uint32_t* midPtr = std::partition(order.data() + task.mBegin, order.data() + task.mEnd, [&](uint32_t triangle) { return getBin(triangle) < bestSplit; });
+            mid = uint32_t(midPtr - order.data());
+
+            bSplit = mid != task.mBegin && mid != task.mEnd;
+        }
+
+        if (!bSplit) {
+            mid = task.mBegin + count / 2;
+            std::nth_element(order.begin() + task.mBegin, order.begin() + mid, order.begin() + task.mEnd,
+                [&](uint32_t a, uint32_t b) { return triangles[a].mCentroid[axis] < triangles[b].mCentroid[axis]; });
+        }
+
+        uint32_t left = uint32_t(mNodes.size());
+        mNodes.emplace_back();
+        mNodes.emplace_back();
+
+        mNodes[task.mNode].mFirst = left;
+        mNodes[task.mNode].mCount = 0;
+
+        tasks.push_back({ left + 1, mid, task.mEnd, task.mDepth + 1 });
+        tasks.push_back({ left, task.mBegin, mid, task.mDepth + 1 });
+    }
+
+    mNodes.shrink_to_fit();
+    mPacks.shrink_to_fit();
+    mTriangleIds.shrink_to_fit();
+}
+
+bool UNav::UNavBVH::Raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDistance, URayHit& hit) const {
+    if (mNodes.empty()) {
+        return false;
+    }
+
+    glm::vec3 invDir = 1.0f / dir;
+
+    float bestDistance = maxDistance;
+    uint32_t bestPack = UINT32_MAX;
+    int32_t bestLane = -1;
+
+    uint32_t stack[BVH_MAX_STACK];
+    uint32_t stackSize = 0;
+
+    float tNear;
+    if (!IntersectBox(mNodes[0], origin, invDir, bestDistance, tNear)) {
+        return false;
+    }
+
+    stack[stackSize++] = 0;
+
+    while (stackSize != 0) {
+        const UBVHNode& node = mNodes[stack[--stackSize]];
+
+        if (node.IsLeaf()) {
+            float t;
+            int32_t lane = IntersectPack(mPacks[node.mFirst], origin, dir, bestDistance, t);
+
+            if (lane >= 0) {
+                bestDistance = t;
+                bestPack = node.mFirst;
+                bestLane = lane;
+            }
+
+            continue;
+        }
+
+        // Deserialize rejects trees deep enough for this; it's only a backstop against overflowing the stack.
+        if (stackSize + 2 > BVH_MAX_STACK) {
+            continue;
+        }
+
+        float tLeft, tRight;
+        bool bLeft = IntersectBox(mNodes[node.mFirst], origin, invDir, bestDistance, tLeft);
+        bool bRight = IntersectBox(mNodes[node.mFirst + 1], origin, invDir, bestDistance, tRight);
+
+        // Push the far child first so the near one is visited first and tightens bestDistance sooner.
+        if (bLeft && bRight) {
+            bool bLeftFirst = tLeft <= tRight;
+            stack[stackSize++] = bLeftFirst ? node.mFirst + 1 : node.mFirst;
+            stack[stackSize++] = bLeftFirst ? node.mFirst : node.mFirst + 1;
+        }
+        else if (bLeft) {
+            stack[stackSize++] = node.mFirst;
+        }
+        else if (bRight) {
+            stack[stackSize++] = node.mFirst + 1;
+        }
+    }
+
+    if (bestLane < 0) {
+        return false;
+    }
+
+    const UTrianglePack& pack = mPacks[bestPack];
+    glm::vec3 normal = glm::normalize(glm::cross(GetLane(pack.mE1, bestLane), GetLane(pack.mE2, bestLane)));
+
+    hit.mDistance = bestDistance;
+    hit.mTriangle = mTriangleIds[bestPack * BVH_LEAF_SIZE + bestLane];
+    hit.mPosition = origin + dir * bestDistance;
+    hit.mNormal = glm::dot(normal, dir) > 0.0f ? -normal : normal;
+
+    return true;
+}
+
+bool UNav::UNavBVH::FindClosestPoint(const glm::vec3& point, float maxDistance, UClosestHit& hit) const {
+    if (mNodes.empty()) {
+        return false;
+    }
+
+    float bestDistSq = maxDistance * maxDistance;
+    bool bFound = false;
+
+    uint32_t stack[BVH_MAX_STACK];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize != 0) {
+        const UBVHNode& node = mNodes[stack[--stackSize]];
+        if (GetDistanceSqToBox(node, point) > bestDistSq) {
+            continue;
+        }
+
+        if (node.IsLeaf()) {
+            const UTrianglePack& pack = mPacks[node.mFirst];
+
+            for (uint32_t lane = 0; lane < node.mCount; lane++) {
+                glm::vec3 v0 = GetLane(pack.mV0, lane);
+                glm::vec3 closest = GetClosestPointOnTriangle(point, v0, v0 + GetLane(pack.mE1, lane), v0 + GetLane(pack.mE2, lane));
+
+                float distSq = glm::dot(closest - point, closest - point);
+                if (distSq <= bestDistSq) {
+                    bestDistSq = distSq;
+                    bFound = true;
+
+                    hit.mPosition = closest;
+                    hit.mTriangle = mTriangleIds[node.mFirst * BVH_LEAF_SIZE + lane];
+                }
+            }
+
+            continue;
+        }
+
+        // Deserialize rejects trees deep enough for this; it's only a backstop against overflowing the stack.
+        if (stackSize + 2 > BVH_MAX_STACK) {
+            continue;
+        }
+
+        float distLeft = GetDistanceSqToBox(mNodes[node.mFirst], point);
+        float distRight = GetDistanceSqToBox(mNodes[node.mFirst + 1], point);
+
+        bool bLeftFirst = distLeft <= distRight;
+        stack[stackSize++] = bLeftFirst ? node.mFirst + 1 : node.mFirst;
+        stack[stackSize++] = bLeftFirst ? node.mFirst : node.mFirst + 1;
+    }
+
+    if (bFound) {
+        hit.mDistance = std::sqrt(bestDistSq);
+    }
+
+    return bFound;
+}
+
+void UNav::UNavBVH::QueryBox(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<uint32_t>& triangles) const {
+    if (mNodes.empty()) {
+        return;
+    }
+
+    uint32_t stack[BVH_MAX_STACK];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize != 0) {
+        const UBVHNode& node = mNodes[stack[--stackSize]];
+
+        if (glm::any(glm::greaterThan(node.mMin, boxMax)) || glm::any(glm::lessThan(node.mMax, boxMin))) {
+            continue;
+        }
+
+        if (node.IsLeaf()) {
+            int32_t hits = OverlapPack(mPacks[node.mFirst], boxMin, boxMax) & ((1 << node.mCount) - 1);
+
+            for (uint32_t lane = 0; lane < node.mCount; lane++) {
+                if (hits & (1 << lane)) {
+                    triangles.push_back(mTriangleIds[node.mFirst * BVH_LEAF_SIZE + lane]);
+                }
+            }
+
+            continue;
+        }
+
+        // Deserialize rejects trees deep enough for this; it's only a backstop against overflowing the stack.
+        if (stackSize + 2 > BVH_MAX_STACK) {
+            continue;
+        }
+
+        stack[stackSize++] = node.mFirst;
+        stack[stackSize++] = node.mFirst + 1;
+    }
+}
+
+size_t UNav::UNavBVH::GetMemoryUsage() const {
+    return mNodes.capacity() * sizeof(UBVHNode) + mPacks.capacity() * sizeof(UTrianglePack) + mTriangleIds.capacity() * sizeof(uint32_t);
+}
+
+size_t UNav::UNavBVH::GetSerializedSize() const {
+    return sizeof(uint32_t) * 2 + mNodes.size() * sizeof(UBVHNode) + mPacks.size() * sizeof(UTrianglePack) + mTriangleIds.size() * sizeof(uint32_t);
+}
+
+void UNav::UNavBVH::Serialize(uint8_t* dst) const {
+    uint32_t counts[2] = { uint32_t(mNodes.size()), uint32_t(mPacks.size()) };
+    std::memcpy(dst, counts, sizeof(counts));
+    dst += sizeof(counts);
+
+    std::memcpy(dst, mNodes.data(), mNodes.size() * sizeof(UBVHNode));
+    dst += mNodes.size() * sizeof(UBVHNode);
+
+    std::memcpy(dst, mPacks.data(), mPacks.size() * sizeof(UTrianglePack));
+    dst += mPacks.size() * sizeof(UTrianglePack);
+
+    std::memcpy(dst, mTriangleIds.data(), mTriangleIds.size() * sizeof(uint32_t));
+}
+
+bool UNav::UNavBVH::Deserialize(const uint8_t* src, size_t size) {
+    ZoneScoped;
+
+    mNodes.clear();
+    mPacks.clear();
+    mTriangleIds.clear();
+
+    uint32_t counts[2];
+    if (size < sizeof(counts)) {
+        return false;
+    }
+
+    std::memcpy(counts, src, sizeof(counts));
+    src += sizeof(counts);
+
+    size_t nodeCount = counts[0];
+    size_t packCount = counts[1];
+    if (size != sizeof(counts) + nodeCount * sizeof(UBVHNode) + packCount * (sizeof(UTrianglePack) + 4 * sizeof(uint32_t))) {
+        return false;
+    }
+
+    mNodes.resize(nodeCount);
+    std::memcpy(mNodes.data(), src, nodeCount * sizeof(UBVHNode));
+    src += nodeCount * sizeof(UBVHNode);
+
+    mPacks.resize(packCount);
+    std::memcpy(mPacks.data(), src, packCount * sizeof(UTrianglePack));
+    src += packCount * sizeof(UTrianglePack);
+
+    mTriangleIds.resize(packCount * 4);
+    std::memcpy(mTriangleIds.data(), src, packCount * 4 * sizeof(uint32_t));
+
+    // Walk the tree from the root: every node has to be reached exactly once, and no deeper than the
+    // traversal stack allows. Children always come after their parent, which also rules out cycles.
+    std::vector<uint8_t> visited(nodeCount, 0);
+    std::vector<std::pair<uint32_t, uint32_t>> pending;
+    if (nodeCount != 0) {
+        pending.push_back({ 0, 0 });
+    }
+
+    size_t visitedCount = 0;
+    bool bValid = true;
+
+    while (!pending.empty() && bValid) {
+        auto [i, depth] = pending.back();
+        pending.pop_back();
+
+        const UBVHNode& node = mNodes[i];
+        bValid = !visited[i] && depth < BVH_MAX_STACK &&
+            (node.IsLeaf() ? (node.mFirst < packCount && node.mCount <= 4) : (node.mFirst > i && size_t(node.mFirst) + 1 < nodeCount));
+
+        visited[i] = 1;
+        visitedCount++;
+
+        if (bValid && !node.IsLeaf()) {
+            pending.push_back({ node.mFirst, depth + 1 });
+            pending.push_back({ node.mFirst + 1, depth + 1 });
+        }
+    }
+
+    if (!bValid || visitedCount != nodeCount) {
+        mNodes.clear();
+        mPacks.clear();
+        mTriangleIds.clear();
+
+        return false;
+    }
+
+    return true;
+}
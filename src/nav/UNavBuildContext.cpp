@@ -0,0 +1,188 @@
+#include "nav/UNavBuildContext.hpp"
+#include "util/jobsystem.hpp"
+
+#include <algorithm>
+
+namespace {
+    struct UStageInfo {
+        rcTimerLabel mLabel;
+        const char* mName;
+        uint32_t mDepth;
+    };
+
+    // Every label, in the order the pipeline runs them. Tile stages sit under the tile's total; merging
+    // happens once per build, outside any tile.
+    const UStageInfo STAGES[] = {
+        { RC_TIMER_TOTAL, "Total", 0 },
+        { RC_TIMER_RASTERIZE_TRIANGLES, "Rasterize triangles", 1 },
+        { RC_TIMER_FILTER_LOW_OBSTACLES, "Filter low obstacles", 1 },
+        { RC_TIMER_FILTER_BORDER, "Filter ledges", 1 },
+        { RC_TIMER_FILTER_WALKABLE, "Filter low ceilings", 1 },
+        { RC_TIMER_BUILD_COMPACTHEIGHTFIELD, "Compact heightfield", 1 },
+        { RC_TIMER_ERODE_AREA, "Erode walkable area", 1 },
+        { RC_TIMER_MEDIAN_AREA, "Median area filter", 1 },
+        { RC_TIMER_MARK_BOX_AREA, "Mark box areas", 1 },
+        { RC_TIMER_MARK_CYLINDER_AREA, "Mark cylinder areas", 1 },
+        { RC_TIMER_MARK_CONVEXPOLY_AREA, "Mark convex areas", 1 },
+        { RC_TIMER_BUILD_DISTANCEFIELD, "Distance field", 1 },
+        { RC_TIMER_BUILD_DISTANCEFIELD_DIST, "Distances", 2 },
+        { RC_TIMER_BUILD_DISTANCEFIELD_BLUR, "Blur", 2 },
+        { RC_TIMER_BUILD_REGIONS, "Regions", 1 },
+        { RC_TIMER_BUILD_REGIONS_WATERSHED, "Watershed", 2 },
+        // Both run per level inside the watershed pass.
+        { RC_TIMER_BUILD_REGIONS_EXPAND, "Expand", 3 },
+        { RC_TIMER_BUILD_REGIONS_FLOOD, "Flood", 3 },
+        { RC_TIMER_BUILD_REGIONS_FILTER, "Filter regions", 2 },
+        { RC_TIMER_BUILD_LAYERS, "Layers", 1 },
+        { RC_TIMER_BUILD_CONTOURS, "Contours", 1 },
+        { RC_TIMER_BUILD_CONTOURS_TRACE, "Trace", 2 },
+        { RC_TIMER_BUILD_CONTOURS_SIMPLIFY, "Simplify", 2 },
+        { RC_TIMER_BUILD_POLYMESH, "Poly mesh", 1 },
+        { RC_TIMER_BUILD_POLYMESHDETAIL, "Detail mesh", 1 },
+        { RC_TIMER_MERGE_POLYMESH, "Merge poly meshes", 0 },
+        { RC_TIMER_MERGE_POLYMESHDETAIL, "Merge detail meshes", 0 },
+        { RC_TIMER_TEMP, "Other", 0 },
+    };
+
+    static_assert(sizeof(STAGES) / sizeof(STAGES[0]) == RC_MAX_TIMERS, "Every Recast timer label needs a stage");
+
+#ifdef TRACY_ENABLE
+    // Tracy keeps pointers to these for as long as it runs.
+    const ___tracy_source_location_data* GetZoneLocation(rcTimerLabel label) {
+        static const std::vector<___tracy_source_location_data> locations = [] {
+            std::vector<___tracy_source_location_data> result(RC_MAX_TIMERS);
+            for (const UStageInfo& stage : STAGES) {
+                result[stage.mLabel] = { stage.mName, "rcContext", __FILE__, uint32_t(__LINE__), 0 };
+            }
+
+            return result;
+        }();
+
+        return &locations[label];
+    }
+#endif
+}
+
+const char* UNav::GetTimerName(rcTimerLabel label) {
+    for (const UStageInfo& stage : STAGES) {
+        if (stage.mLabel == label) {
+            return stage.mName;
+        }
+    }
+
+    return "";
+}
+
+UNav::UNavBuildContext::UNavBuildContext() : rcContext(true), mOpenCount(0) {
+    doResetTimers();
+}
+
+UNav::UNavBuildContext::~UNavBuildContext() {
+    // Zones must close on the thread that opened them, which is this one for anything left running.
+    while (mOpenCount > 0) {
+        doStopTimer(mOpenTimers[mOpenCount - 1]);
+    }
+}
+
+void UNav::UNavBuildContext::doLog(const rcLogCategory category, const char* msg, const int len) {
+    if (category == RC_LOG_ERROR && mError.empty()) {
+        mError.assign(msg, size_t(len));
+    }
+}
+
+void UNav::UNavBuildContext::doResetTimers() {
+    std::fill(std::begin(mElapsedNs), std::end(mElapsedNs), 0);
+    std::fill(std::begin(mRunCounts), std::end(mRunCounts), 0);
+}
+
+void UNav::UNavBuildContext::doStartTimer(const rcTimerLabel label) {
+    // Recast never reenters a stage, so a label that's already running is just kept running.
+    if (std::find(mOpenTimers, mOpenTimers + mOpenCount, label) != mOpenTimers + mOpenCount) {
+        return;
+    }
+
+    mOpenTimers[mOpenCount++] = label;
+
+#ifdef TRACY_ENABLE
+    mZones[label] = ___tracy_emit_zone_begin(GetZoneLocation(label), 1);
+#endif
+
+    mStartTimes[label] = AUtil::GetTime();
+}
+
+void UNav::UNavBuildContext::doStopTimer(const rcTimerLabel label) {
+    Clock::time_point now = AUtil::GetTime();
+
+    rcTimerLabel* open = std::find(mOpenTimers, mOpenTimers + mOpenCount, label);
+    if (open == mOpenTimers + mOpenCount) {
+        return;
+    }
+
+    while (mOpenCount > int(open - mOpenTimers)) {
+        rcTimerLabel inner = mOpenTimers[--mOpenCount];
+
+#ifdef TRACY_ENABLE
+        ___tracy_emit_zone_end(mZones[inner]);
+#endif
+
+        mElapsedNs[inner] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - mStartTimes[inner]).count();
+        mRunCounts[inner]++;
+    }
+}
+
+int UNav::UNavBuildContext::doGetAccumulatedTime(const rcTimerLabel label) const {
+    return int(mElapsedNs[label] / 1000);
+}
+
+void UNav::UNavBuildContext::doParallelFor(const int count, const int grainSize, rcParallelForBody* body, void* userData) {
+    UJobSystem::ParallelFor(uint32_t(count), uint32_t(grainSize), [&](uint32_t begin, uint32_t end) {
+        body(userData, int(begin), int(end));
+    });
+}
+
+int UNav::UNavBuildContext::doGetThreadCount() const {
+    return int(UJobSystem::GetThreadCount()) + 1;
+}
+
+void UNav::UNavBuildProfiler::Add(const UNavBuildContext& context, bool bTile) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for (int i = 0; i < RC_MAX_TIMERS; i++) {
+        rcTimerLabel label = rcTimerLabel(i);
+        if (context.GetRunCount(label) == 0) {
+            continue;
+        }
+
+        double ms = context.GetStageMs(label);
+        mTotalMs[i] += ms;
+        mMaxMs[i] = std::max(mMaxMs[i], ms);
+        mTileCounts[i]++;
+    }
+
+    if (bTile) {
+        mTilesBuilt++;
+    }
+}
+
+UNav::UNavBuildProfile UNav::UNavBuildProfiler::GetProfile() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    UNavBuildProfile profile;
+    profile.mTilesBuilt = mTilesBuilt;
+
+    for (const UStageInfo& stage : STAGES) {
+        if (mTileCounts[stage.mLabel] == 0) {
+            continue;
+        }
+
+        UNavStageTime time;
+        time.mName = stage.mName;
+        time.mDepth = stage.mDepth;
+        time.mTotalMs = mTotalMs[stage.mLabel];
+        time.mMaxMs = mMaxMs[stage.mLabel];
+        time.mTileCount = mTileCounts[stage.mLabel];
+        profile.mStages.push_back(time);
+    }
+
+    return profile;
+}
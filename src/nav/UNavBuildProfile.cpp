@@ -0,0 +1,42 @@
+#include "nav/UNavBuildProfile.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+const UNav::UNavStageTime* UNav::UNavBuildProfile::FindTotal() const {
+    for (const UNavStageTime& stage : mStages) {
+        if (std::strcmp(stage.mName, "Total") == 0) {
+            return &stage;
+        }
+    }
+
+    return nullptr;
+}
+
+std::string UNav::UNavBuildProfile::ToJson() const {
+    // Stage names are fixed identifiers, so they don't need escaping.
+    std::stringstream json;
+    json << "{\n";
+    json << "  \"build_ms\": " << mBuildTimeMs << ",\n";
+    json << "  \"threads\": " << mThreadCount << ",\n";
+    json << "  \"tiles_built\": " << mTilesBuilt << ",\n";
+    json << "  \"stages\": [";
+
+    for (size_t i = 0; i < mStages.size(); i++) {
+        const UNavStageTime& stage = mStages[i];
+        json << (i == 0 ? "\n" : ",\n") << "    { \"name\": \"" << stage.mName << "\", \"depth\": " << stage.mDepth
+            << ", \"total_ms\": " << stage.mTotalMs << ", \"max_tile_ms\": " << stage.mMaxMs << ", \"tiles\": " << stage.mTileCount << " }";
+    }
+
+    json << (mStages.empty() ? "]\n" : "\n  ]\n") << "}\n";
+
+    return json.str();
+}
+
+bool UNav::UNavBuildProfile::WriteJson(const std::filesystem::path& path) const {
+    std::ofstream file(path);
+    file << ToJson();
+
+    return file.good();
+}
@@ -0,0 +1,492 @@
+#include "nav/UNavGenerator.hpp"
+#include "nav/UNavAllocator.hpp"
+#include "nav/UNavBuildContext.hpp"
+#include "nav/UNavTileCache.hpp"
+#include "application/ATime.hpp"
+#include "util/fileutil.hpp"
+#include "util/jobsystem.hpp"
+
+#include <Recast.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+// Columns in a single tile's heightfield. Past this the span pointers alone run to hundreds of MB.
+constexpr uint64_t NAV_GEN_MAX_TILE_COLUMNS = 16ull * 1024 * 1024;
+constexpr uint32_t NAV_GEN_MAX_TILES = 1024 * 1024;
+
+// Detour's limit, so the polygons stay usable by it.
+constexpr int NAV_GEN_MAX_VERTS_PER_POLY = 6;
+
+// Part of every tile hash; bump when BuildTile changes what it produces so cached tiles get rebuilt.
+constexpr uint32_t NAV_GEN_TILE_VERSION = 1;
+
+namespace {
+    struct UHeightfieldDeleter { void operator()(rcHeightfield* p) const { rcFreeHeightField(p); } };
+    struct UCompactHeightfieldDeleter { void operator()(rcCompactHeightfield* p) const { rcFreeCompactHeightfield(p); } };
+    struct UContourSetDeleter { void operator()(rcContourSet* p) const { rcFreeContourSet(p); } };
+    struct UPolyMeshDeleter { void operator()(rcPolyMesh* p) const { rcFreePolyMesh(p); } };
+    struct UPolyMeshDetailDeleter { void operator()(rcPolyMeshDetail* p) const { rcFreePolyMeshDetail(p); } };
+
+    struct UTileResult {
+        std::shared_ptr<UNav::UNavGenTile> mTile;
+        std::string mError;
+    };
+
+    // Converts the world-unit settings the way the Recast demo does.
+    rcConfig MakeConfig(const UNav::UNavGenSettings& settings) {
+        rcConfig config = {};
+
+        config.cs = settings.mCellSize;
+        config.ch = settings.mCellHeight;
+        config.walkableSlopeAngle = settings.mAgentMaxSlope;
+        config.walkableHeight = int(std::ceil(settings.mAgentHeight / config.ch));
+        config.walkableClimb = int(std::floor(settings.mAgentMaxClimb / config.ch));
+        config.walkableRadius = int(std::ceil(settings.mAgentRadius / config.cs));
+        config.maxEdgeLen = int(settings.mEdgeMaxLength / config.cs);
+        config.maxSimplificationError = settings.mEdgeMaxError;
+        config.minRegionArea = int(rcSqr(settings.mRegionMinSize));
+        config.mergeRegionArea = int(rcSqr(settings.mRegionMergeSize));
+        config.maxVertsPerPoly = int(settings.mVertsPerPoly);
+        config.detailSampleDist = settings.mDetailSampleDistance < 0.9f ? 0.0f : config.cs * settings.mDetailSampleDistance;
+        config.detailSampleMaxError = config.ch * settings.mDetailSampleMaxError;
+
+        // Enough for the erosion plus the neighbour checks along the edges, as in the Recast demo.
+        config.tileSize = int(std::max(settings.mTileSize, 16u));
+        config.borderSize = config.walkableRadius + 3;
+        config.width = config.tileSize + config.borderSize * 2;
+        config.height = config.tileSize + config.borderSize * 2;
+
+        return config;
+    }
+
+    // Everything a tile's output depends on: its triangles' positions and area ids, in order, and its config.
+    // The config only holds the settings and the tile's own bounds, so edits elsewhere leave the hash alone.
+    uint64_t HashTile(const UNav::UNavGenInput& input, const std::vector<int32_t>& triangles,
+        const std::vector<uint8_t>& areas, const rcConfig& config)
+    {
+        ZoneScopedN("Hash tile");
+
+        uint64_t hash = UFileUtil::Hash(&NAV_GEN_TILE_VERSION, sizeof(NAV_GEN_TILE_VERSION));
+        hash = UFileUtil::Hash(&config, sizeof(config), hash);
+
+        for (int32_t index : triangles) {
+            hash = UFileUtil::Hash(&input.mVertices[size_t(index) * 3], sizeof(float) * 3, hash);
+        }
+
+        return UFileUtil::Hash(areas.data(), areas.size(), hash);
+    }
+
+    // Builds one tile from the triangles overlapping it. An empty result (no polygons) isn't an error.
+    bool BuildTile(UNav::UNavBuildContext& context, const UNav::UNavGenInput& input, const std::vector<int32_t>& triangles,
+        const std::vector<uint8_t>& areas, const rcConfig& config, UTileResult& result)
+    {
+        ZoneScopedN("Build tile");
+        rcScopedTimer totalTimer(&context, RC_TIMER_TOTAL);
+
+        auto fail = [&](const char* what) {
+            result.mError = context.mError.empty() ? what : context.mError;
+            return false;
+        };
+
+        result.mTile = std::make_shared<UNav::UNavGenTile>();
+        UNav::UNavGenTile& tile = *result.mTile;
+
+        const int vertexCount = int(input.GetVertexCount());
+        const int triangleCount = int(triangles.size() / 3);
+
+        std::unique_ptr<rcHeightfield, UHeightfieldDeleter> solid(rcAllocHeightfield());
+        if (solid == nullptr || !rcCreateHeightfield(&context, *solid, config.width, config.height, config.bmin, config.bmax, config.cs, config.ch)) {
+            return fail("Couldn't create the heightfield");
+        }
+
+        {
+            ZoneScopedN("Rasterize");
+
+            if (!rcRasterizeTriangles(&context, input.mVertices.data(), vertexCount, triangles.data(), areas.data(),
+                triangleCount, *solid, config.walkableClimb))
+            {
+                return fail("Couldn't rasterize the triangles");
+            }
+        }
+
+        {
+            ZoneScopedN("Filter");
+
+            rcFilterLowHangingWalkableObstacles(&context, config.walkableClimb, *solid);
+            rcFilterLedgeSpans(&context, config.walkableHeight, config.walkableClimb, *solid);
+            rcFilterWalkableLowHeightSpans(&context, config.walkableHeight, *solid);
+        }
+
+        std::unique_ptr<rcCompactHeightfield, UCompactHeightfieldDeleter> chf(rcAllocCompactHeightfield());
+        {
+            ZoneScopedN("Compact heightfield");
+
+            if (chf == nullptr || !rcBuildCompactHeightfield(&context, config.walkableHeight, config.walkableClimb, *solid, *chf)) {
+                return fail("Couldn't build the compact heightfield");
+            }
+
+            // Everything from here on works off the compact heightfield.
+            solid.reset();
+
+            if (!rcErodeWalkableArea(&context, config.walkableRadius, *chf)) {
+                return fail("Couldn't erode the walkable area");
+            }
+        }
+
+        {
+            ZoneScopedN("Regions");
+
+            if (!rcBuildDistanceField(&context, *chf)) {
+                return fail("Couldn't build the distance field");
+            }
+
+            if (!rcBuildRegions(&context, *chf, config.borderSize, config.minRegionArea, config.mergeRegionArea)) {
+                return fail("Couldn't build regions");
+            }
+        }
+
+        std::unique_ptr<rcContourSet, UContourSetDeleter> contours(rcAllocContourSet());
+        {
+            ZoneScopedN("Contours");
+
+            if (contours == nullptr || !rcBuildContours(&context, *chf, config.maxSimplificationError, config.maxEdgeLen, *contours)) {
+                return fail("Couldn't build contours");
+            }
+        }
+
+        if (contours->nconts == 0) {
+            return true;
+        }
+
+        tile.mPolyMesh = rcAllocPolyMesh();
+        {
+            ZoneScopedN("Poly mesh");
+
+            if (tile.mPolyMesh == nullptr || !rcBuildPolyMesh(&context, *contours, config.maxVertsPerPoly, *tile.mPolyMesh)) {
+                return fail("Couldn't build the poly mesh");
+            }
+        }
+
+        if (tile.mPolyMesh->npolys == 0) {
+            rcFreePolyMesh(tile.mPolyMesh);
+            tile.mPolyMesh = nullptr;
+            return true;
+        }
+
+        tile.mDetailMesh = rcAllocPolyMeshDetail();
+        {
+            ZoneScopedN("Detail mesh");
+
+            if (tile.mDetailMesh == nullptr ||
+                !rcBuildPolyMeshDetail(&context, *tile.mPolyMesh, *chf, config.detailSampleDist, config.detailSampleMaxError, *tile.mDetailMesh))
+            {
+                return fail("Couldn't build the detail mesh");
+            }
+        }
+
+        return true;
+    }
+}
+
+float UNav::UNavGenProgress::GetFraction() const {
+    switch (mStage.load()) {
+        case ENavGenStage::Partition: return 0.0f;
+        case ENavGenStage::BuildTiles: return 0.95f * float(mTilesDone.load()) / float(std::max(mTileCount.load(), 1u));
+        case ENavGenStage::Merge: return 0.95f;
+        default: return 1.0f;
+    }
+}
+
+const char* UNav::GetStageName(ENavGenStage stage) {
+    switch (stage) {
+        case ENavGenStage::Partition: return "Partitioning";
+        case ENavGenStage::BuildTiles: return "Building tiles";
+        case ENavGenStage::Merge: return "Merging tiles";
+        case ENavGenStage::Done: return "Done";
+        default: return "";
+    }
+}
+
+bool UNav::GenerateNavmesh(const UNavGenInput& input, const UNavGenSettings& settings, UNavGenProgress& progress, UNavGenResult& result,
+    UNavTileCache* cache)
+{
+    ZoneScoped;
+
+    Clock::time_point start = AUtil::GetTime();
+    result = UNavGenResult();
+
+    UNavAllocator::Install();
+    UNavAllocator::ResetPeak();
+    const UNavAllocator::UNavAllocStats startStats = UNavAllocator::GetStats();
+
+    UNavBuildContext context;
+    UNavBuildProfiler profiler;
+    const rcConfig baseConfig = MakeConfig(settings);
+
+    auto fail = [&](const std::string& what) {
+        result.mError = context.mError.empty() ? what : context.mError;
+        return false;
+    };
+
+    auto checkCancelled = [&]() {
+        if (progress.bCancelled) {
+            result.bCancelled = true;
+            result.mError = "Cancelled";
+        }
+
+        return result.bCancelled;
+    };
+
+    if (input.IsEmpty()) {
+        return fail("Nothing to build from");
+    }
+
+    if (baseConfig.maxVertsPerPoly < 3 || baseConfig.maxVertsPerPoly > NAV_GEN_MAX_VERTS_PER_POLY) {
+        return fail("Vertices per polygon must be between 3 and 6");
+    }
+
+    if (uint64_t(baseConfig.width) * uint64_t(baseConfig.height) > NAV_GEN_MAX_TILE_COLUMNS) {
+        return fail("Tile size is too large");
+    }
+
+    progress.mStage = ENavGenStage::Partition;
+
+    float boundsMin[3], boundsMax[3];
+    rcCalcBounds(input.mVertices.data(), int(input.GetVertexCount()), boundsMin, boundsMax);
+
+    const float tileWorldSize = float(baseConfig.tileSize) * baseConfig.cs;
+    const float borderWorldSize = float(baseConfig.borderSize) * baseConfig.cs;
+
+    // The grid sits on world multiples of the tile size rather than on the input's bounds, so growing the
+    // input doesn't shift every tile and change all their hashes.
+    const double firstTileX = std::floor(double(boundsMin[0]) / tileWorldSize);
+    const double firstTileZ = std::floor(double(boundsMin[2]) / tileWorldSize);
+    const double tilesXWide = std::floor(double(boundsMax[0]) / tileWorldSize) - firstTileX + 1.0;
+    const double tilesZWide = std::floor(double(boundsMax[2]) / tileWorldSize) - firstTileZ + 1.0;
+
+    if (tilesXWide * tilesZWide > double(NAV_GEN_MAX_TILES) || std::abs(firstTileX) > double(INT32_MAX / 2) || std::abs(firstTileZ) > double(INT32_MAX / 2)) {
+        return fail("Area is too large for the cell and tile size");
+    }
+
+    const int32_t tileOriginX = int32_t(firstTileX);
+    const int32_t tileOriginZ = int32_t(firstTileZ);
+    const uint32_t tilesX = uint32_t(tilesXWide);
+    const uint32_t tilesZ = uint32_t(tilesZWide);
+    const uint32_t tileCount = tilesX * tilesZ;
+
+    // Each tile gets every triangle that touches it or its border, in input order.
+    std::vector<std::vector<int32_t>> tileTriangles(tileCount);
+    {
+        ZoneScopedN("Partition triangles");
+
+        for (uint32_t t = 0; t < input.GetTriangleCount(); t++) {
+            const int32_t* tri = &input.mIndices[size_t(t) * 3];
+
+            float minX = std::numeric_limits<float>::max(), maxX = std::numeric_limits<float>::lowest();
+            float minZ = std::numeric_limits<float>::max(), maxZ = std::numeric_limits<float>::lowest();
+            for (uint32_t k = 0; k < 3; k++) {
+                const float* v = &input.mVertices[size_t(tri[k]) * 3];
+                minX = std::min(minX, v[0]);
+                maxX = std::max(maxX, v[0]);
+                minZ = std::min(minZ, v[2]);
+                maxZ = std::max(maxZ, v[2]);
+            }
+
+            int32_t x0 = std::max(int32_t(std::floor((minX - borderWorldSize) / tileWorldSize)) - tileOriginX, 0);
+            int32_t x1 = std::min(int32_t(std::floor((maxX + borderWorldSize) / tileWorldSize)) - tileOriginX, int32_t(tilesX) - 1);
+            int32_t z0 = std::max(int32_t(std::floor((minZ - borderWorldSize) / tileWorldSize)) - tileOriginZ, 0);
+            int32_t z1 = std::min(int32_t(std::floor((maxZ + borderWorldSize) / tileWorldSize)) - tileOriginZ, int32_t(tilesZ) - 1);
+
+            for (int32_t z = z0; z <= z1; z++) {
+                for (int32_t x = x0; x <= x1; x++) {
+                    tileTriangles[size_t(z) * tilesX + x].insert(tileTriangles[size_t(z) * tilesX + x].end(), tri, tri + 3);
+                }
+            }
+        }
+    }
+
+    if (checkCancelled()) {
+        return false;
+    }
+
+    progress.mTileCount = tileCount;
+    progress.mTilesDone = 0;
+    progress.mStage = ENavGenStage::BuildTiles;
+
+    // Tiles only ever write their own slot, and merging walks the slots in order, so neither the
+    // thread count nor the order tiles finish in can change the output.
+    std::vector<UTileResult> tiles(tileCount);
+
+    std::atomic<uint32_t> tilesBuilt = 0, tilesReused = 0, tilesFromDisk = 0;
+
+    if (cache != nullptr) {
+        cache->BeginBuild();
+    }
+
+    UJobSystem::ParallelFor(tileCount, 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+            if (progress.bCancelled) {
+                return;
+            }
+
+            if (!tileTriangles[i].empty()) {
+                rcConfig config = baseConfig;
+
+                int32_t tileX = tileOriginX + int32_t(i % tilesX);
+                int32_t tileZ = tileOriginZ + int32_t(i / tilesX);
+
+                // Heights come from the tile's own triangles, snapped to whole cells so the tiles' poly
+                // meshes still merge.
+                float minY = std::numeric_limits<float>::max(), maxY = std::numeric_limits<float>::lowest();
+                for (int32_t index : tileTriangles[i]) {
+                    minY = std::min(minY, input.mVertices[size_t(index) * 3 + 1]);
+                    maxY = std::max(maxY, input.mVertices[size_t(index) * 3 + 1]);
+                }
+
+                config.bmin[0] = float(tileX) * tileWorldSize - borderWorldSize;
+                config.bmin[1] = std::floor(minY / config.ch) * config.ch;
+                config.bmin[2] = float(tileZ) * tileWorldSize - borderWorldSize;
+                config.bmax[0] = float(tileX + 1) * tileWorldSize + borderWorldSize;
+                config.bmax[1] = (std::ceil(maxY / config.ch) + 1.0f) * config.ch;
+                config.bmax[2] = float(tileZ + 1) * tileWorldSize + borderWorldSize;
+
+                // Its own context, so recorded errors don't depend on which tiles shared a thread.
+                UNavBuildContext tileContext;
+                tileContext.enableParallel(settings.bParallelSteps);
+                UNavAllocator::UTileScope allocScope;
+
+                std::vector<uint8_t> areas(tileTriangles[i].size() / 3, 0);
+                rcMarkWalkableTriangles(&tileContext, config.walkableSlopeAngle, input.mVertices.data(), int(input.GetVertexCount()),
+                    tileTriangles[i].data(), int(areas.size()), areas.data());
+
+                uint64_t hash = 0;
+                bool bFromDisk = false;
+
+                if (cache != nullptr) {
+                    hash = HashTile(input, tileTriangles[i], areas, config);
+                    tiles[i].mTile = cache->Find(hash, bFromDisk);
+                }
+
+                if (tiles[i].mTile != nullptr) {
+                    (bFromDisk ? tilesFromDisk : tilesReused)++;
+                }
+                else {
+                    // Failed tiles aren't cached, so they're retried next time.
+                    if (BuildTile(tileContext, input, tileTriangles[i], areas, config, tiles[i]) && cache != nullptr) {
+                        cache->Store(hash, tiles[i].mTile);
+                    }
+
+                    profiler.Add(tileContext);
+                    tilesBuilt++;
+                }
+
+                tileTriangles[i] = std::vector<int32_t>();
+            }
+
+            progress.mTilesDone++;
+        }
+    });
+
+    if (cache != nullptr) {
+        cache->EndBuild();
+    }
+
+    // Whatever the workers kept for the next tile isn't needed until the next build.
+    const UNavAllocator::UNavAllocStats tileStats = UNavAllocator::GetStats();
+    UNavAllocator::Trim();
+
+    result.mAllocations = tileStats.mAllocations - startStats.mAllocations;
+    result.mHeapAllocations = tileStats.mHeapAllocations - startStats.mHeapAllocations;
+    result.mPeakArenaBytes = tileStats.mPeakArenaBytes;
+
+    result.mTilesBuilt = tilesBuilt;
+    result.mTilesReused = tilesReused;
+    result.mTilesFromDisk = tilesFromDisk;
+
+    if (checkCancelled()) {
+        return false;
+    }
+
+    progress.mStage = ENavGenStage::Merge;
+
+    std::vector<rcPolyMesh*> polyMeshes;
+    std::vector<rcPolyMeshDetail*> detailMeshes;
+
+    for (uint32_t i = 0; i < tileCount; i++) {
+        if (!tiles[i].mError.empty()) {
+            char tileName[32];
+            snprintf(tileName, sizeof(tileName), "Tile %d, %d: ", tileOriginX + int32_t(i % tilesX), tileOriginZ + int32_t(i / tilesX));
+
+            return fail(tileName + tiles[i].mError);
+        }
+
+        const UNavGenTile* tile = tiles[i].mTile.get();
+        if (tile != nullptr && !tile->IsEmpty()) {
+            polyMeshes.push_back(tile->mPolyMesh);
+            detailMeshes.push_back(tile->mDetailMesh);
+            result.mPolyCount += uint32_t(tile->mPolyMesh->npolys);
+        }
+    }
+
+    if (polyMeshes.empty()) {
+        return fail("No walkable area found");
+    }
+
+    std::unique_ptr<rcPolyMeshDetail, UPolyMeshDetailDeleter> detailMesh(rcAllocPolyMeshDetail());
+    {
+        ZoneScopedN("Merge detail meshes");
+
+        if (detailMesh == nullptr || !rcMergePolyMeshDetails(&context, detailMeshes.data(), int(detailMeshes.size()), *detailMesh)) {
+            return fail("Couldn't merge the detail meshes");
+        }
+    }
+
+    {
+        ZoneScopedN("Merge poly meshes");
+
+        // Polygon vertices are 16-bit, so big enough builds can't be merged into one poly mesh. The
+        // detail triangles don't have that limit and are all the preview needs.
+        UNavBuildContext mergeContext;
+        std::shared_ptr<rcPolyMesh> polyMesh(rcAllocPolyMesh(), UPolyMeshDeleter());
+        if (polyMesh != nullptr && rcMergePolyMeshes(&mergeContext, polyMeshes.data(), int(polyMeshes.size()), *polyMesh)) {
+            result.mPolyMesh = polyMesh;
+        }
+
+        profiler.Add(mergeContext, false);
+    }
+
+    // Detail triangles index into their own polygon's slice of the vertex array.
+    result.mVertices.assign(detailMesh->verts, detailMesh->verts + size_t(detailMesh->nverts) * 3);
+    result.mIndices.reserve(size_t(detailMesh->ntris) * 3);
+
+    for (int i = 0; i < detailMesh->nmeshes; i++) {
+        const uint32_t* subMesh = &detailMesh->meshes[i * 4];
+        uint32_t baseVertex = subMesh[0];
+        uint32_t baseTriangle = subMesh[2];
+        uint32_t triangleCount = subMesh[3];
+
+        for (uint32_t t = 0; t < triangleCount; t++) {
+            const uint8_t* tri = &detailMesh->tris[(baseTriangle + t) * 4];
+
+            result.mIndices.push_back(baseVertex + tri[0]);
+            result.mIndices.push_back(baseVertex + tri[1]);
+            result.mIndices.push_back(baseVertex + tri[2]);
+        }
+    }
+
+    result.mTileCount = tileCount;
+    result.mBuildTimeMs = AUtil::GetDeltaTime(start, AUtil::GetTime()) * 1000.0f;
+    result.bSucceeded = true;
+
+    profiler.Add(context, false);
+    result.mProfile = profiler.GetProfile();
+    result.mProfile.mBuildTimeMs = result.mBuildTimeMs;
+    result.mProfile.mThreadCount = UJobSystem::GetThreadCount() + 1;
+
+    progress.mStage = ENavGenStage::Done;
+
+    return true;
+}
@@ -0,0 +1,393 @@
+#include "nav/UNavTileCache.hpp"
+#include "util/mappedfile.hpp"
+
+#include <Recast.h>
+#include <RecastAlloc.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace {
+    constexpr uint32_t TILE_MAGIC = 0x4C495455; // "UTIL"
+    // Detour's limit, which the generator enforces too.
+    constexpr int32_t MAX_VERTS_PER_POLY = 6;
+
+    struct UTileHeader {
+        uint32_t mMagic;
+        uint32_t mVersion;
+        uint64_t mHash;
+
+        // Zero for an empty tile, in which case nothing follows the header.
+        int32_t mPolyCount;
+        int32_t mPolyVertexCount;
+        int32_t mVertsPerPoly;
+        int32_t mBorderSize;
+        float mBoundsMin[3];
+        float mBoundsMax[3];
+        float mCellSize;
+        float mCellHeight;
+        float mMaxEdgeError;
+
+        int32_t mDetailMeshCount;
+        int32_t mDetailVertexCount;
+        int32_t mDetailTriangleCount;
+    };
+
+    // Sizes of the arrays that follow the header, in file order.
+    struct UTileLayout {
+        size_t mVerts, mPolys, mRegs, mFlags, mAreas;
+        size_t mDetailMeshes, mDetailVerts, mDetailTris;
+
+        explicit UTileLayout(const UTileHeader& h) :
+            mVerts(size_t(h.mPolyVertexCount) * 3 * sizeof(uint16_t)),
+            mPolys(size_t(h.mPolyCount) * 2 * h.mVertsPerPoly * sizeof(uint16_t)),
+            mRegs(size_t(h.mPolyCount) * sizeof(uint16_t)),
+            mFlags(size_t(h.mPolyCount) * sizeof(uint16_t)),
+            mAreas(size_t(h.mPolyCount)),
+            mDetailMeshes(size_t(h.mDetailMeshCount) * 4 * sizeof(uint32_t)),
+            mDetailVerts(size_t(h.mDetailVertexCount) * 3 * sizeof(float)),
+            mDetailTris(size_t(h.mDetailTriangleCount) * 4)
+        {}
+
+        size_t GetTotal() const { return mVerts + mPolys + mRegs + mFlags + mAreas + mDetailMeshes + mDetailVerts + mDetailTris; }
+    };
+
+    // Allocates through Recast so rcFreePolyMesh and friends can free it.
+    template<typename T>
+    T* ReadArray(const uint8_t*& src, size_t size) {
+        T* dst = static_cast<T*>(rcAlloc(std::max(size, size_t(1)), RC_ALLOC_PERM));
+        if (dst != nullptr) {
+            std::memcpy(dst, src, size);
+        }
+
+        src += size;
+        return dst;
+    }
+
+    // Everything the merge and the triangle flattening index with has to stay in range, since a corrupt
+    // file would otherwise have them read out of bounds.
+    bool IsValid(const rcPolyMesh& poly, const rcPolyMeshDetail& detail) {
+        for (int i = 0; i < poly.npolys; i++) {
+            const uint16_t* p = &poly.polys[size_t(i) * 2 * poly.nvp];
+
+            for (int j = 0; j < poly.nvp; j++) {
+                bool bUsed = p[j] != RC_MESH_NULL_IDX;
+                if ((bUsed && p[j] >= poly.nverts) || (!bUsed && j < 3)) {
+                    return false;
+                }
+
+                // Another polygon, a tile edge (0x8000 | side) or nothing.
+                uint16_t neighbour = p[poly.nvp + j];
+                if (neighbour != RC_MESH_NULL_IDX && (neighbour & 0x8000 ? (neighbour & 0x7fff) > 3 : neighbour >= poly.npolys)) {
+                    return false;
+                }
+            }
+        }
+
+        for (int i = 0; i < detail.nmeshes; i++) {
+            const uint32_t* subMesh = &detail.meshes[size_t(i) * 4];
+            uint32_t baseVertex = subMesh[0], vertexCount = subMesh[1];
+            uint32_t baseTriangle = subMesh[2], triangleCount = subMesh[3];
+
+            if (uint64_t(baseVertex) + vertexCount > uint64_t(detail.nverts) || uint64_t(baseTriangle) + triangleCount > uint64_t(detail.ntris)) {
+                return false;
+            }
+
+            for (uint32_t t = baseTriangle; t < baseTriangle + triangleCount; t++) {
+                const uint8_t* tri = &detail.tris[size_t(t) * 4];
+                if (tri[0] >= vertexCount || tri[1] >= vertexCount || tri[2] >= vertexCount) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+}
+
+UNav::UNavGenTile::~UNavGenTile() {
+    rcFreePolyMesh(mPolyMesh);
+    rcFreePolyMeshDetail(mDetailMesh);
+}
+
+UNav::UNavTileCache::UNavTileCache(std::filesystem::path directory) : mDirectory(directory) {
+
+}
+
+void UNav::UNavTileCache::BeginBuild() {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mPreviousTiles = std::move(mTiles);
+    mTiles.clear();
+}
+
+void UNav::UNavTileCache::EndBuild() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPreviousTiles.clear();
+    }
+
+    Prune();
+}
+
+std::shared_ptr<UNav::UNavGenTile> UNav::UNavTileCache::Find(uint64_t hash, bool& bFromDisk) {
+    bFromDisk = false;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        auto it = mTiles.find(hash);
+        if (it != mTiles.end()) {
+            return it->second;
+        }
+
+        it = mPreviousTiles.find(hash);
+        if (it != mPreviousTiles.end()) {
+            std::shared_ptr<UNavGenTile> tile = it->second;
+            mTiles[hash] = tile;
+
+            return tile;
+        }
+    }
+
+    std::shared_ptr<UNavGenTile> tile = Load(hash);
+    if (tile == nullptr) {
+        return nullptr;
+    }
+
+    bFromDisk = true;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mTiles[hash] = tile;
+
+    return tile;
+}
+
+void UNav::UNavTileCache::Store(uint64_t hash, const std::shared_ptr<UNavGenTile>& tile) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTiles[hash] = tile;
+    }
+
+    Save(hash, *tile);
+}
+
+void UNav::UNavTileCache::Clear() {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mTiles.clear();
+    mPreviousTiles.clear();
+}
+
+uint32_t UNav::UNavTileCache::GetTileCount() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return uint32_t(mTiles.size());
+}
+
+std::filesystem::path UNav::UNavTileCache::GetTilePath(uint64_t hash) const {
+    char fileName[32];
+    snprintf(fileName, sizeof(fileName), "%016llx.tile", (unsigned long long)hash);
+
+    return mDirectory / fileName;
+}
+
+bool UNav::UNavTileCache::Save(uint64_t hash, const UNavGenTile& tile) const {
+    ZoneScoped;
+
+    if (mDirectory.empty()) {
+        return false;
+    }
+
+    UTileHeader header = {};
+    header.mMagic = TILE_MAGIC;
+    header.mVersion = VERSION;
+    header.mHash = hash;
+
+    const rcPolyMesh* poly = tile.mPolyMesh;
+    const rcPolyMeshDetail* detail = tile.mDetailMesh;
+
+    if (poly != nullptr && detail != nullptr) {
+        header.mPolyCount = poly->npolys;
+        header.mPolyVertexCount = poly->nverts;
+        header.mVertsPerPoly = poly->nvp;
+        header.mBorderSize = poly->borderSize;
+        std::memcpy(header.mBoundsMin, poly->bmin, sizeof(header.mBoundsMin));
+        std::memcpy(header.mBoundsMax, poly->bmax, sizeof(header.mBoundsMax));
+        header.mCellSize = poly->cs;
+        header.mCellHeight = poly->ch;
+        header.mMaxEdgeError = poly->maxEdgeError;
+
+        header.mDetailMeshCount = detail->nmeshes;
+        header.mDetailVertexCount = detail->nverts;
+        header.mDetailTriangleCount = detail->ntris;
+    }
+
+    UTileLayout layout(header);
+
+    // Written alongside and renamed into place, so a reader never sees a partial tile.
+    std::filesystem::path path = GetTilePath(hash);
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        if (header.mPolyCount != 0) {
+            file.write(reinterpret_cast<const char*>(poly->verts), layout.mVerts);
+            file.write(reinterpret_cast<const char*>(poly->polys), layout.mPolys);
+            file.write(reinterpret_cast<const char*>(poly->regs), layout.mRegs);
+            file.write(reinterpret_cast<const char*>(poly->flags), layout.mFlags);
+            file.write(reinterpret_cast<const char*>(poly->areas), layout.mAreas);
+            file.write(reinterpret_cast<const char*>(detail->meshes), layout.mDetailMeshes);
+            file.write(reinterpret_cast<const char*>(detail->verts), layout.mDetailVerts);
+            file.write(reinterpret_cast<const char*>(detail->tris), layout.mDetailTris);
+        }
+
+        if (!file) {
+            file.close();
+
+            std::error_code error;
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    return true;
+}
+
+std::shared_ptr<UNav::UNavGenTile> UNav::UNavTileCache::Load(uint64_t hash) const {
+    ZoneScoped;
+
+    if (mDirectory.empty()) {
+        return nullptr;
+    }
+
+    UMappedFile file;
+    if (!file.Open(GetTilePath(hash)) || file.GetSize() < sizeof(UTileHeader)) {
+        return nullptr;
+    }
+
+    UTileHeader header;
+    std::memcpy(&header, file.GetData(), sizeof(header));
+
+    if (header.mMagic != TILE_MAGIC || header.mVersion != VERSION || header.mHash != hash ||
+        header.mPolyCount < 0 || header.mPolyVertexCount < 0 || header.mPolyVertexCount > RC_MESH_NULL_IDX ||
+        (header.mPolyCount != 0 && (header.mVertsPerPoly < 3 || header.mVertsPerPoly > MAX_VERTS_PER_POLY)) ||
+        header.mDetailMeshCount != header.mPolyCount || header.mDetailVertexCount < 0 || header.mDetailTriangleCount < 0 ||
+        file.GetSize() != sizeof(header) + UTileLayout(header).GetTotal())
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<UNavGenTile> tile = std::make_shared<UNavGenTile>();
+    if (header.mPolyCount == 0) {
+        return tile;
+    }
+
+    UTileLayout layout(header);
+    const uint8_t* src = file.GetData() + sizeof(header);
+
+    tile->mPolyMesh = rcAllocPolyMesh();
+    tile->mDetailMesh = rcAllocPolyMeshDetail();
+    if (tile->mPolyMesh == nullptr || tile->mDetailMesh == nullptr) {
+        return nullptr;
+    }
+
+    rcPolyMesh& poly = *tile->mPolyMesh;
+    poly.verts = ReadArray<uint16_t>(src, layout.mVerts);
+    poly.polys = ReadArray<uint16_t>(src, layout.mPolys);
+    poly.regs = ReadArray<uint16_t>(src, layout.mRegs);
+    poly.flags = ReadArray<uint16_t>(src, layout.mFlags);
+    poly.areas = ReadArray<uint8_t>(src, layout.mAreas);
+    poly.nverts = header.mPolyVertexCount;
+    poly.npolys = header.mPolyCount;
+    poly.maxpolys = header.mPolyCount;
+    poly.nvp = header.mVertsPerPoly;
+    std::memcpy(poly.bmin, header.mBoundsMin, sizeof(poly.bmin));
+    std::memcpy(poly.bmax, header.mBoundsMax, sizeof(poly.bmax));
+    poly.cs = header.mCellSize;
+    poly.ch = header.mCellHeight;
+    poly.borderSize = header.mBorderSize;
+    poly.maxEdgeError = header.mMaxEdgeError;
+
+    rcPolyMeshDetail& detail = *tile->mDetailMesh;
+    detail.meshes = ReadArray<uint32_t>(src, layout.mDetailMeshes);
+    detail.verts = ReadArray<float>(src, layout.mDetailVerts);
+    detail.tris = ReadArray<uint8_t>(src, layout.mDetailTris);
+    detail.nmeshes = header.mDetailMeshCount;
+    detail.nverts = header.mDetailVertexCount;
+    detail.ntris = header.mDetailTriangleCount;
+
+    if (poly.verts == nullptr || poly.polys == nullptr || poly.regs == nullptr || poly.flags == nullptr || poly.areas == nullptr ||
+        detail.meshes == nullptr || detail.verts == nullptr || detail.tris == nullptr || !IsValid(poly, detail))
+    {
+        return nullptr;
+    }
+
+    // Reading a tile counts as using it, so Prune drops the ones that haven't been needed for longest.
+    std::error_code error;
+    std::filesystem::last_write_time(GetTilePath(hash), std::filesystem::file_time_type::clock::now(), error);
+
+    return tile;
+}
+
+void UNav::UNavTileCache::Prune() const {
+    ZoneScoped;
+
+    if (mDirectory.empty()) {
+        return;
+    }
+
+    struct UTileFile {
+        std::filesystem::path mPath;
+        std::filesystem::file_time_type mTime;
+        uintmax_t mSize;
+    };
+
+    std::vector<UTileFile> files;
+    uintmax_t totalSize = 0;
+
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(mDirectory, error)) {
+        if (!entry.is_regular_file(error) || entry.path().extension() != ".tile") {
+            continue;
+        }
+
+        UTileFile file = { entry.path(), entry.last_write_time(error), entry.file_size(error) };
+        if (!error) {
+            files.push_back(file);
+            totalSize += file.mSize;
+        }
+    }
+
+    if (totalSize <= MAX_DISK_BYTES) {
+        return;
+    }
+
+    // Oldest first. Tiles are rewritten or touched whenever a build uses them, so this is least recently used.
+    std::sort(files.begin(), files.end(), [](const UTileFile& a, const UTileFile& b) { return a.mTime < b.mTime; });
+
+    for (const UTileFile& file : files) {
+        if (totalSize <= MAX_DISK_BYTES) {
+            break;
+        }
+
+        if (std::filesystem::remove(file.mPath, error)) {
+            totalSize -= file.mSize;
+        }
+    }
+}
@@ -18,22 +18,26 @@ void main()\n\
 }\
 ";
 
+// Writes pick ID 0 to the second attachment so paths occlude nodes behind them in single-pass picking.
 const char* default_path_frg_shader_source = "#version 330\n\
 uniform sampler2D spriteTexture;\n\
 in vec4 mPath_color;\n\
 uniform bool pointMode;\n\
+layout (location = 0) out vec4 oPixelColor;\n\
+layout (location = 1) out uint oPixelValue;\n\
 void main()\n\
 {\n\
+    oPixelValue = 0u;\n\
     if(pointMode){\n\
         vec2 p = gl_PointCoord * 2.0 - vec2(1.0);\n\
         float r = sqrt(dot(p,p));\n\
         if(dot(p,p) > r){\n\
             discard;\n\
         } else {\n\
-            gl_FragColor = mPath_color;\n\
+            oPixelColor = mPath_color;\n\
         }\n\
     } else {\n\
-        gl_FragColor = mPath_color;\n\
+        oPixelColor = mPath_color;\n\
     }\n\
 }\
 ";
@@ -148,6 +152,8 @@ CPathRenderer::~CPathRenderer() {
 }
 
 void CPathRenderer::UpdateData() {
+    ZoneScoped;
+
     std::vector<CPathPoint> points, circles;
 
     for (int i = 0; i < mPath.size(); i++) {
@@ -1,4 +1,6 @@
 #include "ui/UViewport.hpp"
+#include "application/AFrameScheduler.hpp"
+#include "application/AOptions.hpp"
 
 #include <glad/glad.h>
 #include <imgui.h>
@@ -10,12 +12,17 @@
 
 constexpr int TEX_COLOR = 0;
 constexpr int TEX_DEPTH = 1;
+constexpr int TEX_PICK = 2;
 
 constexpr float COLOR_RESET[] = { 0.20f, 0.20f, 0.20f, 1.0f };
 constexpr float DEPTH_RESET = 1.0f;
+constexpr uint32_t PICK_RESET = 0;
 
+constexpr uint32_t DRAW_BUFFERS_PICKING[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+constexpr uint32_t DRAW_BUFFERS_COLOR_ONLY[] = { GL_COLOR_ATTACHMENT0, GL_NONE };
 
-UViewport::UViewport(std::string name) : mViewportName(name), mViewportSize(1, 1) {
+
+UViewport::UViewport(std::string name) : mViewportName(name), mViewportSize(1, 1), mLastViewMtx(0.0f), mLastProjMtx(0.0f) {
     CreateFramebuffer();
 }
 
@@ -25,7 +32,7 @@ UViewport::~UViewport() {
 
 void UViewport::Clear() {
     glDeleteFramebuffers(1, &mFBO);
-    glDeleteTextures(2, mTexIds);
+    glDeleteTextures(3, mTexIds);
 }
 
 void UViewport::CreateFramebuffer() {
@@ -33,7 +40,7 @@ void UViewport::CreateFramebuffer() {
     glCreateFramebuffers(1, &mFBO);
 
     // Generate color texture
-    glCreateTextures(GL_TEXTURE_2D, 2, mTexIds);
+    glCreateTextures(GL_TEXTURE_2D, 3, mTexIds);
     glTextureStorage2D(mTexIds[TEX_COLOR], 1, GL_RGB8, GLsizei(mViewportSize.x), GLsizei(mViewportSize.y));
     glTextureParameteri(mTexIds[TEX_COLOR], GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTextureParameteri(mTexIds[TEX_COLOR], GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -41,28 +48,57 @@ void UViewport::CreateFramebuffer() {
     // Generate depth texture
     glTextureStorage2D(mTexIds[TEX_DEPTH], 1, GL_DEPTH_COMPONENT32F, GLsizei(mViewportSize.x), GLsizei(mViewportSize.y));
 
+    // Generate pick ID texture, written alongside color when single-pass picking is enabled
+    glTextureStorage2D(mTexIds[TEX_PICK], 1, GL_R32UI, GLsizei(mViewportSize.x), GLsizei(mViewportSize.y));
+    glTextureParameteri(mTexIds[TEX_PICK], GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(mTexIds[TEX_PICK], GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
     // Attach textures to framebuffer
     glNamedFramebufferTexture(mFBO, GL_COLOR_ATTACHMENT0, mTexIds[TEX_COLOR], 0);
+    glNamedFramebufferTexture(mFBO, GL_COLOR_ATTACHMENT1, mTexIds[TEX_PICK], 0);
     glNamedFramebufferTexture(mFBO, GL_DEPTH_ATTACHMENT, mTexIds[TEX_DEPTH], 0);
 
     // Specify color buffer
     glNamedFramebufferDrawBuffer(mFBO, GL_COLOR_ATTACHMENT0);
+    glNamedFramebufferReadBuffer(mFBO, GL_COLOR_ATTACHMENT1);
 }
 
 void UViewport::ResizeViewport() {
-    ImVec2 contentRegionMax = ImGui::GetWindowContentRegionMax();
-    ImVec2 contentRegionMin = ImGui::GetWindowContentRegionMin();
-    mViewportSize.x = contentRegionMax.x - contentRegionMin.x;
-    mViewportSize.y = contentRegionMax.y - contentRegionMin.y;
-
     ImVec2 windowPos = ImGui::GetCursorScreenPos();
     mViewportPos.x = windowPos.x;
     mViewportPos.y = windowPos.y;
 
+    ImVec2 contentRegionMax = ImGui::GetWindowContentRegionMax();
+    ImVec2 contentRegionMin = ImGui::GetWindowContentRegionMin();
+
+    SetViewportSize({ contentRegionMax.x - contentRegionMin.x, contentRegionMax.y - contentRegionMin.y });
+}
+
+void UViewport::SetViewportSize(glm::vec2 size) {
+    // Recreating the framebuffer throws away the last rendered image, so only do it when we have to.
+    if (size == mViewportSize) {
+        return;
+    }
+
+    mViewportSize = size;
+
     Clear();
     CreateFramebuffer();
 
     mCamera.SetViewportSize(mViewportSize.x, mViewportSize.y);
+    AFrameScheduler::Invalidate(INVALIDATE_RESIZE);
+}
+
+void UViewport::CheckCameraChanged() {
+    glm::mat4 viewMtx = mCamera.GetViewMatrix();
+    glm::mat4 projMtx = mCamera.GetProjectionMatrix();
+
+    if (viewMtx != mLastViewMtx || projMtx != mLastProjMtx) {
+        mLastViewMtx = viewMtx;
+        mLastProjMtx = projMtx;
+
+        AFrameScheduler::Invalidate(INVALIDATE_CAMERA);
+    }
 }
 
 void UViewport::RenderUI(float deltaTime) {
@@ -145,6 +181,8 @@ void UViewport::RenderUI(float deltaTime) {
     }
 
     ResizeViewport();
+    CheckCameraChanged();
+
     ImGui::Image((void*)size_t(mTexIds[TEX_COLOR]), { mViewportSize.x, mViewportSize.y }, { 0, 1 }, { 1, 0 });
 
     ImGui::EndChild();
@@ -159,9 +197,20 @@ void UViewport::BindViewport() {
     glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
     glViewport(0, 0, mViewportSize.x, mViewportSize.y);
 
+    if (OPTIONS.bSinglePassPicking) {
+        glNamedFramebufferDrawBuffers(mFBO, 2, DRAW_BUFFERS_PICKING);
+    }
+    else {
+        glNamedFramebufferDrawBuffers(mFBO, 2, DRAW_BUFFERS_COLOR_ONLY);
+    }
+
     glDepthMask(GL_TRUE);
     glClearBufferfv(GL_COLOR, 0, COLOR_RESET);
     glClearBufferfv(GL_DEPTH, 0, &DEPTH_RESET);
+
+    if (OPTIONS.bSinglePassPicking) {
+        glClearBufferuiv(GL_COLOR, 1, &PICK_RESET);
+    }
 }
 
 void UViewport::UnbindViewport() {
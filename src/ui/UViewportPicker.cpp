@@ -17,6 +17,8 @@ namespace {
     uint32_t mFBO = 0;
     uint32_t mTexObjs[2] = { 0, 0 };
 
+    uint32_t mSharedFBO = 0;
+
     uint32_t mProgram = 0;
     uint32_t mObjectIdUniform = 0;
 
@@ -77,6 +79,13 @@ namespace {
     void DeleteFramebuffer() {
         glDeleteFramebuffers(1, &mFBO);
         glDeleteTextures(2, mTexObjs);
+
+        mFBO = 0;
+        mTexObjs[TEX_DATA] = 0;
+        mTexObjs[TEX_DEPTH] = 0;
+
+        mWidth = 0;
+        mHeight = 0;
     }
 }
 
@@ -86,6 +95,10 @@ void UViewportPicker::CreatePicker(uint32_t width, uint32_t height) {
 }
 
 void UViewportPicker::ResizePicker(uint32_t width, uint32_t height) {
+    if (mSharedFBO != 0 || (width == mWidth && height == mHeight)) {
+        return;
+    }
+
     DeleteFramebuffer();
     CreateFramebuffer(width, height);
 }
@@ -95,6 +108,23 @@ void UViewportPicker::DestroyPicker() {
     glDeleteProgram(mProgram);
 }
 
+void UViewportPicker::SetSharedSource(uint32_t fbo) {
+    if (fbo == mSharedFBO) {
+        return;
+    }
+
+    // The private framebuffer isn't needed while sharing; ResizePicker recreates it if we switch back.
+    if (fbo != 0) {
+        DeleteFramebuffer();
+    }
+
+    mSharedFBO = fbo;
+}
+
+bool UViewportPicker::UsesSharedSource() {
+    return mSharedFBO != 0;
+}
+
 void UViewportPicker::BindBuffer() {
     glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
     glViewport(0, 0, mWidth, mHeight);
@@ -116,8 +146,16 @@ void UViewportPicker::SetIdUniform(uint32_t id) {
 }
 
 uint32_t UViewportPicker::Query(uint32_t pX, uint32_t pY) {
-    glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
-    glViewport(0, 0, mWidth, mHeight);
+    ZoneScoped;
+
+    if (mSharedFBO != 0) {
+        // Read buffer of the shared framebuffer is already set to the ID attachment.
+        glBindFramebuffer(GL_FRAMEBUFFER, mSharedFBO);
+    }
+    else {
+        glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+        glViewport(0, 0, mWidth, mHeight);
+    }
 
     uint32_t pixelValue = 0;
     glReadPixels(pX, pY, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, &pixelValue);
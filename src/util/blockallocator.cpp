@@ -0,0 +1,80 @@
+#include "util/blockallocator.hpp"
+
+
+UBlockAllocator::UBlockAllocator() : mSize(0), mUsed(0) {
+
+}
+
+void UBlockAllocator::Reset(uint32_t size) {
+    mFreeBlocks.clear();
+    if (size != 0) {
+        mFreeBlocks[0] = size;
+    }
+
+    mSize = size;
+    mUsed = 0;
+}
+
+void UBlockAllocator::Grow(uint32_t newSize) {
+    if (newSize <= mSize) {
+        return;
+    }
+
+    uint32_t oldSize = mSize;
+    mSize = newSize;
+
+    // Free() handles merging with a free block at the old end.
+    mUsed += newSize - oldSize;
+    Free(oldSize, newSize - oldSize);
+}
+
+uint32_t UBlockAllocator::Allocate(uint32_t size) {
+    if (size == 0) {
+        return INVALID_OFFSET;
+    }
+
+    for (auto it = mFreeBlocks.begin(); it != mFreeBlocks.end(); ++it) {
+        if (it->second < size) {
+            continue;
+        }
+
+        uint32_t offset = it->first;
+        uint32_t remaining = it->second - size;
+        mFreeBlocks.erase(it);
+
+        if (remaining != 0) {
+            mFreeBlocks[offset + size] = remaining;
+        }
+
+        mUsed += size;
+        return offset;
+    }
+
+    return INVALID_OFFSET;
+}
+
+void UBlockAllocator::Free(uint32_t offset, uint32_t size) {
+    if (offset == INVALID_OFFSET || size == 0) {
+        return;
+    }
+
+    mUsed -= size;
+
+    auto it = mFreeBlocks.emplace(offset, size).first;
+
+    // Merge with the following block...
+    auto next = std::next(it);
+    if (next != mFreeBlocks.end() && it->first + it->second == next->first) {
+        it->second += next->second;
+        mFreeBlocks.erase(next);
+    }
+
+    // ...and the preceding one.
+    if (it != mFreeBlocks.begin()) {
+        auto prev = std::prev(it);
+        if (prev->first + prev->second == it->first) {
+            prev->second += it->second;
+            mFreeBlocks.erase(it);
+        }
+    }
+}
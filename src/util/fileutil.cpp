@@ -2,6 +2,12 @@
 
 #include <fstream>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#endif
+
 std::string UFileUtil::LoadShaderText(std::string shaderName) {
     std::filesystem::path shaderPath = std::filesystem::current_path() / "asset" / "shader" / shaderName;
     if (!std::filesystem::exists(shaderPath)) {
@@ -13,3 +19,61 @@ std::string UFileUtil::LoadShaderText(std::string shaderName) {
     // From https://stackoverflow.com/a/2912614
     return std::string(std::istreambuf_iterator<char>(shaderFile), std::istreambuf_iterator<char>());
 }
+
+std::filesystem::path UFileUtil::GetExecutableDirectory() {
+#ifdef _WIN32
+    wchar_t path[MAX_PATH];
+    DWORD length = GetModuleFileNameW(nullptr, path, MAX_PATH);
+    if (length != 0 && length < MAX_PATH) {
+        return std::filesystem::path(path).parent_path();
+    }
+#else
+    std::error_code error;
+    std::filesystem::path path = std::filesystem::read_symlink("/proc/self/exe", error);
+    if (!error) {
+        return path.parent_path();
+    }
+#endif
+
+    return std::filesystem::current_path();
+}
+
+std::filesystem::path UFileUtil::GetCacheDirectory(const std::string& name) {
+    std::filesystem::path cachePath = std::filesystem::current_path() / "cache" / name;
+
+    std::error_code error;
+    std::filesystem::create_directories(cachePath, error);
+
+    return cachePath;
+}
+
+uint64_t UFileUtil::Hash(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+bool UFileUtil::HashFileContents(const std::filesystem::path& path, uint64_t& hash) {
+    ZoneScoped;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    std::vector<char> buffer(64 * 1024);
+    hash = 0xCBF29CE484222325ull;
+
+    while (file) {
+        file.read(buffer.data(), std::streamsize(buffer.size()));
+        hash = Hash(buffer.data(), size_t(file.gcount()), hash);
+    }
+
+    return file.eof();
+}
@@ -0,0 +1,222 @@
+#include "util/gpuprofiler.hpp"
+#include "application/AFrameScheduler.hpp"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace UGPUProfiler {
+    namespace {
+        // Frames between issuing a query and reading it back. Drivers rarely run more than 2-3 frames ahead.
+        constexpr uint32_t RING_SIZE = 4;
+        constexpr uint32_t HISTORY_SIZE = 64;
+
+        struct UZone {
+            const char* mName = nullptr;
+
+            // A zone may run more than once per frame (e.g. picking on hover and on click), so each ring slot
+            // holds as many queries as the zone needed that frame. They're summed on readback.
+            std::vector<uint32_t> mQueries[RING_SIZE];
+            uint32_t mUsedQueries[RING_SIZE] = {};
+
+            // Some drivers (llvmpipe) report nonsense for the first elapsed-time query of a context.
+            bool bDiscardNext = true;
+
+            float mHistory[HISTORY_SIZE] = {};
+            uint32_t mHistoryCount = 0;
+            uint32_t mHistoryHead = 0;
+        };
+
+        std::vector<UZone> mZones;
+        uint32_t mFrameIndex = 0;
+
+        int32_t mActiveZone = -1;
+        bool bInFrame = false;
+        bool bContinuous = false;
+
+        UZone& GetZone(const char* name) {
+            for (UZone& z : mZones) {
+                if (z.mName == name || std::strcmp(z.mName, name) == 0) {
+                    return z;
+                }
+            }
+
+            mZones.push_back(UZone());
+            mZones.back().mName = name;
+
+            return mZones.back();
+        }
+
+        void ReadBackSlot(UZone& zone, uint32_t slot) {
+            uint32_t used = zone.mUsedQueries[slot];
+            if (used == 0) {
+                return;
+            }
+
+            zone.mUsedQueries[slot] = 0;
+
+            // Queries finish in order, so if the last one is done they all are. If not, drop the sample
+            // rather than waiting on the GPU.
+            int32_t available = 0;
+            glGetQueryObjectiv(zone.mQueries[slot][used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                return;
+            }
+
+            uint64_t totalNs = 0;
+            for (uint32_t i = 0; i < used; i++) {
+                uint64_t ns = 0;
+                glGetQueryObjectui64v(zone.mQueries[slot][i], GL_QUERY_RESULT, &ns);
+                totalNs += ns;
+            }
+
+            if (zone.bDiscardNext) {
+                zone.bDiscardNext = false;
+                return;
+            }
+
+            zone.mHistory[zone.mHistoryHead] = float(totalNs) / 1000000.0f;
+            zone.mHistoryHead = (zone.mHistoryHead + 1) % HISTORY_SIZE;
+            zone.mHistoryCount = std::min(zone.mHistoryCount + 1, HISTORY_SIZE);
+        }
+    }
+}
+
+void UGPUProfiler::Init() {
+    TracyGpuContext;
+}
+
+void UGPUProfiler::Shutdown() {
+    for (UZone& z : mZones) {
+        for (uint32_t i = 0; i < RING_SIZE; i++) {
+            glDeleteQueries(uint32_t(z.mQueries[i].size()), z.mQueries[i].data());
+        }
+    }
+
+    mZones.clear();
+    mActiveZone = -1;
+}
+
+void UGPUProfiler::BeginFrame() {
+    mFrameIndex++;
+    bInFrame = true;
+
+    // Collect whatever was issued the last time this ring slot was used.
+    uint32_t slot = mFrameIndex % RING_SIZE;
+    for (UZone& z : mZones) {
+        ReadBackSlot(z, slot);
+    }
+}
+
+void UGPUProfiler::EndFrame() {
+    if (mActiveZone != -1) {
+        EndZone();
+    }
+
+    bInFrame = false;
+
+    // Keep the passes running so the numbers don't go stale while render-on-demand is idle.
+    if (bContinuous) {
+        AFrameScheduler::Invalidate(INVALIDATE_CAMERA);
+    }
+
+    TracyGpuCollect;
+}
+
+bool UGPUProfiler::BeginZone(const char* name) {
+    if (!bInFrame || mActiveZone != -1) {
+        return false;
+    }
+
+    UZone& zone = GetZone(name);
+    uint32_t slot = mFrameIndex % RING_SIZE;
+
+    if (zone.mUsedQueries[slot] == zone.mQueries[slot].size()) {
+        uint32_t query = 0;
+        glCreateQueries(GL_TIME_ELAPSED, 1, &query);
+        zone.mQueries[slot].push_back(query);
+    }
+
+    glBeginQuery(GL_TIME_ELAPSED, zone.mQueries[slot][zone.mUsedQueries[slot]]);
+    zone.mUsedQueries[slot]++;
+
+    mActiveZone = int32_t(&zone - mZones.data());
+
+    return true;
+}
+
+void UGPUProfiler::EndZone() {
+    if (mActiveZone == -1) {
+        return;
+    }
+
+    glEndQuery(GL_TIME_ELAPSED);
+    mActiveZone = -1;
+}
+
+std::vector<UGPUProfiler::UZoneStats> UGPUProfiler::GetStats() {
+    std::vector<UZoneStats> stats;
+    stats.reserve(mZones.size());
+
+    for (const UZone& z : mZones) {
+        UZoneStats s { z.mName, 0.0f, 0.0f, 0.0f };
+
+        if (z.mHistoryCount != 0) {
+            s.mLastMs = z.mHistory[(z.mHistoryHead + HISTORY_SIZE - 1) % HISTORY_SIZE];
+
+            for (uint32_t i = 0; i < z.mHistoryCount; i++) {
+                s.mAverageMs += z.mHistory[i];
+                s.mMaxMs = std::max(s.mMaxMs, z.mHistory[i]);
+            }
+
+            s.mAverageMs /= float(z.mHistoryCount);
+        }
+
+        stats.push_back(s);
+    }
+
+    return stats;
+}
+
+void UGPUProfiler::RenderOverlay(bool* open) {
+    if (open != nullptr && !*open) {
+        return;
+    }
+
+    ImGuiWindowFlags flags = ImGuiWindowFlags_NoDocking | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing;
+    ImGui::SetNextWindowBgAlpha(0.75f);
+
+    if (ImGui::Begin("GPU Timings", open, flags)) {
+        ImGui::Checkbox("Render continuously", &bContinuous);
+
+        if (ImGui::BeginTable("##gpuZones", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+            ImGui::TableSetupColumn("Pass");
+            ImGui::TableSetupColumn("Last (ms)");
+            ImGui::TableSetupColumn("Avg (ms)");
+            ImGui::TableSetupColumn("Max (ms)");
+            ImGui::TableHeadersRow();
+
+            float totalAvg = 0.0f;
+            for (const UZoneStats& s : GetStats()) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(s.mName);
+                ImGui::TableNextColumn(); ImGui::Text("%.3f", s.mLastMs);
+                ImGui::TableNextColumn(); ImGui::Text("%.3f", s.mAverageMs);
+                ImGui::TableNextColumn(); ImGui::Text("%.3f", s.mMaxMs);
+
+                totalAvg += s.mAverageMs;
+            }
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted("Total");
+            ImGui::TableNextColumn();
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", totalAvg);
+
+            ImGui::EndTable();
+        }
+    }
+
+    ImGui::End();
+}
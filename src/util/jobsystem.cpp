@@ -0,0 +1,170 @@
+#include "util/jobsystem.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+
+namespace UJobSystem {
+    namespace {
+        std::vector<std::thread> mWorkers;
+        std::deque<std::function<void()>> mJobs;
+
+        std::mutex mJobsMutex;
+        std::condition_variable mJobsCondition;
+
+        std::atomic<uint32_t> mPendingJobs = 0;
+        bool bStopping = false;
+
+        struct UParallelForState {
+            std::atomic<uint32_t> mNextChunk = 0;
+            std::atomic<uint32_t> mDoneChunks = 0;
+
+            std::mutex mMutex;
+            std::condition_variable mCondition;
+        };
+
+        void WorkerMain([[maybe_unused]] uint32_t workerIdx) {
+#ifdef TRACY_ENABLE
+            std::string threadName = "Worker " + std::to_string(workerIdx);
+            tracy::SetThreadName(threadName.c_str());
+#endif
+
+            while (true) {
+                std::function<void()> job;
+
+                {
+                    std::unique_lock<std::mutex> lock(mJobsMutex);
+                    mJobsCondition.wait(lock, [] { return bStopping || !mJobs.empty(); });
+
+                    if (bStopping) {
+                        return;
+                    }
+
+                    job = std::move(mJobs.front());
+                    mJobs.pop_front();
+                }
+
+                job();
+                mPendingJobs--;
+            }
+        }
+    }
+}
+
+void UJobSystem::Init(uint32_t threadCount) {
+    if (!mWorkers.empty()) {
+        return;
+    }
+
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+    bStopping = false;
+    for (uint32_t i = 0; i < threadCount; i++) {
+        mWorkers.emplace_back(WorkerMain, i);
+    }
+}
+
+void UJobSystem::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mJobsMutex);
+        bStopping = true;
+
+        mPendingJobs -= uint32_t(mJobs.size());
+        mJobs.clear();
+    }
+
+    mJobsCondition.notify_all();
+
+    for (std::thread& worker : mWorkers) {
+        worker.join();
+    }
+
+    mWorkers.clear();
+}
+
+void UJobSystem::Submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mJobsMutex);
+
+        // Same as jobs that were still queued at shutdown.
+        if (bStopping) {
+            return;
+        }
+
+        if (!mWorkers.empty()) {
+            mPendingJobs++;
+            mJobs.push_back(std::move(job));
+
+            mJobsCondition.notify_one();
+            return;
+        }
+    }
+
+    // No workers were started, so just do the work here.
+    job();
+}
+
+void UJobSystem::ParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t, uint32_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+
+    grainSize = std::max(grainSize, 1u);
+    uint32_t chunkCount = (count + grainSize - 1) / grainSize;
+
+    std::shared_ptr<UParallelForState> state = std::make_shared<UParallelForState>();
+
+    // Helpers that only get to run after everything's done claim no chunk and never touch body.
+    auto runChunks = [state, &body, count, grainSize, chunkCount]() {
+        while (true) {
+            uint32_t chunk = state->mNextChunk++;
+            if (chunk >= chunkCount) {
+                return;
+            }
+
+            uint32_t begin = chunk * grainSize;
+            body(begin, std::min(begin + grainSize, count));
+
+            if (++state->mDoneChunks == chunkCount) {
+                std::lock_guard<std::mutex> lock(state->mMutex);
+                state->mCondition.notify_all();
+            }
+        }
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(mJobsMutex);
+
+        if (!bStopping) {
+            // Ahead of whatever's queued; these are short and someone is waiting on them.
+            uint32_t helperCount = std::min(uint32_t(mWorkers.size()), chunkCount - 1);
+            for (uint32_t i = 0; i < helperCount; i++) {
+                mPendingJobs++;
+                mJobs.push_front(runChunks);
+            }
+
+            if (helperCount != 0) {
+                mJobsCondition.notify_all();
+            }
+        }
+    }
+
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(state->mMutex);
+    state->mCondition.wait(lock, [&] { return state->mDoneChunks == chunkCount; });
+}
+
+uint32_t UJobSystem::GetThreadCount() {
+    return uint32_t(mWorkers.size());
+}
+
+uint32_t UJobSystem::GetPendingJobCount() {
+    return mPendingJobs;
+}
@@ -0,0 +1,113 @@
+#include "util/mappedfile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+UMappedFile::UMappedFile() : mData(nullptr), mSize(0), mFileHandle(INVALID_HANDLE_VALUE), mMappingHandle(nullptr) {
+
+}
+#else
+UMappedFile::UMappedFile() : mData(nullptr), mSize(0) {
+
+}
+#endif
+
+UMappedFile::~UMappedFile() {
+    Close();
+}
+
+#ifdef _WIN32
+bool UMappedFile::Open(const std::filesystem::path& path) {
+    Close();
+
+    mFileHandle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (mFileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(mFileHandle, &size) || size.QuadPart == 0) {
+        Close();
+        return false;
+    }
+
+    mMappingHandle = CreateFileMappingW(mFileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mMappingHandle == nullptr) {
+        Close();
+        return false;
+    }
+
+    mData = static_cast<const uint8_t*>(MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (mData == nullptr) {
+        Close();
+        return false;
+    }
+
+    mSize = size_t(size.QuadPart);
+    return true;
+}
+
+void UMappedFile::Close() {
+    if (mData != nullptr) {
+        UnmapViewOfFile(mData);
+        mData = nullptr;
+    }
+
+    if (mMappingHandle != nullptr) {
+        CloseHandle(mMappingHandle);
+        mMappingHandle = nullptr;
+    }
+
+    if (mFileHandle != INVALID_HANDLE_VALUE) {
+        CloseHandle(mFileHandle);
+        mFileHandle = INVALID_HANDLE_VALUE;
+    }
+
+    mSize = 0;
+}
+#else
+bool UMappedFile::Open(const std::filesystem::path& path) {
+    Close();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    // The mapping keeps its own reference to the file, so the descriptor isn't needed past this.
+    void* data = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    mData = static_cast<const uint8_t*>(data);
+    mSize = size_t(info.st_size);
+    return true;
+}
+
+void UMappedFile::Close() {
+    if (mData != nullptr) {
+        munmap(const_cast<uint8_t*>(mData), mSize);
+        mData = nullptr;
+    }
+
+    mSize = 0;
+}
+#endif
@@ -9,6 +9,8 @@
 constexpr float ONE_THIRD = 0.33333333333f;
 
 void RDR1Util::ExtractTrainPoints(std::filesystem::path wsiPath) {
+	ZoneScoped;
+
 	bStream::CFileStream stream(wsiPath.generic_string(), bStream::Little, bStream::In);
 	std::vector<RDR1Track> tracks;
 
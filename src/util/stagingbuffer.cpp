@@ -0,0 +1,109 @@
+#include "util/stagingbuffer.hpp"
+
+#include <glad/glad.h>
+
+
+namespace {
+    constexpr uint32_t STAGING_ALIGNMENT = 16;
+}
+
+UStagingBuffer::UStagingBuffer() : mBuffer(0), mSize(0), mMappedData(nullptr) {
+
+}
+
+UStagingBuffer::~UStagingBuffer() {
+    Destroy();
+}
+
+bool UStagingBuffer::Create(uint32_t size) {
+    Destroy();
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glCreateBuffers(1, &mBuffer);
+    glNamedBufferStorage(mBuffer, size, nullptr, flags);
+
+    mMappedData = static_cast<uint8_t*>(glMapNamedBufferRange(mBuffer, 0, size, flags));
+    if (mMappedData == nullptr) {
+        glDeleteBuffers(1, &mBuffer);
+        mBuffer = 0;
+
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mAllocatorMutex);
+
+    mSize = size;
+    mAllocator.Reset(size);
+
+    return true;
+}
+
+void UStagingBuffer::Destroy() {
+    for (auto& [fence, allocation] : mRetiredBlocks) {
+        glDeleteSync(static_cast<GLsync>(fence));
+    }
+    mRetiredBlocks.clear();
+
+    {
+        // Stops workers from handing out pointers into the mapping we're about to release.
+        std::lock_guard<std::mutex> lock(mAllocatorMutex);
+
+        mAllocator.Reset(0);
+        mSize = 0;
+        mMappedData = nullptr;
+    }
+
+    if (mBuffer != 0) {
+        glUnmapNamedBuffer(mBuffer);
+        glDeleteBuffers(1, &mBuffer);
+        mBuffer = 0;
+    }
+}
+
+UStagingBuffer::UAllocation UStagingBuffer::Allocate(uint32_t size) {
+    size = (size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+
+    std::lock_guard<std::mutex> lock(mAllocatorMutex);
+
+    uint32_t offset = mAllocator.Allocate(size);
+    if (offset == UBlockAllocator::INVALID_OFFSET) {
+        return UAllocation();
+    }
+
+    UAllocation allocation;
+    allocation.mOffset = offset;
+    allocation.mSize = size;
+    allocation.mData = mMappedData + offset;
+
+    return allocation;
+}
+
+void UStagingBuffer::Retire(const UAllocation& allocation) {
+    if (!allocation.IsValid()) {
+        return;
+    }
+
+    mRetiredBlocks.emplace_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), allocation);
+}
+
+void UStagingBuffer::ReclaimCompleted() {
+    // Fences signal in order, so stop at the first one that hasn't.
+    size_t completed = 0;
+    for (; completed < mRetiredBlocks.size(); completed++) {
+        GLsync fence = static_cast<GLsync>(mRetiredBlocks[completed].first);
+
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            break;
+        }
+
+        glDeleteSync(fence);
+
+        const UAllocation& allocation = mRetiredBlocks[completed].second;
+        std::lock_guard<std::mutex> lock(mAllocatorMutex);
+        mAllocator.Free(allocation.mOffset, allocation.mSize);
+    }
+
+    mRetiredBlocks.erase(mRetiredBlocks.begin(), mRetiredBlocks.begin() + completed);
+}